@@ -35,6 +35,8 @@
 #      proj       - include if you want to use any of the Proj.4 functions
 #      sparsehash - include if you use the sparsehash index
 #      lz4        - include support for LZ4 compression of PBF files
+#      zstd       - include support for ZSTD compression of PBF files and
+#                   zstd-compressed files
 #
 #    You can check for success with something like this:
 #
@@ -122,16 +124,23 @@ if(Osmium_USE_PBF)
         add_definitions(-DOSMIUM_WITH_LZ4)
     endif()
 
+    if(Osmium_USE_ZSTD)
+        find_package(ZSTD REQUIRED)
+        add_definitions(-DOSMIUM_WITH_ZSTD)
+    endif()
+
     list(APPEND OSMIUM_EXTRA_FIND_VARS ZLIB_FOUND Threads_FOUND PROTOZERO_INCLUDE_DIR)
     if(ZLIB_FOUND AND Threads_FOUND AND PROTOZERO_FOUND)
         list(APPEND OSMIUM_PBF_LIBRARIES
             ${ZLIB_LIBRARIES}
             ${LZ4_LIBRARIES}
+            ${ZSTD_LIBRARIES}
             ${CMAKE_THREAD_LIBS_INIT}
         )
         list(APPEND OSMIUM_INCLUDE_DIRS
             ${ZLIB_INCLUDE_DIR}
             ${LZ4_INCLUDE_DIRS}
+            ${ZSTD_INCLUDE_DIRS}
             ${PROTOZERO_INCLUDE_DIR}
         )
     else()
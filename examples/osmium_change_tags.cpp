@@ -11,6 +11,7 @@
   * your own handler
   * access to tags
   * using builders to write data
+  * transforming buffers in parallel
 
   SIMPLER EXAMPLES you might want to understand first:
   * osmium_read
@@ -27,7 +28,6 @@
 #include <exception> // for std::exception
 #include <iostream>  // for std::cout, std::cerr
 #include <string>    // for std::string
-#include <utility>   // for std::move
 
 // Allow any format of input files (XML, PBF, ...)
 #include <osmium/io/any_input.hpp>
@@ -44,6 +44,9 @@
 // For osmium::apply()
 #include <osmium/visitor.hpp>
 
+// For osmium::io::parallel_transform()
+#include <osmium/io/parallel_transform.hpp>
+
 // The functions in this class will be called for each object in the input
 // and will write a (changed) copy of those objects to the given buffer.
 class RewriteHandler : public osmium::handler::Handler {
@@ -170,8 +173,11 @@ int main(int argc, char* argv[]) {
         // is allowed to overwrite a possibly existing file.
         osmium::io::Writer writer{output_file_name, header, osmium::io::overwrite::allow};
 
-        // Read in buffers with OSM objects until there are no more.
-        while (osmium::memory::Buffer input_buffer = reader.read()) {
+        // Read in buffers with OSM objects until there are no more. Each
+        // buffer is changed by the lambda function in one of the threads
+        // of the thread pool. The changed buffers are written out in the
+        // same order as they were read.
+        osmium::io::parallel_transform(reader, [](const osmium::memory::Buffer& input_buffer) {
             // Create an empty buffer with the same size as the input buffer.
             // We'll copy the changed data into output buffer, the changes
             // are small, so the output buffer needs to be about the same size.
@@ -184,9 +190,9 @@ int main(int argc, char* argv[]) {
             RewriteHandler handler{output_buffer};
             osmium::apply(input_buffer, handler);
 
-            // Write out the contents of the output buffer.
-            writer(std::move(output_buffer));
-        }
+            // Return the output buffer, it will be given to the writer.
+            return output_buffer;
+        }, writer);
 
         // Explicitly close the writer and reader. Will throw an exception if
         // there is a problem. If you wait for the destructor to close the writer
@@ -39,10 +39,14 @@ DEALINGS IN THE SOFTWARE.
  * Include this file if you want to read or write compressed OSM XML files.
  *
  * @attention If you include this file, you'll need to link with `libz`
- *            and `libbz2`.
+ *            and `libbz2` (and `libzstd` if OSMIUM_WITH_ZSTD is defined).
  */
 
 #include <osmium/io/bzip2_compression.hpp> // IWYU pragma: export
 #include <osmium/io/gzip_compression.hpp> // IWYU pragma: export
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/zstd_compression.hpp> // IWYU pragma: export
+#endif
+
 #endif // OSMIUM_IO_ANY_COMPRESSION_HPP
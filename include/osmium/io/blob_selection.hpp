@@ -0,0 +1,107 @@
+#ifndef OSMIUM_IO_BLOB_SELECTION_HPP
+#define OSMIUM_IO_BLOB_SELECTION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * A selection of blobs (by their offset in the file) that should
+         * be read from an input file. Give an object of this type to the
+         * Reader constructor to read only those blobs. Usually you'll get
+         * this from the PBFBlobIndex::select() function.
+         *
+         * Currently only the PBF parser supports this, other formats
+         * ignore it and read everything.
+         *
+         * A default constructed blob_selection selects all blobs.
+         */
+        class blob_selection {
+
+            std::vector<uint64_t> m_offsets{};
+            bool m_all = true;
+
+        public:
+
+            /// Select all blobs.
+            blob_selection() = default;
+
+            /**
+             * Select the blobs starting at the given offsets. Offsets
+             * must point to the beginning of a blob, ie. to the 4 bytes
+             * containing the length of the BlobHeader.
+             */
+            explicit blob_selection(std::vector<uint64_t> offsets) :
+                m_offsets(std::move(offsets)),
+                m_all(false) {
+                std::sort(m_offsets.begin(), m_offsets.end());
+                m_offsets.erase(std::unique(m_offsets.begin(), m_offsets.end()), m_offsets.end());
+            }
+
+            /// Are all blobs selected?
+            bool all() const noexcept {
+                return m_all;
+            }
+
+            /// Are no blobs selected?
+            bool empty() const noexcept {
+                return !m_all && m_offsets.empty();
+            }
+
+            /**
+             * The sorted offsets of all selected blobs. Always empty
+             * if all() is true.
+             */
+            const std::vector<uint64_t>& offsets() const noexcept {
+                return m_offsets;
+            }
+
+            /// Is the blob at the given offset selected?
+            bool contains(uint64_t offset) const noexcept {
+                return m_all || std::binary_search(m_offsets.cbegin(), m_offsets.cend(), offset);
+            }
+
+        }; // class blob_selection
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_BLOB_SELECTION_HPP
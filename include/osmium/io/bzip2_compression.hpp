@@ -43,17 +43,22 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
 
 #include <bzlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <system_error>
@@ -292,11 +297,14 @@ namespace osmium {
                     if (bzerror == BZ_STREAM_END) {
                         void* unused = nullptr;
                         int nunused = 0;
-                        if (!feof(m_file.file())) {
-                            ::BZ2_bzReadGetUnused(&bzerror, m_bzfile, &unused, &nunused);
-                            if (bzerror != BZ_OK) {
-                                detail::throw_bzip2_error(m_bzfile, "get unused failed", bzerror);
-                            }
+                        ::BZ2_bzReadGetUnused(&bzerror, m_bzfile, &unused, &nunused);
+                        if (bzerror != BZ_OK) {
+                            detail::throw_bzip2_error(m_bzfile, "get unused failed", bzerror);
+                        }
+                        // Unused data can contain further streams even if
+                        // the underlying file has already been read to the
+                        // end.
+                        if (nunused > 0 || !feof(m_file.file())) {
                             std::string unused_data{static_cast<const char*>(unused), static_cast<std::string::size_type>(nunused)};
                             ::BZ2_bzReadClose(&bzerror, m_bzfile);
                             if (bzerror != BZ_OK) {
@@ -336,6 +344,210 @@ namespace osmium {
 
         }; // class Bzip2Decompressor
 
+        namespace detail {
+
+            /**
+             * Decompresses bzip2 data which can contain several streams
+             * one after the other. The input can be given in pieces.
+             */
+            class bzip2_stream_decoder {
+
+                bz_stream m_bzstream;
+                bool m_in_stream = false;
+
+                void end_stream() noexcept {
+                    if (m_in_stream) {
+                        BZ2_bzDecompressEnd(&m_bzstream);
+                        m_in_stream = false;
+                    }
+                }
+
+            public:
+
+                bzip2_stream_decoder() noexcept :
+                    m_bzstream() {
+                }
+
+                bzip2_stream_decoder(const bzip2_stream_decoder&) = delete;
+                bzip2_stream_decoder& operator=(const bzip2_stream_decoder&) = delete;
+
+                bzip2_stream_decoder(bzip2_stream_decoder&&) = delete;
+                bzip2_stream_decoder& operator=(bzip2_stream_decoder&&) = delete;
+
+                ~bzip2_stream_decoder() noexcept {
+                    end_stream();
+                }
+
+                /// Is the decoder in the middle of a stream?
+                bool in_stream() const noexcept {
+                    return m_in_stream;
+                }
+
+                /**
+                 * Decompress data from the range [next, end) and append it
+                 * to output until all input is used up or the output has
+                 * reached max_output bytes. Updates next to point to the
+                 * first byte not used.
+                 *
+                 * @throws bzip2_error If the data is not valid.
+                 */
+                void decompress(const char*& next, const char* const end, std::string& output, const std::size_t max_output) {
+                    while (output.size() < max_output) {
+                        if (!m_in_stream) {
+                            if (next == end) {
+                                return;
+                            }
+                            m_bzstream = bz_stream();
+                            const int result = BZ2_bzDecompressInit(&m_bzstream, 0, 0);
+                            if (result != BZ_OK) {
+                                throw bzip2_error{"bzip2 error: decompression init failed", result};
+                            }
+                            m_in_stream = true;
+                        }
+
+                        const std::size_t old_size = output.size();
+                        const std::size_t chunk_size = std::min(max_output - old_size, static_cast<std::size_t>(osmium::io::Decompressor::input_buffer_size));
+                        output.resize(old_size + chunk_size);
+
+                        m_bzstream.next_in = const_cast<char*>(next);
+                        m_bzstream.avail_in = static_cast<unsigned int>(std::min(static_cast<std::size_t>(end - next), static_cast<std::size_t>(std::numeric_limits<unsigned int>::max())));
+                        m_bzstream.next_out = &output[old_size];
+                        m_bzstream.avail_out = static_cast<unsigned int>(chunk_size);
+
+                        const int result = BZ2_bzDecompress(&m_bzstream);
+
+                        next = m_bzstream.next_in;
+                        output.resize(old_size + chunk_size - m_bzstream.avail_out);
+
+                        if (result == BZ_STREAM_END) {
+                            end_stream();
+                        } else if (result != BZ_OK) {
+                            end_stream();
+                            throw bzip2_error{"bzip2 error: decompress failed", result};
+                        } else if (next == end && m_bzstream.avail_out != 0) {
+                            return; // need more input
+                        }
+                    }
+                }
+
+                /**
+                 * Called at the end of the input.
+                 *
+                 * @throws bzip2_error If the input ended inside a stream.
+                 */
+                void finish(const char*& /*next*/, const char* const /*end*/, std::string& /*output*/) const {
+                    if (m_in_stream) {
+                        throw bzip2_error{"bzip2 error: unexpected end of stream", BZ_UNEXPECTED_EOF};
+                    }
+                }
+
+            }; // class bzip2_stream_decoder
+
+            /**
+             * Find the start of the next bzip2 stream in the size bytes of
+             * data at or after pos. Every stream starts with "BZh", the
+             * block size ('1' to '9') and the magic number of the first
+             * block. Returns std::string::npos if there is none. A stream
+             * start beginning in the last 9 bytes of the data is not found.
+             */
+            inline std::size_t find_bzip2_stream_start(const char* data, const std::size_t size, std::size_t pos) noexcept {
+                static const char block_magic[] = "\x31\x41\x59\x26\x53\x59";
+                while (pos + 10 <= size) {
+                    const auto* p = static_cast<const char*>(std::memchr(data + pos, 'B', size - 9 - pos));
+                    if (!p) {
+                        break;
+                    }
+                    pos = static_cast<std::size_t>(p - data);
+                    if (p[1] == 'Z' && p[2] == 'h' && p[3] >= '1' && p[3] <= '9' &&
+                        std::memcmp(p + 4, block_magic, 6) == 0) {
+                        return pos;
+                    }
+                    ++pos;
+                }
+                return std::string::npos;
+            }
+
+            /**
+             * Unit finder for the ParallelDecompressor. A unit is a bzip2
+             * stream, it ends where the next stream starts or at the end of
+             * the input.
+             */
+            class bzip2_stream_finder {
+
+                // Offset in the data up to which we have checked for stream
+                // starts.
+                std::size_t m_scan_offset = 0;
+
+                bool m_found_any = false;
+
+            public:
+
+                unit_result operator()(const char* data, const std::size_t size, const bool input_done, std::size_t& unit_size) {
+                    if (size == 0) {
+                        if (!m_found_any) {
+                            throw bzip2_error{"bzip2 error: read failed: empty file", BZ_UNEXPECTED_EOF};
+                        }
+                        return unit_result::ignore_rest;
+                    }
+
+                    std::size_t pos = find_bzip2_stream_start(data, size, std::max(m_scan_offset, static_cast<std::size_t>(1)));
+                    if (pos == std::string::npos) {
+                        if (!input_done) {
+                            if (size > 9) {
+                                m_scan_offset = size - 9;
+                            }
+                            return unit_result::incomplete;
+                        }
+                        pos = size;
+                    }
+
+                    m_scan_offset = 0;
+                    m_found_any = true;
+                    unit_size = pos;
+                    return unit_result::found;
+                }
+
+            }; // class bzip2_stream_finder
+
+        } // namespace detail
+
+        /**
+         * Decompressor for bzip2 files using the threads in the pool.
+         *
+         * Files created by parallel bzip2 compressors (like pbzip2 or
+         * lbzip2) and the OSM planet dumps consist of many bzip2 streams
+         * one after the other. These streams are found by looking for their
+         * headers in the compressed data and decompressed in parallel.
+         *
+         * If a stream gets too large (because the file was created by a
+         * normal bzip2 compressor, which creates only a single stream),
+         * the rest of the file is decompressed in the reading thread.
+         */
+        class Bzip2ParallelDecompressor final : public detail::ParallelDecompressor<detail::bzip2_stream_finder, detail::bzip2_stream_decoder> {
+
+        public:
+
+            enum : std::size_t {
+                default_max_stream_size = 16UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Create decompressor.
+             *
+             * @param fd File descriptor to read from.
+             * @param pool Thread pool to use.
+             * @param max_stream_size If a stream is larger than this (in
+             *        compressed bytes), the rest of the file is
+             *        decompressed in the calling thread.
+             */
+            explicit Bzip2ParallelDecompressor(const int fd,
+                                               osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                               const std::size_t max_stream_size = default_max_stream_size) :
+                ParallelDecompressor(fd, pool, max_stream_size, "bzip2_decompress") {
+            }
+
+        }; // class Bzip2ParallelDecompressor
+
         class Bzip2BufferDecompressor final : public Decompressor {
 
             const char* m_buffer;
@@ -407,8 +619,13 @@ namespace osmium {
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_bzip2_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
-                [](const int fd, const fsync sync) { return new osmium::io::Bzip2Compressor{fd, sync}; },
-                [](const int fd) { return new osmium::io::Bzip2Decompressor{fd}; },
+                [](const int fd, const fsync sync, osmium::thread::Pool& /*pool*/) { return new osmium::io::Bzip2Compressor{fd, sync}; },
+                [](const int fd, osmium::thread::Pool& pool) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_pool_threads_for_bzip2()) {
+                        return new osmium::io::Bzip2ParallelDecompressor{fd, pool};
+                    }
+                    return new osmium::io::Bzip2Decompressor{fd};
+                },
                 [](const char* buffer, const std::size_t size) { return new osmium::io::Bzip2BufferDecompressor{buffer, size}; }
             );
 
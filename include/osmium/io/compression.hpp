@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/file.hpp>
 
 #include <atomic>
@@ -146,10 +147,15 @@ namespace osmium {
             using create_decompressor_type_fd     = std::function<osmium::io::Decompressor*(int)>;
             using create_decompressor_type_buffer = std::function<osmium::io::Decompressor*(const char*, std::size_t)>;
 
+            // Callbacks for compressions using the thread pool of the
+            // Reader or Writer.
+            using create_compressor_type_pool      = std::function<osmium::io::Compressor*(int, fsync, osmium::thread::Pool&)>;
+            using create_decompressor_type_fd_pool = std::function<osmium::io::Decompressor*(int, osmium::thread::Pool&)>;
+
         private:
 
-            using callbacks_type = std::tuple<create_compressor_type,
-                                              create_decompressor_type_fd,
+            using callbacks_type = std::tuple<create_compressor_type_pool,
+                                              create_decompressor_type_fd_pool,
                                               create_decompressor_type_buffer>;
 
             using compression_map_type = std::map<const osmium::io::file_compression, callbacks_type>;
@@ -188,8 +194,8 @@ namespace osmium {
 
             bool register_compression(
                 osmium::io::file_compression compression,
-                const create_compressor_type& create_compressor,
-                const create_decompressor_type_fd& create_decompressor_fd,
+                const create_compressor_type_pool& create_compressor,
+                const create_decompressor_type_fd_pool& create_decompressor_fd,
                 const create_decompressor_type_buffer& create_decompressor_buffer) {
 
                 compression_map_type::value_type cc{compression,
@@ -200,19 +206,54 @@ namespace osmium {
                 return m_callbacks.insert(cc).second;
             }
 
-            template <typename... TArgs>
-            std::unique_ptr<osmium::io::Compressor> create_compressor(const osmium::io::file_compression compression, TArgs&&... args) const {
+            /**
+             * Register a compression with callbacks that don't use the
+             * thread pool.
+             */
+            bool register_compression(
+                osmium::io::file_compression compression,
+                const create_compressor_type& create_compressor,
+                const create_decompressor_type_fd& create_decompressor_fd,
+                const create_decompressor_type_buffer& create_decompressor_buffer) {
+
+                return register_compression(compression,
+                    [create_compressor](const int fd, const fsync sync, osmium::thread::Pool& /*pool*/) {
+                        return create_compressor(fd, sync);
+                    },
+                    [create_decompressor_fd](const int fd, osmium::thread::Pool& /*pool*/) {
+                        return create_decompressor_fd(fd);
+                    },
+                    create_decompressor_buffer);
+            }
+
+            /**
+             * Create compressor writing to fd. Compressors doing their
+             * work in a thread pool use the given pool.
+             */
+            std::unique_ptr<osmium::io::Compressor> create_compressor(const osmium::io::file_compression compression, const int fd, const fsync sync, osmium::thread::Pool& pool) const {
                 const auto callbacks = find_callbacks(compression);
-                return std::unique_ptr<osmium::io::Compressor>(std::get<0>(callbacks)(std::forward<TArgs>(args)...));
+                return std::unique_ptr<osmium::io::Compressor>(std::get<0>(callbacks)(fd, sync, pool));
             }
 
-            std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd) const {
+            std::unique_ptr<osmium::io::Compressor> create_compressor(const osmium::io::file_compression compression, const int fd, const fsync sync) const {
+                return create_compressor(compression, fd, sync, osmium::thread::Pool::default_instance());
+            }
+
+            /**
+             * Create decompressor reading from fd. Decompressors doing
+             * their work in a thread pool use the given pool.
+             */
+            std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd, osmium::thread::Pool& pool) const {
                 const auto callbacks = find_callbacks(compression);
-                auto p = std::unique_ptr<osmium::io::Decompressor>(std::get<1>(callbacks)(fd));
+                auto p = std::unique_ptr<osmium::io::Decompressor>(std::get<1>(callbacks)(fd, pool));
                 p->set_file_size(osmium::file_size(fd));
                 return p;
             }
 
+            std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd) const {
+                return create_decompressor(compression, fd, osmium::thread::Pool::default_instance());
+            }
+
             std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const char* buffer, const std::size_t size) const {
                 const auto callbacks = find_callbacks(compression);
                 return std::unique_ptr<osmium::io::Decompressor>(std::get<2>(callbacks)(buffer, size));
@@ -0,0 +1,130 @@
+#ifndef OSMIUM_IO_DETAIL_BUFFER_POOL_HPP
+#define OSMIUM_IO_DETAIL_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * A pool of buffers that are not needed any more and can be
+             * re-used. This allows parsers to write into buffers that are
+             * already allocated instead of allocating new memory for every
+             * buffer.
+             *
+             * The pool is bounded, if it is full, additional buffers given
+             * back will be freed. All functions are thread-safe.
+             */
+            class BufferPool {
+
+                mutable std::mutex m_mutex;
+                std::vector<osmium::memory::Buffer> m_buffers;
+                std::size_t m_max_buffers;
+
+            public:
+
+                enum {
+                    default_max_buffers = 32
+                };
+
+                explicit BufferPool(std::size_t max_buffers = default_max_buffers) :
+                    m_max_buffers(max_buffers) {
+                }
+
+                BufferPool(const BufferPool&) = delete;
+                BufferPool& operator=(const BufferPool&) = delete;
+
+                BufferPool(BufferPool&&) = delete;
+                BufferPool& operator=(BufferPool&&) = delete;
+
+                ~BufferPool() noexcept = default;
+
+                /**
+                 * Get an empty buffer with auto_grow::internal policy. If
+                 * there is a buffer in the pool it is returned (regardless
+                 * of its size), otherwise a new buffer with the given
+                 * capacity is created.
+                 */
+                osmium::memory::Buffer get(std::size_t capacity) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        if (!m_buffers.empty()) {
+                            osmium::memory::Buffer buffer{std::move(m_buffers.back())};
+                            m_buffers.pop_back();
+                            return buffer;
+                        }
+                    }
+                    return osmium::memory::Buffer{capacity, osmium::memory::Buffer::auto_grow::internal};
+                }
+
+                /**
+                 * Give a buffer back to the pool. Its content is discarded.
+                 * Buffers that can not be re-used (for instance invalid
+                 * buffers) are ignored.
+                 */
+                void put(osmium::memory::Buffer&& buffer) {
+                    if (!buffer.reset_for_reuse(osmium::memory::Buffer::auto_grow::internal)) {
+                        return;
+                    }
+
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_buffers.size() < m_max_buffers) {
+                        m_buffers.push_back(std::move(buffer));
+                    }
+                }
+
+                /// The number of buffers currently in the pool.
+                std::size_t size() const {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_buffers.size();
+                }
+
+            }; // class BufferPool
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_BUFFER_POOL_HPP
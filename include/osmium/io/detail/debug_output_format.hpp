@@ -290,10 +290,16 @@ namespace osmium {
                     }
                 }
 
+                void write_coordinates(const osmium::Location& location) {
+                    append_location_coordinate(*m_out, location.x());
+                    *m_out += ',';
+                    append_location_coordinate(*m_out, location.y());
+                }
+
                 void write_location(const osmium::Location& location) {
                     write_fieldname("lon/lat");
                     *m_out += "  ";
-                    location.as_string_without_check(std::back_inserter(*m_out));
+                    write_coordinates(location);
                     if (!location.valid()) {
                         write_error(" INVALID LOCATION!");
                     }
@@ -309,9 +315,9 @@ namespace osmium {
                     }
                     const auto& bl = box.bottom_left();
                     const auto& tr = box.top_right();
-                    bl.as_string_without_check(std::back_inserter(*m_out));
+                    write_coordinates(bl);
                     *m_out += ' ';
-                    tr.as_string_without_check(std::back_inserter(*m_out));
+                    write_coordinates(tr);
                     if (!box.valid()) {
                         write_error(" INVALID BOX!");
                     }
@@ -400,7 +406,7 @@ namespace osmium {
                         output_formatted("%10lld", static_cast<long long>(node_ref.ref())); // NOLINT(google-runtime-int)
                         if (node_ref.location().valid()) {
                             *m_out += " (";
-                            node_ref.location().as_string(std::back_inserter(*m_out));
+                            write_coordinates(node_ref.location());
                             *m_out += ')';
                         }
                         *m_out += '\n';
@@ -533,7 +539,7 @@ namespace osmium {
 
             public:
 
-                DebugOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                DebugOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue) {
                     m_options.add_metadata   = osmium::metadata_options{file.get("add_metadata")};
                     m_options.use_color      = file.is_true("color");
@@ -583,7 +589,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    submit_to_queue(m_pool, m_output_queue, DebugOutputBlock{std::move(buffer), m_options});
                 }
 
             }; // class DebugOutputFormat
@@ -591,7 +597,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_debug_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::debug,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::DebugOutputFormat(pool, file, output_queue);
             });
 
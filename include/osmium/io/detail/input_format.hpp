@@ -33,16 +33,22 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/blob_selection.hpp>
+#include <osmium/io/detail/buffer_pool.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
@@ -56,23 +62,99 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * If the complete input data is available in memory (because
+             * the input file was memory-mapped or the user gave us a
+             * buffer), parsers that support this can read it from here
+             * directly instead of getting copies of it through the input
+             * queue.
+             */
+            class DirectInput {
+
+                const char* m_data = nullptr;
+                std::size_t m_size = 0;
+
+                // updated by the parser thread, read by the main thread
+                std::atomic<std::size_t> m_offset{0};
+
+                // set by the main thread, read by the parser thread
+                std::atomic<bool> m_done{false};
+
+            public:
+
+                DirectInput() noexcept = default;
+
+                DirectInput(const DirectInput&) = delete;
+                DirectInput& operator=(const DirectInput&) = delete;
+
+                DirectInput(DirectInput&&) = delete;
+                DirectInput& operator=(DirectInput&&) = delete;
+
+                ~DirectInput() noexcept = default;
+
+                void set_data(const char* data, const std::size_t size) noexcept {
+                    m_data = data;
+                    m_size = size;
+                }
+
+                bool valid() const noexcept {
+                    return m_data != nullptr;
+                }
+
+                const char* data() const noexcept {
+                    return m_data;
+                }
+
+                std::size_t size() const noexcept {
+                    return m_size;
+                }
+
+                std::size_t offset() const noexcept {
+                    return m_offset;
+                }
+
+                void set_offset(const std::size_t offset) noexcept {
+                    m_offset = offset;
+                }
+
+                /// Tell the parser to stop reading.
+                void stop() noexcept {
+                    m_done = true;
+                }
+
+                bool stopped() const noexcept {
+                    return m_done;
+                }
+
+            }; // class DirectInput
+
             struct parser_arguments {
                 osmium::thread::Pool& pool;
-                future_string_queue_type& input_queue;
-                future_buffer_queue_type& output_queue;
+                string_queue_type& input_queue;
+                buffer_queue_type& output_queue;
                 std::promise<osmium::io::Header>& header_promise;
                 osmium::osm_entity_bits::type read_which_entities;
                 osmium::io::read_meta read_metadata;
+                DirectInput* direct_input; // nullptr if not available
+                const osmium::io::blob_selection* blobs; // nullptr if all blobs should be read
+                BufferPool* buffer_pool; // nullptr if not available
+                const osmium::io::read_filter* filter; // nullptr if all objects should be read
+                reader_counters* counters; // nullptr if not available
             };
 
             class Parser {
 
                 osmium::thread::Pool& m_pool;
-                future_buffer_queue_type& m_output_queue;
+                buffer_queue_type& m_output_queue;
                 std::promise<osmium::io::Header>& m_header_promise;
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                DirectInput* m_direct_input;
+                const osmium::io::blob_selection* m_blobs;
+                BufferPool* m_buffer_pool;
+                const osmium::io::read_filter* m_filter;
+                reader_counters* m_counters;
                 bool m_header_is_done;
 
             protected:
@@ -81,6 +163,48 @@ namespace osmium {
                     return m_pool;
                 }
 
+                /**
+                 * Get the input data if it is available in memory as a
+                 * whole. Returns nullptr otherwise. In that case the data
+                 * has to be read with get_input().
+                 */
+                DirectInput* direct_input() const noexcept {
+                    return m_direct_input;
+                }
+
+                /**
+                 * Get the selection of blobs that should be read. Returns
+                 * nullptr if all blobs should be read. Parsers for formats
+                 * that are not organized in blobs ignore this.
+                 */
+                const osmium::io::blob_selection* blobs() const noexcept {
+                    return m_blobs;
+                }
+
+                /**
+                 * Get the pool of buffers that can be re-used. Returns
+                 * nullptr if there is none.
+                 */
+                BufferPool* buffer_pool() const noexcept {
+                    return m_buffer_pool;
+                }
+
+                /**
+                 * Get the filter objects have to match to be read. Returns
+                 * nullptr if all objects should be read.
+                 */
+                const osmium::io::read_filter* filter() const noexcept {
+                    return m_filter;
+                }
+
+                /**
+                 * Get the counters for the reader statistics. Returns
+                 * nullptr if there are none.
+                 */
+                reader_counters* counters() const noexcept {
+                    return m_counters;
+                }
+
                 osmium::osm_entity_bits::type read_types() const noexcept {
                     return m_read_which_entities;
                 }
@@ -108,14 +232,20 @@ namespace osmium {
                 }
 
                 /**
-                 * Wrap the buffer into a future and add it to the output queue.
+                 * Add the buffer to the output queue.
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
                     add_to_queue(m_output_queue, std::move(buffer));
                 }
 
-                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
-                    m_output_queue.push(std::move(future));
+                /**
+                 * Run the function returning a buffer in the thread pool
+                 * and add its result to the output queue (keeping the
+                 * order).
+                 */
+                template <typename TFunction>
+                void submit_to_output_queue(TFunction&& function) {
+                    submit_to_queue(m_pool, m_output_queue, std::forward<TFunction>(function));
                 }
 
             public:
@@ -127,6 +257,11 @@ namespace osmium {
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
                     m_read_metadata(args.read_metadata),
+                    m_direct_input(args.direct_input),
+                    m_blobs(args.blobs),
+                    m_buffer_pool(args.buffer_pool),
+                    m_filter(args.filter),
+                    m_counters(args.counters),
                     m_header_is_done(false) {
                 }
 
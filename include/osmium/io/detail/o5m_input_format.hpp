@@ -555,21 +555,21 @@ namespace osmium {
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::node) {
                                         decode_node(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        commit_if_wanted(m_buffer, filter());
                                     }
                                     break;
                                 case dataset_type::way:
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::way) {
                                         decode_way(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        commit_if_wanted(m_buffer, filter());
                                     }
                                     break;
                                 case dataset_type::relation:
                                     mark_header_as_done();
                                     if (read_types() & osmium::osm_entity_bits::relation) {
                                         decode_relation(m_data, m_data + length);
-                                        m_buffer.commit();
+                                        commit_if_wanted(m_buffer, filter());
                                     }
                                     break;
                                 case dataset_type::bounding_box:
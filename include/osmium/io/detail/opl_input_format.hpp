@@ -33,13 +33,19 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/detail/buffer_pool.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/opl_parser_functions.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/trace.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -98,6 +104,105 @@ namespace osmium {
                 }
             }
 
+            // Split data coming in blocks into chunks of at least
+            // min_chunk_size bytes (except for the last one) ending at a
+            // line boundary and feed them to the worker. Like line_by_line()
+            // this is a standalone template function to be better testable.
+            template <typename T>
+            void chunk_by_lines(T& worker, const std::size_t min_chunk_size) {
+                std::string chunk;
+
+                while (!worker.input_done()) {
+                    if (chunk.empty()) {
+                        chunk = worker.get_input();
+                    } else {
+                        chunk.append(worker.get_input());
+                    }
+
+                    if (chunk.size() < min_chunk_size) {
+                        continue;
+                    }
+
+                    const auto pos = chunk.find_last_of("\n\r");
+                    if (pos == std::string::npos) {
+                        continue;
+                    }
+
+                    std::string rest{chunk, pos + 1};
+                    chunk.resize(pos + 1);
+                    worker.parse_chunk(std::move(chunk));
+                    chunk = std::move(rest);
+                }
+
+                if (!chunk.empty()) {
+                    worker.parse_chunk(std::move(chunk));
+                }
+            }
+
+            // Count the lines line_by_line() would hand to the parser, ie.
+            // all non-empty lines.
+            inline uint64_t opl_count_lines(const std::string& data) noexcept {
+                uint64_t count = 0;
+                bool in_line = false;
+                for (const char c : data) {
+                    if (c == '\n' || c == '\r') {
+                        if (in_line) {
+                            ++count;
+                            in_line = false;
+                        }
+                    } else {
+                        in_line = true;
+                    }
+                }
+                return in_line ? count + 1 : count;
+            }
+
+            // Task parsing a chunk of complete lines of OPL data into a
+            // buffer.
+            class OPLChunkParser {
+
+                std::string m_data;
+                osmium::memory::Buffer m_buffer;
+                uint64_t m_line_count;
+                osmium::osm_entity_bits::type m_read_types;
+                const osmium::io::read_filter* m_filter;
+
+            public:
+
+                OPLChunkParser(std::string&& data, osmium::memory::Buffer&& buffer, const uint64_t first_line, const osmium::osm_entity_bits::type read_types, const osmium::io::read_filter* filter) :
+                    m_data(std::move(data)),
+                    m_buffer(std::move(buffer)),
+                    m_line_count(first_line),
+                    m_read_types(read_types),
+                    m_filter(filter) {
+                }
+
+                bool input_done() const noexcept {
+                    return m_data.empty();
+                }
+
+                // Hands out all data at once and leaves m_data empty, so
+                // that input_done() is true afterwards.
+                std::string get_input() noexcept {
+                    std::string data;
+                    using std::swap;
+                    swap(data, m_data);
+                    return data;
+                }
+
+                void parse_line(const char* data) {
+                    opl_parse_line(m_line_count, data, m_buffer, m_read_types, m_filter);
+                    ++m_line_count;
+                }
+
+                osmium::memory::Buffer operator()() {
+                    OSMIUM_TRACE_SCOPE("parse_opl_chunk");
+                    line_by_line(*this);
+                    return std::move(m_buffer);
+                }
+
+            }; // class OPLChunkParser
+
             class OPLParser final : public Parser {
 
                 enum {
@@ -109,8 +214,19 @@ namespace osmium {
 
                 uint64_t m_line_count = 0;
 
+                osmium::memory::Buffer get_buffer() {
+                    if (buffer_pool()) {
+                        return buffer_pool()->get(initial_buffer_size);
+                    }
+                    return osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                }
+
             public:
 
+                enum : std::size_t {
+                    min_chunk_size = 1024UL * 1024UL
+                };
+
                 explicit OPLParser(parser_arguments& args) :
                     Parser(args) {
                     set_header_value(osmium::io::Header{});
@@ -125,7 +241,7 @@ namespace osmium {
                 ~OPLParser() noexcept override = default;
 
                 void parse_line(const char* data) {
-                    if (opl_parse_line(m_line_count, data, m_buffer, read_types())) {
+                    if (opl_parse_line(m_line_count, data, m_buffer, read_types(), filter())) {
                         if (m_buffer.has_nested_buffers()) {
                             std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
                             send_to_output_queue(std::move(*buffer_ptr));
@@ -134,9 +250,21 @@ namespace osmium {
                     ++m_line_count;
                 }
 
+                // Parse a chunk of complete lines in the thread pool.
+                void parse_chunk(std::string&& chunk) {
+                    const uint64_t num_lines = opl_count_lines(chunk);
+                    submit_to_output_queue(OPLChunkParser{std::move(chunk), get_buffer(), m_line_count, read_types(), filter()});
+                    m_line_count += num_lines;
+                }
+
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_opl_in");
 
+                    if (osmium::config::use_pool_threads_for_opl_parsing()) {
+                        chunk_by_lines(*this, min_chunk_size);
+                        return;
+                    }
+
                     line_by_line(*this);
 
                     if (m_buffer.committed() > 0) {
@@ -57,7 +57,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/visitor.hpp>
 
 #include <cstdint>
-#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -156,12 +155,12 @@ namespace osmium {
                     *m_out += ' ';
                     *m_out += x;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.x());
+                        append_location_coordinate(*m_out, location.x());
                     }
                     *m_out += ' ';
                     *m_out += y;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.y());
+                        append_location_coordinate(*m_out, location.y());
                     }
                 }
 
@@ -199,8 +198,14 @@ namespace osmium {
                 void write_field_ref(const osmium::NodeRef& node_ref) {
                     write_field_int('n', node_ref.ref());
                     *m_out += 'x';
-                    if (node_ref.location()) {
-                        node_ref.location().as_string(std::back_inserter(*m_out), 'y');
+                    const auto& location = node_ref.location();
+                    if (location) {
+                        if (!location.valid()) {
+                            throw osmium::invalid_location{"invalid location"};
+                        }
+                        append_location_coordinate(*m_out, location.x());
+                        *m_out += 'y';
+                        append_location_coordinate(*m_out, location.y());
                     } else {
                         *m_out += 'y';
                     }
@@ -287,7 +292,7 @@ namespace osmium {
 
             public:
 
-                OPLOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                OPLOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue) {
                     m_options.add_metadata      = osmium::metadata_options{file.get("add_metadata")};
                     m_options.locations_on_ways = file.is_true("locations_on_ways");
@@ -295,7 +300,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    submit_to_queue(m_pool, m_output_queue, OPLOutputBlock{std::move(buffer), m_options});
                 }
 
             }; // class OPLOutputFormat
@@ -303,7 +308,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_opl_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::opl,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::OPLOutputFormat(pool, file, output_queue);
             });
 
@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/changeset.hpp>
@@ -857,7 +858,8 @@ namespace osmium {
             inline bool opl_parse_line(uint64_t line_count,
                                        const char* data,
                                        osmium::memory::Buffer& buffer,
-                                       osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all) {
+                                       osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all,
+                                       const osmium::io::read_filter* filter = nullptr) {
                 const char* start_of_line = data;
                 try {
                     switch (*data) {
@@ -871,7 +873,7 @@ namespace osmium {
                             if (read_types & osmium::osm_entity_bits::node) {
                                 ++data;
                                 opl_parse_node(&data, buffer);
-                                buffer.commit();
+                                commit_if_wanted(buffer, filter);
                                 return true;
                             }
                             break;
@@ -879,7 +881,7 @@ namespace osmium {
                             if (read_types & osmium::osm_entity_bits::way) {
                                 ++data;
                                 opl_parse_way(&data, buffer);
-                                buffer.commit();
+                                commit_if_wanted(buffer, filter);
                                 return true;
                             }
                             break;
@@ -887,7 +889,7 @@ namespace osmium {
                             if (read_types & osmium::osm_entity_bits::relation) {
                                 ++data;
                                 opl_parse_relation(&data, buffer);
-                                buffer.commit();
+                                commit_if_wanted(buffer, filter);
                                 return true;
                             }
                             break;
@@ -895,7 +897,7 @@ namespace osmium {
                             if (read_types & osmium::osm_entity_bits::changeset) {
                                 ++data;
                                 opl_parse_changeset(&data, buffer);
-                                buffer.commit();
+                                commit_if_wanted(buffer, filter);
                                 return true;
                             }
                             break;
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/handler.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
@@ -71,28 +72,8 @@ namespace osmium {
                     m_out(std::make_shared<std::string>()) {
                 }
 
-                // Simple function to convert integer to string. This is much
-                // faster than using sprintf, but could be further optimized.
-                // See https://github.com/miloyip/itoa-benchmark .
                 void output_int(int64_t value) {
-                    if (value < 0) {
-                        *m_out += '-';
-                        value = -value;
-                    }
-
-                    char temp[20];
-                    char *t = temp;
-                    do {
-                        *t++ = static_cast<char>(value % 10) + '0'; // NOLINT(bugprone-narrowing-conversions, cppcoreguidelines-narrowing-conversions)
-                        value /= 10;
-                    } while (value > 0);
-
-                    const auto old_size = m_out->size();
-                    m_out->resize(old_size + (t - temp));
-                    char* data = &(*m_out)[old_size];
-                    do {
-                        *data++ = *--t;
-                    } while (t != temp);
+                    append_int(*m_out, value);
                 }
 
             }; // class OutputBlock;
@@ -109,11 +90,10 @@ namespace osmium {
             protected:
 
                 osmium::thread::Pool& m_pool;
-                future_string_queue_type& m_output_queue;
+                string_queue_type& m_output_queue;
 
                 /**
-                 * Wrap the string into a future and add it to the output
-                 * queue.
+                 * Add the string to the output queue.
                  */
                 void send_to_output_queue(std::string&& data) {
                     add_to_queue(m_output_queue, std::move(data));
@@ -121,7 +101,7 @@ namespace osmium {
 
             public:
 
-                OutputFormat(osmium::thread::Pool& pool, future_string_queue_type& output_queue) noexcept :
+                OutputFormat(osmium::thread::Pool& pool, string_queue_type& output_queue) noexcept :
                     m_pool(pool),
                     m_output_queue(output_queue) {
                 }
@@ -139,6 +119,14 @@ namespace osmium {
 
                 virtual void write_buffer(osmium::memory::Buffer&& /*buffer*/) = 0;
 
+                /**
+                 * Write a raw data blob (see PBFRawBlobReader) unchanged to
+                 * the output. This is only supported by the PBF format.
+                 */
+                virtual void write_raw_blob(std::string&& /*data*/) {
+                    throw io_error{"Writing raw blobs is only supported for PBF files"};
+                }
+
                 virtual void write_end() {
                 }
 
@@ -155,7 +143,7 @@ namespace osmium {
 
             public:
 
-                using create_output_type = std::function<osmium::io::detail::OutputFormat*(osmium::thread::Pool&, const osmium::io::File&, future_string_queue_type&)>;
+                using create_output_type = std::function<osmium::io::detail::OutputFormat*(osmium::thread::Pool&, const osmium::io::File&, string_queue_type&)>;
 
             private:
 
@@ -183,7 +171,7 @@ namespace osmium {
                     return true;
                 }
 
-                std::unique_ptr<osmium::io::detail::OutputFormat> create_output(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) const {
+                std::unique_ptr<osmium::io::detail::OutputFormat> create_output(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) const {
                     const auto func = callbacks(file.format());
                     if (func) {
                         return std::unique_ptr<osmium::io::detail::OutputFormat>((func)(pool, file, output_queue));
@@ -203,7 +191,7 @@ namespace osmium {
 
             public:
 
-                BlackholeOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, future_string_queue_type& output_queue) :
+                BlackholeOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue) {
                 }
 
@@ -223,7 +211,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_blackhole_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::blackhole,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::BlackholeOutputFormat(pool, file, output_queue);
             });
 
@@ -0,0 +1,466 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_COMPRESSION_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_COMPRESSION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/trace.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Task compressing one block of data.
+            template <typename TBlockCompressor>
+            class compress_block {
+
+                TBlockCompressor m_compressor;
+                std::string m_data;
+
+            public:
+
+                compress_block(const TBlockCompressor& compressor, std::string&& data) :
+                    m_compressor(compressor),
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    OSMIUM_TRACE_SCOPE("compress_block");
+                    return m_compressor(m_data);
+                }
+
+            }; // class compress_block
+
+            /**
+             * Compressor using the threads in the pool.
+             *
+             * The data is split into blocks of (at least) block_size bytes
+             * which are compressed independently and written in order.
+             *
+             * TBlockCompressor is a copyable function object getting the
+             * data of a block as `const std::string&` and returning the
+             * compressed data. The result for each block (even an empty
+             * one) must be a complete compressed file on its own.
+             */
+            template <typename TBlockCompressor>
+            class ParallelCompressor : public Compressor {
+
+                std::size_t m_file_size = 0;
+                int m_fd;
+                osmium::thread::Pool& m_pool;
+                TBlockCompressor m_block_compressor;
+                std::size_t m_block_size;
+                std::size_t m_max_results;
+                std::string m_pending{};
+                string_queue_type m_results;
+                bool m_written = false;
+
+                void submit() {
+                    submit_to_queue(m_pool, m_results, compress_block<TBlockCompressor>{m_block_compressor, std::move(m_pending)});
+                    m_pending.clear();
+                    m_written = true;
+                }
+
+                void write_front() {
+                    const std::string data{m_results.pop()};
+                    reliable_write(m_fd, data.data(), data.size());
+                }
+
+            public:
+
+                /**
+                 * Create compressor.
+                 *
+                 * @param fd File descriptor to write to.
+                 * @param sync Should the file be synced on close?
+                 * @param pool Thread pool to use.
+                 * @param block_compressor Function compressing one block.
+                 * @param block_size Minimum size of the uncompressed data
+                 *        in each block.
+                 * @param queue_name Name of the queue for the results
+                 *        (see osmium::config::get_max_queue_size()).
+                 */
+                ParallelCompressor(const int fd,
+                                   const fsync sync,
+                                   osmium::thread::Pool& pool,
+                                   const TBlockCompressor& block_compressor,
+                                   const std::size_t block_size,
+                                   const char* queue_name) :
+                    Compressor(sync),
+                    m_fd(fd),
+                    m_pool(pool),
+                    m_block_compressor(block_compressor),
+                    m_block_size(block_size),
+                    m_max_results(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_results(m_max_results + 1, queue_name) {
+                    if (fd < 0) {
+                        throw std::system_error{EBADF, std::system_category(), "invalid file descriptor"};
+                    }
+                }
+
+                ParallelCompressor(const ParallelCompressor&) = delete;
+                ParallelCompressor& operator=(const ParallelCompressor&) = delete;
+
+                ParallelCompressor(ParallelCompressor&&) = delete;
+                ParallelCompressor& operator=(ParallelCompressor&&) = delete;
+
+                ~ParallelCompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void write(const std::string& data) override {
+                    assert(m_fd >= 0);
+                    m_pending += data;
+                    if (m_pending.size() >= m_block_size) {
+                        submit();
+                        while (m_results.size() > m_max_results) {
+                            write_front();
+                        }
+                    }
+                }
+
+                void close() override {
+                    if (m_fd < 0) {
+                        return;
+                    }
+
+                    try {
+                        // Always write at least one block, so that even an
+                        // empty file is a valid compressed file.
+                        if (!m_pending.empty() || !m_written) {
+                            submit();
+                        }
+                        while (!m_results.empty()) {
+                            write_front();
+                        }
+                    } catch (...) {
+                        // Wait for all tasks, they might still use the pool.
+                        drain_queue(m_results);
+                        if (m_fd != 1) {
+                            reliable_close(m_fd);
+                        }
+                        m_fd = -1;
+                        throw;
+                    }
+
+                    const int fd = m_fd;
+                    m_fd = -1;
+
+                    // Do not sync or close stdout
+                    if (fd == 1) {
+                        return;
+                    }
+
+                    m_file_size = osmium::file_size(fd);
+
+                    if (do_fsync()) {
+                        reliable_fsync(fd);
+                    }
+                    reliable_close(fd);
+                }
+
+                std::size_t file_size() const override {
+                    return m_file_size;
+                }
+
+            }; // class ParallelCompressor
+
+            /**
+             * What the unit finder of the ParallelDecompressor found at the
+             * start of the remaining input.
+             */
+            enum class unit_result {
+                found,       ///< a complete unit of the returned size
+                incomplete,  ///< the start of a unit, more input is needed
+                not_found,   ///< no unit, decompress the rest sequentially
+                ignore_rest  ///< the rest of the input is to be ignored
+            };
+
+            // Task decompressing one unit with its own stream decoder.
+            template <typename TStreamDecoder>
+            class decompress_unit {
+
+                std::string m_data;
+
+            public:
+
+                explicit decompress_unit(std::string&& data) noexcept :
+                    m_data(std::move(data)) {
+                }
+
+                std::string operator()() const {
+                    OSMIUM_TRACE_SCOPE("decompress_unit");
+                    std::string output;
+                    TStreamDecoder decoder;
+                    const char* next = m_data.data();
+                    const char* const end = m_data.data() + m_data.size();
+                    decoder.decompress(next, end, output, std::numeric_limits<std::size_t>::max());
+                    decoder.finish(next, end, output);
+                    return output;
+                }
+
+            }; // class decompress_unit
+
+            /**
+             * Decompressor using the threads in the pool.
+             *
+             * Many compressed files consist of units (like bzip2 streams,
+             * gzip members, or zstd frames) which can be decompressed
+             * independently. Complete units are found in the input using
+             * the TUnitFinder and decompressed in parallel. If the input
+             * can't be split into units or a unit gets larger than
+             * max_unit_size (in compressed bytes), the rest of the input is
+             * decompressed in the reading thread with the TStreamDecoder.
+             *
+             * TUnitFinder is a default constructible function object called
+             * with the remaining input as (const char* data, std::size_t
+             * size, bool input_done, std::size_t& unit_size) returning a
+             * unit_result. If it returns unit_result::found, it sets
+             * unit_size. It is called with size 0 only at the end of the
+             * input.
+             *
+             * TStreamDecoder is default constructible and has the member
+             * functions
+             * - decompress(const char*& next, const char* end,
+             *   std::string& output, std::size_t max_output): Decompress
+             *   data from [next, end) and append it to output until all
+             *   input is used or output has reached max_output bytes.
+             *   Updates next to point to the first byte not used.
+             * - finish(const char*& next, const char* end,
+             *   std::string& output): Called at the end of the input with
+             *   the input not used by decompress(). Throws if the input
+             *   ended in the middle of a unit.
+             * A new TStreamDecoder is used for every unit decompressed in
+             * the pool.
+             */
+            template <typename TUnitFinder, typename TStreamDecoder>
+            class ParallelDecompressor : public Decompressor {
+
+                enum class mode {
+                    parallel,
+                    sequential,
+                    done
+                };
+
+                int m_fd;
+                osmium::thread::Pool& m_pool;
+                std::size_t m_max_results;
+                std::size_t m_max_unit_size;
+
+                // Data read from the file. The part before m_start has already
+                // been used.
+                std::string m_input{};
+                std::size_t m_start = 0;
+
+                std::size_t m_file_offset = 0;
+                bool m_input_done = false;
+
+                // Decompressed data in the order of the input.
+                string_queue_type m_results;
+
+                mode m_mode = mode::parallel;
+                TUnitFinder m_find_unit{};
+
+                // Used when decompressing in the reading thread.
+                TStreamDecoder m_decoder{};
+
+                std::size_t available() const noexcept {
+                    return m_input.size() - m_start;
+                }
+
+                void read_input() {
+                    m_input.erase(0, m_start);
+                    m_start = 0;
+
+                    const std::size_t old_size = m_input.size();
+                    m_input.resize(old_size + osmium::io::Decompressor::input_buffer_size);
+                    const auto nread = reliable_read(m_fd, &m_input[old_size], osmium::io::Decompressor::input_buffer_size);
+                    m_input.resize(old_size + static_cast<std::size_t>(nread));
+
+                    m_file_offset += static_cast<std::size_t>(nread);
+                    set_offset(m_file_offset);
+
+                    if (nread == 0) {
+                        m_input_done = true;
+                    }
+                }
+
+                // Read input and submit units until enough work is queued.
+                void fill() {
+                    while (m_mode == mode::parallel && m_results.size() < m_max_results) {
+                        if (available() == 0 && !m_input_done) {
+                            read_input();
+                            continue;
+                        }
+                        std::size_t unit_size = 0;
+                        switch (m_find_unit(m_input.data() + m_start, available(), m_input_done, unit_size)) {
+                            case unit_result::found:
+                                assert(unit_size > 0 && unit_size <= available());
+                                submit_to_queue(m_pool, m_results, decompress_unit<TStreamDecoder>{m_input.substr(m_start, unit_size)});
+                                m_start += unit_size;
+                                break;
+                            case unit_result::incomplete:
+                                if (m_input_done || available() > m_max_unit_size) {
+                                    m_mode = mode::sequential;
+                                } else {
+                                    read_input();
+                                }
+                                break;
+                            case unit_result::not_found:
+                                m_mode = mode::sequential;
+                                break;
+                            case unit_result::ignore_rest:
+                                m_mode = mode::done;
+                                break;
+                        }
+                    }
+                }
+
+                std::string read_sequential() {
+                    std::string output;
+                    while (output.empty() && m_mode == mode::sequential) {
+                        const char* const begin = m_input.data() + m_start;
+                        const char* const end = m_input.data() + m_input.size();
+                        const char* next = begin;
+                        m_decoder.decompress(next, end, output, osmium::io::Decompressor::input_buffer_size);
+                        m_start = static_cast<std::size_t>(next - m_input.data());
+                        if (output.empty() && next == begin) {
+                            // no progress without more input
+                            if (m_input_done) {
+                                m_decoder.finish(next, end, output);
+                                m_start = m_input.size();
+                                m_mode = mode::done;
+                            } else {
+                                read_input();
+                            }
+                        }
+                    }
+                    return output;
+                }
+
+            public:
+
+                /**
+                 * Create decompressor.
+                 *
+                 * @param fd File descriptor to read from.
+                 * @param pool Thread pool to use.
+                 * @param max_unit_size If a unit is larger than this (in
+                 *        compressed bytes), the rest of the file is
+                 *        decompressed in the calling thread.
+                 * @param queue_name Name of the queue for the results
+                 *        (see osmium::config::get_max_queue_size()).
+                 */
+                ParallelDecompressor(const int fd,
+                                     osmium::thread::Pool& pool,
+                                     const std::size_t max_unit_size,
+                                     const char* queue_name) :
+                    m_fd(fd),
+                    m_pool(pool),
+                    m_max_results(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_max_unit_size(max_unit_size),
+                    m_results(m_max_results, queue_name) {
+                    if (fd < 0) {
+                        throw std::system_error{EBADF, std::system_category(), "invalid file descriptor"};
+                    }
+                }
+
+                ParallelDecompressor(const ParallelDecompressor&) = delete;
+                ParallelDecompressor& operator=(const ParallelDecompressor&) = delete;
+
+                ParallelDecompressor(ParallelDecompressor&&) = delete;
+                ParallelDecompressor& operator=(ParallelDecompressor&&) = delete;
+
+                ~ParallelDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() override {
+                    while (true) {
+                        fill();
+                        if (!m_results.empty()) {
+                            std::string data{m_results.pop()};
+                            if (!data.empty()) {
+                                return data;
+                            }
+                        } else if (m_mode == mode::sequential) {
+                            return read_sequential();
+                        } else {
+                            return std::string{};
+                        }
+                    }
+                }
+
+                void close() override {
+                    // Wait for all tasks, they might still use the pool.
+                    drain_queue(m_results);
+
+                    if (m_fd >= 0) {
+                        const int fd = m_fd;
+                        m_fd = -1;
+                        reliable_close(fd);
+                    }
+                }
+
+            }; // class ParallelDecompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_COMPRESSION_HPP
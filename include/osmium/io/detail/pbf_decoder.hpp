@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -43,11 +45,14 @@ DEALINGS IN THE SOFTWARE.
 #include <vector>
 
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/buffer_pool.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/zlib.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
@@ -59,15 +64,21 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/trace.hpp>
 #include <osmium/util/delta.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
+#include <protozero/varint.hpp>
 
 namespace osmium {
 
@@ -82,6 +93,40 @@ namespace osmium {
             using protozero::data_view;
             using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
 
+            /**
+             * Decode a packed sint64 field containing delta encoded values
+             * (such as the ids, lats, and lons of DenseNodes) into a flat
+             * array of absolute values. The vector is resized to the number
+             * of values in the field, its capacity is kept, so re-using the
+             * same vector avoids allocations.
+             *
+             * @param data The contents of the packed field.
+             * @param values Vector the decoded values are written to.
+             * @throws osmium::pbf_error if the last value is truncated.
+             * @throws protozero::exception if the data is otherwise invalid.
+             */
+            inline void decode_packed_sint64_delta(const data_view& data, std::vector<int64_t>& values) {
+                const char* it = data.data();
+                const char* const end = it + data.size();
+
+                // Every varint ends with a byte that has the high bit
+                // cleared, so counting those gives us the number of values.
+                const auto count = std::count_if(it, end, [](const char c) {
+                    return (static_cast<unsigned char>(c) & 0x80U) == 0;
+                });
+                values.resize(static_cast<std::size_t>(count));
+
+                int64_t value = 0;
+                for (auto& v : values) {
+                    value += protozero::decode_zigzag64(protozero::decode_varint(&it, end));
+                    v = value;
+                }
+
+                if (it != end) {
+                    throw osmium::pbf_error{"truncated varint in packed field"};
+                }
+            }
+
             class PBFPrimitiveBlockDecoder {
 
                 enum {
@@ -102,6 +147,41 @@ namespace osmium {
 
                 osmium::io::read_meta m_read_metadata;
 
+                const osmium::io::read_filter* m_filter;
+
+                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
+
+                // Null-terminated copies of the strings in the string table.
+                // They are only needed if there is a filter, because it
+                // works on C strings.
+                std::string m_filter_string_data;
+                std::vector<const char*> m_filter_strings;
+
+                struct dense_node_arrays {
+                    std::vector<int64_t> ids;
+                    std::vector<int64_t> lats;
+                    std::vector<int64_t> lons;
+                };
+
+                // The decoded ids and locations of DenseNodes. They are kept
+                // around per thread so that their memory can be re-used for
+                // the next block.
+                static dense_node_arrays& decode_dense_node_arrays(const data_view& ids, const data_view& lats, const data_view& lons) {
+                    static thread_local dense_node_arrays arrays;
+
+                    decode_packed_sint64_delta(ids, arrays.ids);
+                    decode_packed_sint64_delta(lats, arrays.lats);
+                    decode_packed_sint64_delta(lons, arrays.lons);
+
+                    if (arrays.lats.size() < arrays.ids.size() ||
+                        arrays.lons.size() < arrays.ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    return arrays;
+                }
+
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
                         throw osmium::pbf_error{"more than one stringtable in pbf file"};
@@ -115,6 +195,111 @@ namespace osmium {
                         }
                         m_stringtable.emplace_back(str_view.data(), osmium::string_size_type(str_view.size()));
                     }
+
+                    if (m_filter) {
+                        build_filter_strings();
+                    }
+                }
+
+                void build_filter_strings() {
+                    std::size_t size = 0;
+                    for (const auto& str : m_stringtable) {
+                        size += str.second + 1;
+                    }
+
+                    m_filter_string_data.reserve(size);
+                    for (const auto& str : m_stringtable) {
+                        m_filter_string_data.append(str.first, str.second);
+                        m_filter_string_data += '\0';
+                    }
+
+                    m_filter_strings.reserve(m_stringtable.size());
+                    const char* ptr = m_filter_string_data.data();
+                    for (const auto& str : m_stringtable) {
+                        m_filter_strings.push_back(ptr);
+                        ptr += str.second + 1;
+                    }
+                }
+
+                bool match_tag(const std::size_t key, const std::size_t value) const {
+                    return m_filter->match(m_filter_strings.at(key), m_filter_strings.at(value));
+                }
+
+                // Check the tags of a Node, Way, or Relation message against
+                // the filter before the object is decoded.
+                template <typename TMessage>
+                bool keep_object(const data_view& data, const osmium::item_type type) const {
+                    if (!m_filter || !m_filter->applies_to(type)) {
+                        return true;
+                    }
+
+                    kv_type keys;
+                    kv_type vals;
+
+                    protozero::pbf_message<TMessage> message{data};
+                    while (message.next()) {
+                        if (message.tag() == TMessage::packed_uint32_keys &&
+                            message.wire_type() == protozero::pbf_wire_type::length_delimited) {
+                            keys = message.get_packed_uint32();
+                        } else if (message.tag() == TMessage::packed_uint32_vals &&
+                                   message.wire_type() == protozero::pbf_wire_type::length_delimited) {
+                            vals = message.get_packed_uint32();
+                        } else {
+                            message.skip();
+                        }
+                    }
+
+                    auto vit = vals.begin();
+                    for (const auto key : keys) {
+                        if (vit == vals.end()) {
+                            // this is against the spec, must have same number of elements
+                            throw osmium::pbf_error{"PBF format error"};
+                        }
+                        if (match_tag(key, *vit++)) {
+                            return true;
+                        }
+                    }
+
+                    return false;
+                }
+
+                // Check the id and location of a node from DenseNodes and
+                // its tags in the keys_vals array against the filter.
+                bool keep_dense_node(const int64_t id, const int64_t lon, const int64_t lat, protozero::pbf_reader::const_int32_iterator it, const protozero::pbf_reader::const_int32_iterator last) const {
+                    if (!m_filter) {
+                        return true;
+                    }
+
+                    if (m_filter->has_node_filter() &&
+                        !m_filter->match_node(id, osmium::Location{convert_pbf_lon(lon), convert_pbf_lat(lat)})) {
+                        return false;
+                    }
+
+                    if (!m_filter->applies_to(osmium::item_type::node)) {
+                        return true;
+                    }
+
+                    while (it != last && *it != 0) {
+                        const auto key = *it++;
+                        if (it == last) {
+                            throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                        }
+                        if (match_tag(key, *it++)) {
+                            return true;
+                        }
+                    }
+
+                    return false;
+                }
+
+                static void skip_dense_node_tags(protozero::pbf_reader::const_int32_iterator& it, const protozero::pbf_reader::const_int32_iterator last) {
+                    while (it != last && *it != 0) {
+                        ++it;
+                    }
+
+                    if (it != last) {
+                        ++it;
+                    }
                 }
 
                 void decode_primitive_block_metadata() {
@@ -150,8 +335,11 @@ namespace osmium {
                             switch (pbf_primitive_group.tag_and_type()) {
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::node) {
-                                        decode_node(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        if (decode_node(pbf_primitive_group.get_view())) {
+                                            m_buffer.commit();
+                                        } else {
+                                            m_buffer.rollback();
+                                        }
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
@@ -245,8 +433,6 @@ namespace osmium {
                     return user;
                 }
 
-                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
-
                 void build_tag_list(osmium::builder::Builder& parent, const kv_type& keys, const kv_type& vals) {
                     if (!keys.empty()) {
                         osmium::builder::TagListBuilder builder{parent};
@@ -272,7 +458,13 @@ namespace osmium {
                     return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
                 }
 
-                void decode_node(const data_view& data) {
+                // Returns false if the node was built, but doesn't match the
+                // filter and must be removed from the buffer again.
+                bool decode_node(const data_view& data) {
+                    if (!keep_object<OSMFormat::Node>(data, osmium::item_type::node)) {
+                        return true;
+                    }
+
                     osmium::builder::NodeBuilder builder{m_buffer};
                     osmium::Node& node = builder.object();
 
@@ -327,9 +519,16 @@ namespace osmium {
                     builder.set_user(user.first, user.second);
 
                     build_tag_list(builder, keys, vals);
+
+                    return !m_filter || !m_filter->has_node_filter() ||
+                           m_filter->match_node(builder.object().id(), builder.object().location());
                 }
 
                 void decode_way(const data_view& data) {
+                    if (!keep_object<OSMFormat::Way>(data, osmium::item_type::way)) {
+                        return;
+                    }
+
                     osmium::builder::WayBuilder builder{m_buffer};
 
                     kv_type keys;
@@ -402,6 +601,10 @@ namespace osmium {
                 }
 
                 void decode_relation(const data_view& data) {
+                    if (!keep_object<OSMFormat::Relation>(data, osmium::item_type::relation)) {
+                        return;
+                    }
+
                     osmium::builder::RelationBuilder builder{m_buffer};
 
                     kv_type keys;
@@ -488,9 +691,9 @@ namespace osmium {
                 }
 
                 void decode_dense_nodes_without_metadata(const data_view& data) {
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -498,13 +701,13 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -514,33 +717,24 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    const auto& arrays = decode_dense_node_arrays(ids, lats, lons);
 
                     auto tag_it = tags.begin();
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < arrays.ids.size(); ++i) {
+                        if (!keep_dense_node(arrays.ids[i], arrays.lons[i], arrays.lats[i], tag_it, tags.end())) {
+                            skip_dense_node_tags(tag_it, tags.end());
+                            continue;
                         }
 
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
-
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
-                            builder.object().set_location(osmium::Location{
-                                    convert_pbf_lon(lon),
-                                    convert_pbf_lat(lat)
+                            node.set_id(arrays.ids[i]);
+                            node.set_location(osmium::Location{
+                                    convert_pbf_lon(arrays.lons[i]),
+                                    convert_pbf_lat(arrays.lats[i])
                             });
 
                             if (tag_it != tags.end()) {
@@ -555,9 +749,9 @@ namespace osmium {
                 void decode_dense_nodes(const data_view& data) {
                     bool has_info = false;
 
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -572,7 +766,7 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
                                 {
@@ -605,10 +799,10 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -618,9 +812,8 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    const auto& arrays = decode_dense_node_arrays(ids, lats, lons);
+
                     osmium::DeltaDecode<int64_t> dense_uid;
                     osmium::DeltaDecode<int64_t> dense_user_sid;
                     osmium::DeltaDecode<int64_t> dense_changeset;
@@ -628,11 +821,36 @@ namespace osmium {
 
                     auto tag_it = tags.begin();
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < arrays.ids.size(); ++i) {
+                        if (!keep_dense_node(arrays.ids[i], arrays.lons[i], arrays.lats[i], tag_it, tags.end())) {
+                            // The metadata is delta encoded, so we have to
+                            // decode it even for nodes that are skipped.
+                            if (has_info) {
+                                if (!versions.empty()) {
+                                    versions.drop_front();
+                                }
+                                if (!changesets.empty()) {
+                                    dense_changeset.update(changesets.front());
+                                    changesets.drop_front();
+                                }
+                                if (!timestamps.empty()) {
+                                    dense_timestamp.update(timestamps.front());
+                                    timestamps.drop_front();
+                                }
+                                if (!uids.empty()) {
+                                    dense_uid.update(uids.front());
+                                    uids.drop_front();
+                                }
+                                if (!visibles.empty()) {
+                                    visibles.drop_front();
+                                }
+                                if (!user_sids.empty()) {
+                                    dense_user_sid.update(user_sids.front());
+                                    user_sids.drop_front();
+                                }
+                            }
+                            skip_dense_node_tags(tag_it, tags.end());
+                            continue;
                         }
 
                         bool visible = true;
@@ -641,8 +859,7 @@ namespace osmium {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
+                            node.set_id(arrays.ids[i]);
 
                             if (has_info) {
                                 if (!versions.empty()) {
@@ -697,15 +914,13 @@ namespace osmium {
                             }
 
                             // even if the node isn't visible, there's still a record
-                            // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
+                            // of its lat/lon in the dense arrays. The node
+                            // reference can't be used here, because set_user()
+                            // might have reallocated the buffer.
                             if (visible) {
                                 builder.object().set_location(osmium::Location{
-                                        convert_pbf_lon(lon),
-                                        convert_pbf_lat(lat)
+                                        convert_pbf_lon(arrays.lons[i]),
+                                        convert_pbf_lat(arrays.lats[i])
                                 });
                             }
 
@@ -719,10 +934,33 @@ namespace osmium {
 
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, const osmium::io::read_filter* filter = nullptr) :
                     m_data(data),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_filter(filter) {
+                }
+
+                /**
+                 * Create a decoder writing into the given (empty) buffer
+                 * instead of a newly allocated one. The buffer must use
+                 * auto_grow::internal.
+                 */
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, osmium::memory::Buffer&& buffer, const osmium::io::read_filter* filter = nullptr) :
+                    m_data(data),
+                    m_read_types(read_types),
+                    m_buffer(std::move(buffer)),
+                    m_read_metadata(read_metadata),
+                    m_filter(filter) {
+                }
+
+                /**
+                 * The decoded OSM objects need about four times the space
+                 * of the uncompressed PBF data. Returns a good buffer size
+                 * for decoding data of the given size.
+                 */
+                static std::size_t estimated_buffer_size(std::size_t data_size) noexcept {
+                    return std::max(static_cast<std::size_t>(initial_buffer_size), data_size * 4);
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -746,7 +984,86 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            /**
+             * Decode the size of the BlobHeader from the 4 bytes (in network
+             * byte order) in front of every blob.
+             *
+             * @throws osmium::pbf_error If the size is too large.
+             */
+            inline uint32_t decode_blob_header_size(const char* data) {
+                const uint32_t size = (static_cast<uint32_t>(static_cast<unsigned char>(data[0])) << 24U) |
+                                      (static_cast<uint32_t>(static_cast<unsigned char>(data[1])) << 16U) |
+                                      (static_cast<uint32_t>(static_cast<unsigned char>(data[2])) <<  8U) |
+                                      (static_cast<uint32_t>(static_cast<unsigned char>(data[3])));
+
+                if (size > static_cast<uint32_t>(max_blob_header_size)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                }
+
+                return size;
+            }
+
+            struct pbf_blob_header_info {
+
+                /// Type of the blob ("OSMHeader" or "OSMData").
+                data_view type{};
+
+                /// Contents of the indexdata field.
+                data_view index_data{};
+
+                /// Size of the BlobHeader.
+                std::size_t header_size = 0;
+
+                /// Size of the Blob following the BlobHeader.
+                std::size_t data_size = 0;
+
+                /// Size of the whole blob including length and BlobHeader.
+                std::size_t blob_size() const noexcept {
+                    return 4 + header_size + data_size;
+                }
+
+            }; // struct pbf_blob_header_info
+
+            /**
+             * Decode the BlobHeader. The data views in the result point
+             * into the input data.
+             *
+             * @throws osmium::pbf_error If the size of the following Blob
+             *         is missing or too large.
+             */
+            inline pbf_blob_header_info decode_blob_header(const data_view& data) {
+                pbf_blob_header_info info;
+                info.header_size = data.size();
+
+                protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            info.type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::optional_bytes_indexdata, protozero::pbf_wire_type::length_delimited):
+                            info.index_data = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            info.data_size = static_cast<std::size_t>(pbf_blob_header.get_int32());
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (info.data_size == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (info.data_size > max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{"invalid blob size: " + std::to_string(info.data_size)};
+                }
+
+                return info;
+            }
+
+            inline data_view decode_blob(const data_view& blob_data, std::string& output) {
                 int32_t raw_size = 0;
                 protozero::data_view compressed_data;
                 pbf_compression use_compression = pbf_compression::none;
@@ -783,7 +1100,13 @@ namespace osmium {
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            use_compression = pbf_compression::zstd;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
                         default:
                             throw osmium::pbf_error{"unknown compression"};
                     }
@@ -810,6 +1133,17 @@ namespace osmium {
                             );
 #else
                             break;
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            return osmium::io::detail::zstd_uncompress_string(
+                                compressed_data.data(),
+                                static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
+                                static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
+                                output
+                            );
+#else
+                            break;
 #endif
                     }
                     std::abort(); // should never be here
@@ -923,7 +1257,7 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
@@ -931,22 +1265,77 @@ namespace osmium {
 
             class PBFDataBlobDecoder {
 
+                // Only set if the decoder owns the input data.
                 std::shared_ptr<std::string> m_input_buffer;
+
+                data_view m_input_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                BufferPool* m_buffer_pool;
+                const osmium::io::read_filter* m_filter;
+                reader_counters* m_counters;
+
+                osmium::memory::Buffer decode(const data_view& data) const {
+                    OSMIUM_TRACE_SCOPE("decode_primitive_block");
+                    if (m_buffer_pool) {
+                        PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, m_buffer_pool->get(PBFPrimitiveBlockDecoder::estimated_buffer_size(data.size())), m_filter};
+                        return decoder();
+                    }
+
+                    PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, m_filter};
+                    return decoder();
+                }
+
+                data_view decompress(std::string& output) const {
+                    OSMIUM_TRACE_SCOPE("decode_blob");
+                    return decode_blob(m_input_data, output);
+                }
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, BufferPool* buffer_pool = nullptr, const osmium::io::read_filter* filter = nullptr, reader_counters* counters = nullptr) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                    m_input_data(*m_input_buffer),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool),
+                    m_filter(filter),
+                    m_counters(counters) {
+                }
+
+                /**
+                 * Create a decoder for data that is not owned by the decoder.
+                 * The data must be kept alive until the decoder has run.
+                 */
+                PBFDataBlobDecoder(const data_view& input_data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, BufferPool* buffer_pool = nullptr, const osmium::io::read_filter* filter = nullptr, reader_counters* counters = nullptr) :
+                    m_input_data(input_data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_buffer_pool(buffer_pool),
+                    m_filter(filter),
+                    m_counters(counters) {
                 }
 
                 osmium::memory::Buffer operator()() {
-                    std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
-                    return decoder();
+                    // Scratch space for the uncompressed data. It is kept
+                    // per thread so it doesn't have to be allocated again
+                    // for every blob.
+                    static thread_local std::string output;
+
+                    if (!m_counters) {
+                        return decode(decompress(output));
+                    }
+
+                    using clock = osmium::thread::detail::stats_clock;
+                    const auto start = clock::now();
+                    const auto data = decompress(output);
+                    const auto decompressed = clock::now();
+                    auto buffer = decode(data);
+                    m_counters->blob_decode_busy.add_since(decompressed);
+                    m_counters->blob_decompress_busy.add(decompressed - start);
+                    m_counters->blob_bytes_decompressed.fetch_add(data.size(), std::memory_order_relaxed);
+                    m_counters->blobs_decoded.fetch_add(1, std::memory_order_relaxed);
+                    return buffer;
                 }
 
             }; // class PBFDataBlobDecoder
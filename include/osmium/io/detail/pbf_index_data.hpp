@@ -0,0 +1,173 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_INDEX_DATA_HPP
+#define OSMIUM_IO_DETAIL_PBF_INDEX_DATA_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <protozero/data_view.hpp>
+#include <protozero/exception.hpp>
+#include <protozero/pbf_builder.hpp>
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Format identifier written into the index data. Index data
+            // in any other format is ignored.
+            constexpr const char* pbf_blob_index_data_format = "OsmiumBlobIndex-V1";
+
+            /**
+             * Information about the contents of a PBF data blob that Osmium
+             * stores in the (optional) indexdata field of the BlobHeader.
+             * Because the BlobHeader is never compressed, this allows the
+             * reader to find out what is in a blob without decompressing
+             * and decoding it.
+             */
+            struct pbf_blob_index_data {
+
+                /// Types of all entities in the blob.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                /// Smallest ID of any entity in the blob.
+                osmium::object_id_type min_id = 0;
+
+                /// Largest ID of any entity in the blob.
+                osmium::object_id_type max_id = 0;
+
+                /// Do we have any information about the blob?
+                bool valid() const noexcept {
+                    return types != osmium::osm_entity_bits::nothing;
+                }
+
+                /// Add entity of given type and ID.
+                void add(osmium::osm_entity_bits::type type, osmium::object_id_type id) noexcept {
+                    if (!valid()) {
+                        min_id = id;
+                        max_id = id;
+                    } else if (id < min_id) {
+                        min_id = id;
+                    } else if (id > max_id) {
+                        max_id = id;
+                    }
+                    types |= type;
+                }
+
+                void clear() noexcept {
+                    types = osmium::osm_entity_bits::nothing;
+                    min_id = 0;
+                    max_id = 0;
+                }
+
+            }; // struct pbf_blob_index_data
+
+            /**
+             * Encode index data for use in the BlobHeader.indexdata field.
+             */
+            inline std::string encode_blob_index_data(const pbf_blob_index_data& index_data) {
+                std::string data;
+                protozero::pbf_builder<OsmiumFormat::BlobIndexData> pbf_index_data{data};
+
+                pbf_index_data.add_string(OsmiumFormat::BlobIndexData::required_string_format, pbf_blob_index_data_format);
+                pbf_index_data.add_uint32(OsmiumFormat::BlobIndexData::required_uint32_entity_types, static_cast<uint32_t>(index_data.types));
+                pbf_index_data.add_sint64(OsmiumFormat::BlobIndexData::optional_sint64_min_id, index_data.min_id);
+                pbf_index_data.add_sint64(OsmiumFormat::BlobIndexData::optional_sint64_max_id, index_data.max_id);
+
+                return data;
+            }
+
+            /**
+             * Decode contents of the BlobHeader.indexdata field. Other
+             * programs might use this field for something else, so if the
+             * data can not be decoded or is in an unknown format, an
+             * invalid (empty) index data object is returned.
+             */
+            inline pbf_blob_index_data decode_blob_index_data(const protozero::data_view& data) noexcept {
+                pbf_blob_index_data index_data;
+
+                if (data.empty()) {
+                    return index_data;
+                }
+
+                bool format_ok = false;
+                uint32_t types = 0;
+
+                try {
+                    protozero::pbf_message<OsmiumFormat::BlobIndexData> pbf_index_data{data};
+                    while (pbf_index_data.next()) {
+                        switch (pbf_index_data.tag_and_type()) {
+                            case protozero::tag_and_type(OsmiumFormat::BlobIndexData::required_string_format, protozero::pbf_wire_type::length_delimited):
+                                format_ok = pbf_index_data.get_view() == protozero::data_view{pbf_blob_index_data_format};
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobIndexData::required_uint32_entity_types, protozero::pbf_wire_type::varint):
+                                types = pbf_index_data.get_uint32();
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobIndexData::optional_sint64_min_id, protozero::pbf_wire_type::varint):
+                                index_data.min_id = pbf_index_data.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OsmiumFormat::BlobIndexData::optional_sint64_max_id, protozero::pbf_wire_type::varint):
+                                index_data.max_id = pbf_index_data.get_sint64();
+                                break;
+                            default:
+                                pbf_index_data.skip();
+                        }
+                    }
+                } catch (const protozero::exception&) {
+                    return pbf_blob_index_data{};
+                }
+
+                if (!format_ok) {
+                    return pbf_blob_index_data{};
+                }
+
+                index_data.types = static_cast<osmium::osm_entity_bits::type>(types & osmium::osm_entity_bits::all);
+
+                return index_data;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_INDEX_DATA_HPP
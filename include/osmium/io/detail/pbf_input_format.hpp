@@ -36,6 +36,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_index_data.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
@@ -44,13 +45,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
-#include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
 
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -66,6 +65,9 @@ namespace osmium {
 
                 std::string m_input_buffer{};
 
+                // Offset of the next byte to be read from the input data.
+                std::size_t m_input_offset = 0;
+
                 /**
                  * Read the given number of bytes from the input queue.
                  *
@@ -82,6 +84,8 @@ namespace osmium {
                         m_input_buffer += new_data;
                     }
 
+                    m_input_offset += size;
+
                     std::string output{m_input_buffer.substr(size)};
                     m_input_buffer.resize(size);
 
@@ -92,64 +96,74 @@ namespace osmium {
                 }
 
                 /**
-                 * Read 4 bytes in network byte order from file. They contain
-                 * the length of the following BlobHeader.
+                 * Get a view on the given number of bytes of the input data
+                 * in memory. Nothing is copied.
+                 *
+                 * @param size Number of bytes to read
+                 * @returns View on the data
+                 * @throws osmium::pbf_error If size bytes can't be read
                  */
-                uint32_t read_blob_header_size_from_file() {
-                    uint32_t size = 0;
-
-                    try {
-                        // size is encoded in network byte order
-                        const std::string input_data{read_from_input_queue(sizeof(size))};
-                        const char* d = input_data.data();
-                        size = (static_cast<uint32_t>(d[3])) |
-                               (static_cast<uint32_t>(d[2]) <<  8U) |
-                               (static_cast<uint32_t>(d[1]) << 16U) |
-                               (static_cast<uint32_t>(d[0]) << 24U);
-                    } catch (const osmium::pbf_error&) {
-                        return 0; // EOF
+                protozero::data_view read_from_direct_input(size_t size) {
+                    DirectInput& input = *direct_input();
+                    if (m_input_offset > input.size() || input.size() - m_input_offset < size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
                     }
 
-                    if (size > static_cast<uint32_t>(max_blob_header_size)) {
-                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
-                    }
+                    const protozero::data_view data{input.data() + m_input_offset, size};
+                    m_input_offset += size;
+                    input.set_offset(m_input_offset);
 
-                    return size;
+                    return data;
                 }
 
                 /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
+                 * Read the given number of bytes from the input. If the input
+                 * is available in memory, the view returned points into it,
+                 * otherwise the data is read from the input queue into the
+                 * buffer and the view points into that buffer.
+                 *
+                 * @param size Number of bytes to read
+                 * @param buffer Buffer to use if data has to be copied
+                 * @returns View on the data
+                 * @throws osmium::pbf_error If size bytes can't be read
                  */
-                static size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag_and_type()) {
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
+                protozero::data_view read_input(size_t size, std::string& buffer) {
+                    if (direct_input()) {
+                        return read_from_direct_input(size);
                     }
 
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                    buffer = read_from_input_queue(size);
+                    return protozero::data_view{buffer.data(), buffer.size()};
+                }
+
+                /**
+                 * Read 4 bytes in network byte order from file. They contain
+                 * the length of the following BlobHeader.
+                 */
+                uint32_t read_blob_header_size_from_file() {
+                    if (direct_input() && direct_input()->stopped()) {
+                        return 0; // reader was closed, behave as if at EOF
                     }
 
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    std::string buffer;
+                    protozero::data_view input_data;
+                    try {
+                        input_data = read_input(4, buffer);
+                    } catch (const osmium::pbf_error&) {
+                        return 0; // EOF
                     }
 
-                    return blob_header_datasize;
+                    return decode_blob_header_size(input_data.data());
                 }
 
-                size_t check_type_and_get_blob_size(const char* expected_type) {
+                /**
+                 * Read and decode the BlobHeader. Make sure it contains the
+                 * expected type. Return the size of the following Blob. If
+                 * the BlobHeader contains index data written by Osmium, it
+                 * is returned in index_data, otherwise index_data will be
+                 * invalid.
+                 */
+                size_t check_type_and_get_blob_size(const char* expected_type, pbf_blob_index_data& index_data) {
                     assert(expected_type);
 
                     const auto size = read_blob_header_size_from_file();
@@ -157,37 +171,98 @@ namespace osmium {
                         return 0;
                     }
 
-                    const std::string blob_header{read_from_input_queue(size)};
-
-                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header), expected_type);
-                }
+                    std::string buffer;
+                    const auto info = decode_blob_header(read_input(size, buffer));
 
-                std::string read_from_input_queue_with_check(size_t size) {
-                    if (size > max_uncompressed_blob_size) {
-                        throw osmium::pbf_error{std::string{"invalid blob size: "} +
-                                                std::to_string(size)};
+                    if (info.type != protozero::data_view{expected_type}) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
                     }
-                    return read_from_input_queue(size);
+
+                    index_data = decode_blob_index_data(info.index_data);
+
+                    return info.data_size;
                 }
 
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
-                    const auto size = check_type_and_get_blob_size("OSMHeader");
-                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
+                    pbf_blob_index_data index_data;
+                    const auto size = check_type_and_get_blob_size("OSMHeader", index_data);
+                    std::string buffer;
+                    osmium::io::Header header{decode_header(read_input(size, buffer))};
                     set_header_value(header);
                 }
 
-                void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                void decode_data_blob(PBFDataBlobDecoder&& data_blob_parser) {
+                    if (osmium::config::use_pool_threads_for_pbf_parsing()) {
+                        submit_to_output_queue(std::move(data_blob_parser));
+                    } else {
+                        send_to_output_queue(data_blob_parser());
+                    }
+                }
+
+                /**
+                 * Should the blob with the given index data be decoded? If
+                 * the index data tells us that the blob doesn't contain any
+                 * of the entity types we are interested in, we can skip it
+                 * without decompressing it.
+                 */
+                bool wanted(const pbf_blob_index_data& index_data) const noexcept {
+                    return !index_data.valid() || (index_data.types & read_types());
+                }
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                /**
+                 * Parse the data blob of the given size which is next in
+                 * the input or skip it if it is not wanted.
+                 */
+                void parse_data_blob(size_t size, const pbf_blob_index_data& index_data, bool selected) {
+                    if (!selected || !wanted(index_data)) {
+                        std::string buffer;
+                        read_input(size, buffer);
+                    } else if (direct_input()) {
+                        // The blob data is not copied, the decoder works
+                        // directly on the input data in memory.
+                        decode_data_blob(PBFDataBlobDecoder{read_from_direct_input(size), read_types(), read_metadata(), buffer_pool(), filter(), counters()});
+                    } else {
+                        decode_data_blob(PBFDataBlobDecoder{read_from_input_queue(size), read_types(), read_metadata(), buffer_pool(), filter(), counters()});
+                    }
+                }
+
+                /**
+                 * Parse only the selected blobs. Used if the input is in
+                 * memory, so we can jump directly to the blobs.
+                 */
+                void parse_selected_data_blobs() {
+                    DirectInput& input = *direct_input();
+                    pbf_blob_index_data index_data;
+                    for (const auto offset : blobs()->offsets()) {
+                        if (offset < m_input_offset || offset >= input.size()) {
+                            throw osmium::pbf_error{"invalid blob offset in blob selection: " + std::to_string(offset)};
+                        }
+                        m_input_offset = static_cast<std::size_t>(offset);
+                        const auto size = check_type_and_get_blob_size("OSMData", index_data);
+                        if (size == 0) { // reader was closed
+                            return;
+                        }
+                        parse_data_blob(size, index_data, true);
+                    }
+                    m_input_offset = input.size();
+                    input.set_offset(m_input_offset);
+                }
+
+                void parse_data_blobs() {
+                    if (blobs() && direct_input()) {
+                        parse_selected_data_blobs();
+                        return;
+                    }
 
-                        if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
-                        } else {
-                            send_to_output_queue(data_blob_parser());
+                    pbf_blob_index_data index_data;
+                    for (;;) {
+                        const auto offset = m_input_offset;
+                        const auto size = check_type_and_get_blob_size("OSMData", index_data);
+                        if (size == 0) { // EOF
+                            break;
                         }
+                        parse_data_blob(size, index_data, !blobs() || blobs()->contains(offset));
                     }
                 }
 
@@ -42,9 +42,9 @@ DEALINGS IN THE SOFTWARE.
 #include <utility>
 #include <vector>
 
-#include <osmium/handler.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_index_data.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/string_table.hpp>
@@ -55,6 +55,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
@@ -67,14 +68,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/thread/trace.hpp>
 #include <osmium/util/delta.hpp>
 #include <osmium/util/misc.hpp>
-#include <osmium/visitor.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/pbf_builder.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
@@ -111,6 +116,12 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways = false;
 
+                /**
+                 * Should information about the contents of each data blob
+                 * be written into the BlobHeader.indexdata field?
+                 */
+                bool add_index_data = false;
+
             }; // struct pbf_output_options
 
             /**
@@ -149,6 +160,8 @@ namespace osmium {
 
                 std::string m_msg;
 
+                std::string m_index_data;
+
                 int m_compression_level;
 
                 pbf_blob_type m_blob_type;
@@ -164,9 +177,12 @@ namespace osmium {
                  * @param type Type of blob.
                  * @param use_compression The type of compression to use.
                  * @param compression_level Compression level.
+                 * @param index_data Contents of the BlobHeader.indexdata
+                 *                   field (empty if there is none).
                  */
-                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression use_compression, int compression_level) :
+                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression use_compression, int compression_level, std::string&& index_data = std::string{}) :
                     m_msg(std::move(msg)),
+                    m_index_data(std::move(index_data)),
                     m_compression_level(compression_level),
                     m_blob_type(type),
                     m_use_compression(use_compression) {
@@ -178,6 +194,7 @@ namespace osmium {
                  * to be written to a file.
                  */
                 std::string operator()() {
+                    OSMIUM_TRACE_SCOPE("serialize_blob");
                     assert(m_msg.size() <= max_uncompressed_blob_size);
 
                     std::string blob_data;
@@ -198,6 +215,14 @@ namespace osmium {
                             break;
 #else
                             throw osmium::pbf_error{"lz4 blobs not supported"};
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported"};
 #endif
                     }
 
@@ -206,6 +231,10 @@ namespace osmium {
 
                     pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
 
+                    if (!m_index_data.empty()) {
+                        pbf_blob_header.add_bytes(FileFormat::BlobHeader::optional_bytes_indexdata, m_index_data);
+                    }
+
                     // The static_cast is okay, because the size can never
                     // be much larger than max_uncompressed_blob_size. This
                     // is due to the assert above and the fact that the zlib
@@ -236,8 +265,8 @@ namespace osmium {
              * structure.
              *
              * Because this needs to allocate a lot of memory on the heap,
-             * only one object of this class will be created and then re-used
-             * after calling clear() on it.
+             * only one object of this class will be created for each
+             * PBFOutputBlock and then re-used after calling clear() on it.
              */
             class DenseNodes {
 
@@ -382,14 +411,59 @@ namespace osmium {
                 protozero::pbf_builder<OSMFormat::PrimitiveGroup> m_pbf_primitive_group;
                 StringTable m_stringtable;
                 DenseNodes m_dense_nodes;
+                pbf_blob_index_data m_index_data;
                 OSMFormat::PrimitiveGroup m_type = OSMFormat::PrimitiveGroup::unknown;
                 int m_count = 0;
+                const pbf_output_options& m_options;
+
+                template <typename T>
+                void add_meta(const osmium::OSMObject& object, T& pbf_object) {
+                    {
+                        protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_keys)};
+                        for (const auto& tag : object.tags()) {
+                            field.add_element(store_in_stringtable_unsigned(tag.key()));
+                        }
+                    }
+
+                    {
+                        protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_vals)};
+                        for (const auto& tag : object.tags()) {
+                            field.add_element(store_in_stringtable_unsigned(tag.value()));
+                        }
+                    }
+
+                    if (m_options.add_metadata.any() || m_options.add_visible_flag) {
+                        protozero::pbf_builder<OSMFormat::Info> pbf_info{pbf_object, T::enum_type::optional_Info_info};
+
+                        if (m_options.add_metadata.version()) {
+                            assert(object.version() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
+                            pbf_info.add_int32(OSMFormat::Info::optional_int32_version, static_cast<int32_t>(object.version()));
+                        }
+                        if (m_options.add_metadata.timestamp()) {
+                            pbf_info.add_int64(OSMFormat::Info::optional_int64_timestamp, uint32_t(object.timestamp()));
+                        }
+                        if (m_options.add_metadata.changeset()) {
+                            pbf_info.add_int64(OSMFormat::Info::optional_int64_changeset, object.changeset());
+                        }
+                        if (m_options.add_metadata.uid()) {
+                            assert(object.uid() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
+                            pbf_info.add_int32(OSMFormat::Info::optional_int32_uid, static_cast<int32_t>(object.uid()));
+                        }
+                        if (m_options.add_metadata.user()) {
+                            pbf_info.add_uint32(OSMFormat::Info::optional_uint32_user_sid, store_in_stringtable_unsigned(object.user()));
+                        }
+                        if (m_options.add_visible_flag) {
+                            pbf_info.add_bool(OSMFormat::Info::optional_bool_visible, object.visible());
+                        }
+                    }
+                }
 
             public:
 
                 explicit PrimitiveBlock(const pbf_output_options& options) :
                     m_pbf_primitive_group(m_pbf_primitive_group_data),
-                    m_dense_nodes(m_stringtable, options) {
+                    m_dense_nodes(m_stringtable, options),
+                    m_options(options) {
                 }
 
                 const std::string& group_data() {
@@ -403,6 +477,7 @@ namespace osmium {
                     m_pbf_primitive_group_data.clear();
                     m_stringtable.clear();
                     m_dense_nodes.clear();
+                    m_index_data.clear();
                     m_type = type;
                     m_count = 0;
                 }
@@ -418,6 +493,15 @@ namespace osmium {
                     return m_pbf_primitive_group;
                 }
 
+                /// Remember type and ID of an object added to this block.
+                void add_to_index(const osmium::OSMObject& object) noexcept {
+                    m_index_data.add(osmium::osm_entity_bits::from_item_type(object.type()), object.id());
+                }
+
+                const pbf_blob_index_data& index_data() const noexcept {
+                    return m_index_data;
+                }
+
                 void add_dense_node(const osmium::Node& node) {
                     m_dense_nodes.add_node(node);
                     ++m_count;
@@ -469,16 +553,121 @@ namespace osmium {
                     return size() < max_used_blob_size;
                 }
 
+                void add_node(const osmium::Node& node) {
+                    if (m_options.use_dense_nodes) {
+                        add_to_index(node);
+                        add_dense_node(node);
+                        return;
+                    }
+
+                    add_to_index(node);
+                    protozero::pbf_builder<OSMFormat::Node> pbf_node{group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
+                    add_meta(node, pbf_node);
+
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, lonlat2int(node.location().lat_without_check()));
+                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, lonlat2int(node.location().lon_without_check()));
+                }
+
+                void add_way(const osmium::Way& way) {
+                    add_to_index(way);
+                    protozero::pbf_builder<OSMFormat::Way> pbf_way{group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
+
+                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
+                    add_meta(way, pbf_way);
+
+                    {
+                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_refs)};
+                        for (const auto& node_ref : way.nodes()) {
+                            field.add_element(delta_id.update(node_ref.ref()));
+                        }
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        {
+                            osmium::DeltaEncode<int64_t, int64_t> delta_id;
+                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
+                            for (const auto& node_ref : way.nodes()) {
+                                field.add_element(delta_id.update(lonlat2int(node_ref.location().lon_without_check())));
+                            }
+                        }
+                        {
+                            osmium::DeltaEncode<int64_t, int64_t> delta_id;
+                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lat)};
+                            for (const auto& node_ref : way.nodes()) {
+                                field.add_element(delta_id.update(lonlat2int(node_ref.location().lat_without_check())));
+                            }
+                        }
+                    }
+                }
+
+                void add_relation(const osmium::Relation& relation) {
+                    add_to_index(relation);
+                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
+
+                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
+                    add_meta(relation, pbf_relation);
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_int32_roles_sid)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(store_in_stringtable(member.role()));
+                        }
+                    }
+
+                    {
+                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_sint64_memids)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(delta_id.update(member.ref()));
+                        }
+                    }
+
+                    {
+                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_MemberType_types)};
+                        for (const auto& member : relation.members()) {
+                            field.add_element(int32_t(osmium::item_type_to_nwr_index(member.type())));
+                        }
+                    }
+                }
+
             }; // class PrimitiveBlock
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * A job encoding a list of OSM objects of the same type into
+             * PBF blobs. Usually this will be one blob, but if the
+             * objects don't fit into one, there will be several. The
+             * jobs run in parallel on the thread pool, each with its own
+             * string table and DenseNodes encoder. The objects are kept
+             * alive by holding on to the buffers they are in.
+             */
+            class PBFOutputBlock {
 
                 pbf_output_options m_options;
+                std::vector<std::shared_ptr<osmium::memory::Buffer>> m_buffers;
+                std::vector<const osmium::OSMObject*> m_objects;
+                std::size_t m_size = 0;
+                osmium::item_type m_type = osmium::item_type::undefined;
+
+                OSMFormat::PrimitiveGroup group_type(const osmium::item_type type) const noexcept {
+                    switch (type) {
+                        case osmium::item_type::node:
+                            return m_options.use_dense_nodes ? OSMFormat::PrimitiveGroup::optional_DenseNodes_dense
+                                                             : OSMFormat::PrimitiveGroup::repeated_Node_nodes;
+                        case osmium::item_type::way:
+                            return OSMFormat::PrimitiveGroup::repeated_Way_ways;
+                        case osmium::item_type::relation:
+                            return OSMFormat::PrimitiveGroup::repeated_Relation_relations;
+                        default:
+                            break;
+                    }
+                    return OSMFormat::PrimitiveGroup::unknown;
+                }
 
-                PrimitiveBlock m_primitive_block;
-
-                void store_primitive_block() {
-                    if (m_primitive_block.count() == 0) {
+                void store_primitive_block(PrimitiveBlock& block, std::string& output) const {
+                    if (block.count() == 0) {
                         return;
                     }
 
@@ -487,73 +676,107 @@ namespace osmium {
 
                     {
                         protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
-                        m_primitive_block.write_stringtable(pbf_string_table);
+                        block.write_stringtable(pbf_string_table);
                     }
 
-                    primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
+                    primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, block.group_data());
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(primitive_block_data),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression,
-                                      m_options.compression_level}
-                    ));
+                    SerializeBlob serialize_blob{std::move(primitive_block_data),
+                                                 pbf_blob_type::data,
+                                                 m_options.use_compression,
+                                                 m_options.compression_level,
+                                                 m_options.add_index_data ? encode_blob_index_data(block.index_data()) : std::string{}};
+                    output += serialize_blob();
                 }
 
-                template <typename T>
-                void add_meta(const osmium::OSMObject& object, T& pbf_object) {
-                    {
-                        protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_keys)};
-                        for (const auto& tag : object.tags()) {
-                            field.add_element(m_primitive_block.store_in_stringtable_unsigned(tag.key()));
-                        }
+            public:
+
+                explicit PBFOutputBlock(const pbf_output_options& options) :
+                    m_options(options) {
+                }
+
+                bool empty() const noexcept {
+                    return m_objects.empty();
+                }
+
+                /**
+                 * Can this object be added to this job? The job holds at
+                 * most as many objects as fit into a primitive block and
+                 * not more data than (uncompressed) fits into a blob,
+                 * assuming the encoded objects are not larger than in
+                 * memory. If they are, the job will write more than one
+                 * blob.
+                 */
+                bool can_add(const osmium::OSMObject& object) const noexcept {
+                    if (empty()) {
+                        return true;
                     }
+                    return object.type() == m_type &&
+                           m_objects.size() < max_entities_per_block &&
+                           m_size + object.byte_size() < PrimitiveBlock::max_used_blob_size;
+                }
 
-                    {
-                        protozero::packed_field_uint32 field{pbf_object, protozero::pbf_tag_type(T::enum_type::packed_uint32_vals)};
-                        for (const auto& tag : object.tags()) {
-                            field.add_element(m_primitive_block.store_in_stringtable_unsigned(tag.value()));
-                        }
+                void add(const std::shared_ptr<osmium::memory::Buffer>& buffer, const osmium::OSMObject& object) {
+                    if (m_buffers.empty() || m_buffers.back() != buffer) {
+                        m_buffers.push_back(buffer);
                     }
+                    m_objects.push_back(&object);
+                    m_size += object.byte_size();
+                    m_type = object.type();
+                }
 
-                    if (m_options.add_metadata.any() || m_options.add_visible_flag) {
-                        protozero::pbf_builder<OSMFormat::Info> pbf_info{pbf_object, T::enum_type::optional_Info_info};
+                std::string operator()() const {
+                    OSMIUM_TRACE_SCOPE("encode_primitive_block");
+                    std::string output;
+                    PrimitiveBlock block{m_options};
 
-                        if (m_options.add_metadata.version()) {
-                            assert(object.version() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
-                            pbf_info.add_int32(OSMFormat::Info::optional_int32_version, static_cast<int32_t>(object.version()));
+                    for (const auto* object : m_objects) {
+                        const auto type = group_type(object->type());
+                        if (!block.can_add(type)) {
+                            store_primitive_block(block, output);
+                            block.reset(type);
                         }
-                        if (m_options.add_metadata.timestamp()) {
-                            pbf_info.add_int64(OSMFormat::Info::optional_int64_timestamp, uint32_t(object.timestamp()));
-                        }
-                        if (m_options.add_metadata.changeset()) {
-                            pbf_info.add_int64(OSMFormat::Info::optional_int64_changeset, object.changeset());
-                        }
-                        if (m_options.add_metadata.uid()) {
-                            assert(object.uid() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
-                            pbf_info.add_int32(OSMFormat::Info::optional_int32_uid, static_cast<int32_t>(object.uid()));
-                        }
-                        if (m_options.add_metadata.user()) {
-                            pbf_info.add_uint32(OSMFormat::Info::optional_uint32_user_sid, m_primitive_block.store_in_stringtable_unsigned(object.user()));
-                        }
-                        if (m_options.add_visible_flag) {
-                            pbf_info.add_bool(OSMFormat::Info::optional_bool_visible, object.visible());
+                        switch (object->type()) {
+                            case osmium::item_type::node:
+                                block.add_node(*static_cast<const osmium::Node*>(object));
+                                break;
+                            case osmium::item_type::way:
+                                block.add_way(*static_cast<const osmium::Way*>(object));
+                                break;
+                            case osmium::item_type::relation:
+                                block.add_relation(*static_cast<const osmium::Relation*>(object));
+                                break;
+                            default:
+                                break;
                         }
                     }
+
+                    store_primitive_block(block, output);
+
+                    return output;
                 }
 
-                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
-                    if (!m_primitive_block.can_add(type)) {
-                        store_primitive_block();
-                        m_primitive_block.reset(type);
+            }; // class PBFOutputBlock
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                PBFOutputBlock m_output_block;
+
+                void submit_output_block() {
+                    if (m_output_block.empty()) {
+                        return;
                     }
+                    submit_to_queue(m_pool, m_output_queue, std::move(m_output_block));
+                    m_output_block = PBFOutputBlock{m_options};
                 }
 
             public:
 
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue),
-                    m_primitive_block(m_options) {
+                    m_output_block(m_options) {
 
                     if (!file.get("pbf_add_metadata").empty()) {
                         throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
@@ -565,6 +788,7 @@ namespace osmium {
                     m_options.add_historical_information_flag = file.has_multiple_object_versions();
                     m_options.add_visible_flag = file.has_multiple_object_versions();
                     m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.add_index_data = file.is_true("pbf_add_index_data");
 
                     const auto pbl = file.get("pbf_compression_level");
                     if (pbl.empty()) {
@@ -577,6 +801,11 @@ namespace osmium {
                             case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
                                 m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                m_options.compression_level = osmium::io::detail::zstd_default_compression_level();
 #endif
                                 break;
                         }
@@ -595,11 +824,20 @@ namespace osmium {
                             case pbf_compression::lz4:
 #ifdef OSMIUM_WITH_LZ4
                                 osmium::io::detail::lz4_check_compression_level(val);
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                osmium::io::detail::zstd_check_compression_level(val);
 #endif
                                 break;
                         }
                         m_options.compression_level = static_cast<int>(val);
                     }
+
+                    // The output block has a copy of the options, so it
+                    // has to be re-created after setting them.
+                    m_output_block = PBFOutputBlock{m_options};
                 }
 
                 void write_header(const osmium::io::Header& header) final {
@@ -652,100 +890,41 @@ namespace osmium {
                         pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
                     }
 
-                    m_output_queue.push(m_pool.submit(
+                    submit_to_queue(m_pool, m_output_queue,
                         SerializeBlob{std::move(data),
                                       pbf_blob_type::header,
                                       m_options.use_compression,
                                       m_options.compression_level}
-                        ));
+                        );
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
-
-                void write_end() final {
-                    store_primitive_block();
-                }
-
-                void node(const osmium::Node& node) {
-                    if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
-                        m_primitive_block.add_dense_node(node);
-                        return;
-                    }
-
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
-                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
-                    add_meta(node, pbf_node);
-
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, lonlat2int(node.location().lat_without_check()));
-                    pbf_node.add_sint64(OSMFormat::Node::required_sint64_lon, lonlat2int(node.location().lon_without_check()));
-                }
-
-                void way(const osmium::Way& way) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
-                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
-
-                    pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
-                    add_meta(way, pbf_way);
-
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_refs)};
-                        for (const auto& node_ref : way.nodes()) {
-                            field.add_element(delta_id.update(node_ref.ref()));
-                        }
-                    }
-
-                    if (m_options.locations_on_ways) {
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta_id;
-                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta_id.update(lonlat2int(node_ref.location().lon_without_check())));
-                            }
+                    const auto input = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                    for (const auto& object : input->select<osmium::OSMObject>()) {
+                        if (object.type() != osmium::item_type::node &&
+                            object.type() != osmium::item_type::way &&
+                            object.type() != osmium::item_type::relation) {
+                            continue;
                         }
-                        {
-                            osmium::DeltaEncode<int64_t, int64_t> delta_id;
-                            protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lat)};
-                            for (const auto& node_ref : way.nodes()) {
-                                field.add_element(delta_id.update(lonlat2int(node_ref.location().lat_without_check())));
-                            }
+                        if (!m_output_block.can_add(object)) {
+                            submit_output_block();
                         }
+                        m_output_block.add(input, object);
                     }
                 }
 
-                void relation(const osmium::Relation& relation) {
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
-                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
-
-                    pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
-                    add_meta(relation, pbf_relation);
-
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_int32_roles_sid)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(m_primitive_block.store_in_stringtable(member.role()));
-                        }
-                    }
-
-                    {
-                        osmium::DeltaEncode<object_id_type, int64_t> delta_id;
-                        protozero::packed_field_sint64 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_sint64_memids)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(delta_id.update(member.ref()));
-                        }
+                void write_raw_blob(std::string&& data) final {
+                    // An empty string in the output queue marks the end of
+                    // the data, so it must never be sent as a blob.
+                    if (data.empty()) {
+                        throw osmium::pbf_error{"can not write empty raw blob"};
                     }
+                    submit_output_block();
+                    send_to_output_queue(std::move(data));
+                }
 
-                    {
-                        protozero::packed_field_int32 field{pbf_relation, protozero::pbf_tag_type(OSMFormat::Relation::packed_MemberType_types)};
-                        for (const auto& member : relation.members()) {
-                            field.add_element(int32_t(osmium::item_type_to_nwr_index(member.type())));
-                        }
-                    }
+                void write_end() final {
+                    submit_output_block();
                 }
 
             }; // class PBFOutputFormat
@@ -753,7 +932,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_pbf_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::pbf,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::PBFOutputFormat{pool, file, output_queue};
             });
 
@@ -165,6 +165,20 @@ namespace osmium {
 
             } // namespace OSMFormat
 
+            // Osmium-specific contents of the BlobHeader.indexdata field,
+            // not part of the OSM-binary specification.
+
+            namespace OsmiumFormat {
+
+                enum class BlobIndexData : protozero::pbf_tag_type {
+                    required_string_format       = 1,
+                    required_uint32_entity_types = 2,
+                    optional_sint64_min_id       = 3,
+                    optional_sint64_max_id       = 4
+                };
+
+            } // namespace OsmiumFormat
+
         } // namespace detail
 
     } // namespace io
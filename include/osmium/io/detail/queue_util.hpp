@@ -34,12 +34,13 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/ordered_result_queue.hpp>
+#include <osmium/thread/pool.hpp>
 
-#include <cassert>
+#include <cstddef>
 #include <exception>
-#include <future>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -48,47 +49,107 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * All queues between the threads of the Reader and Writer have
+             * exactly one producer and one consumer. Results can be filled
+             * in out of order by tasks in the thread pool, the consumer
+             * always gets them in order. Exceptions are transported in the
+             * queue, too.
+             */
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using result_queue_type = osmium::thread::OrderedResultQueue<T>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
              * The "end of file" is marked by an invalid Buffer.
-             * The buffers are wrapped in a std::future so that they can also
-             * transport exceptions. The future also helps with keeping the
-             * data in order.
              */
-            using future_buffer_queue_type = future_queue_type<osmium::memory::Buffer>;
+            using buffer_queue_type = result_queue_type<osmium::memory::Buffer>;
 
             /**
              * This type of queue contains OSM file data in the form it is
              * stored on disk, ie encoded as XML, PBF, etc.
              * The "end of file" is marked by an empty string.
-             * The strings are wrapped in a std::future so that they can also
-             * transport exceptions. The future also helps with keeping the
-             * data in order.
              */
-            using future_string_queue_type = future_queue_type<std::string>;
+            using string_queue_type = result_queue_type<std::string>;
 
             template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
-                std::promise<T> promise;
-                queue.push(promise.get_future());
-                promise.set_value(std::forward<T>(data));
+            inline void add_to_queue(result_queue_type<T>& queue, T&& data) {
+                queue.push(std::forward<T>(data));
             }
 
             template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, std::exception_ptr&& exception) {
-                std::promise<T> promise;
-                queue.push(promise.get_future());
-                promise.set_exception(std::move(exception));
+            inline void add_to_queue(result_queue_type<T>& queue, std::exception_ptr&& exception) {
+                queue.push_exception(std::move(exception));
             }
 
             template <typename T>
-            inline void add_end_of_data_to_queue(future_queue_type<T>& queue) {
+            inline void add_end_of_data_to_queue(result_queue_type<T>& queue) {
                 add_to_queue<T>(queue, T{});
             }
 
+            /**
+             * Task that runs a function and puts its result or exception
+             * into a reserved slot of a result queue.
+             */
+            template <typename T, typename TFunction>
+            class ordered_task {
+
+                result_queue_type<T>* m_queue;
+                std::size_t m_sequence;
+                TFunction m_function;
+
+            public:
+
+                ordered_task(result_queue_type<T>& queue, std::size_t sequence, TFunction&& function) :
+                    m_queue(&queue),
+                    m_sequence(sequence),
+                    m_function(std::move(function)) {
+                }
+
+                void operator()() {
+                    try {
+                        m_queue->set_value(m_sequence, m_function());
+                    } catch (...) {
+                        m_queue->set_exception(m_sequence, std::current_exception());
+                    }
+                }
+
+            }; // class ordered_task
+
+            /**
+             * Run the function in the thread pool and put its result into
+             * the queue. The result will be in the queue at the position
+             * of this call relative to other calls adding to the queue,
+             * regardless of when the function finishes.
+             */
+            template <typename T, typename TFunction>
+            inline void submit_to_queue(osmium::thread::Pool& pool, result_queue_type<T>& queue, TFunction&& function) {
+                using function_type = typename std::decay<TFunction>::type;
+                const auto sequence = queue.reserve();
+                try {
+                    pool.execute(ordered_task<T, function_type>{queue, sequence, function_type{std::forward<TFunction>(function)}});
+                } catch (...) {
+                    queue.set_exception(sequence, std::current_exception());
+                    throw;
+                }
+            }
+
+            /**
+             * Pop all results from the queue and throw them away including
+             * any exceptions. This waits for all tasks still working on
+             * reserved slots, they might still use the queue.
+             */
+            template <typename T>
+            inline void drain_queue(result_queue_type<T>& queue) noexcept {
+                while (!queue.empty()) {
+                    try {
+                        queue.pop();
+                    } catch (...) {
+                        // Ignore any exceptions.
+                    }
+                }
+            }
+
             inline bool at_end_of_data(const std::string& data) noexcept {
                 return data.empty();
             }
@@ -100,12 +161,12 @@ namespace osmium {
             template <typename T>
             class queue_wrapper {
 
-                future_queue_type<T>& m_queue;
+                result_queue_type<T>& m_queue;
                 bool m_has_reached_end_of_data;
 
             public:
 
-                explicit queue_wrapper(future_queue_type<T>& queue) :
+                explicit queue_wrapper(result_queue_type<T>& queue) :
                     m_queue(queue),
                     m_has_reached_end_of_data(false) {
                 }
@@ -137,10 +198,7 @@ namespace osmium {
                 T pop() {
                     T data;
                     if (!m_has_reached_end_of_data) {
-                        std::future<T> data_future;
-                        m_queue.wait_and_pop(data_future);
-                        assert(data_future.valid());
-                        data = std::move(data_future.get());
+                        data = m_queue.pop();
                         if (at_end_of_data(data)) {
                             m_has_reached_end_of_data = true;
                         }
@@ -35,6 +35,8 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/thread/trace.hpp>
 #include <osmium/thread/util.hpp>
 
 #include <atomic>
@@ -59,7 +61,8 @@ namespace osmium {
 
                 // only used in the sub-thread
                 osmium::io::Decompressor& m_decompressor;
-                future_string_queue_type& m_queue;
+                string_queue_type& m_queue;
+                reader_counters* m_counters;
 
                 // used in both threads
                 std::atomic<bool> m_done;
@@ -72,7 +75,16 @@ namespace osmium {
 
                     try {
                         while (!m_done) {
-                            std::string data{m_decompressor.read()};
+                            const auto start = osmium::thread::detail::stats_clock::now();
+                            std::string data;
+                            {
+                                OSMIUM_TRACE_SCOPE("read");
+                                data = m_decompressor.read();
+                            }
+                            if (m_counters) {
+                                m_counters->read_busy.add_since(start);
+                                m_counters->bytes_decompressed.fetch_add(data.size(), std::memory_order_relaxed);
+                            }
                             if (at_end_of_data(data)) {
                                 break;
                             }
@@ -90,9 +102,11 @@ namespace osmium {
             public:
 
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  string_queue_type& queue,
+                                  reader_counters* counters = nullptr) :
                     m_decompressor(decompressor),
                     m_queue(queue),
+                    m_counters(counters),
                     m_done(false),
                     m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
                 }
@@ -33,7 +33,10 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/swar.hpp>
+
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -183,6 +186,104 @@ namespace osmium {
                 return cp;
             }
 
+            // Two-digit lookup table for formatting decimal numbers.
+            inline const char* decimal_digit_pairs() noexcept {
+                static const char pairs[] =
+                    "0001020304050607080910111213141516171819"
+                    "2021222324252627282930313233343536373839"
+                    "4041424344454647484950515253545556575859"
+                    "6061626364656667686970717273747576777879"
+                    "8081828384858687888990919293949596979899";
+                return pairs;
+            }
+
+            // Write the decimal digits of value to out and return the end
+            // of the written digits. Needs space for up to 20 characters.
+            // Two digits are written at a time using a lookup table.
+            inline char* format_uint(char* out, uint64_t value) noexcept {
+                const char* const pairs = decimal_digit_pairs();
+
+                char buffer[20];
+                char* p = buffer + sizeof(buffer);
+                while (value >= 100) {
+                    const auto index = (value % 100) * 2;
+                    value /= 100;
+                    p -= 2;
+                    std::memcpy(p, pairs + index, 2);
+                }
+                if (value >= 10) {
+                    p -= 2;
+                    std::memcpy(p, pairs + value * 2, 2);
+                } else {
+                    *--p = static_cast<char>('0' + value);
+                }
+
+                const auto size = static_cast<std::size_t>(buffer + sizeof(buffer) - p);
+                std::memcpy(out, p, size);
+                return out + size;
+            }
+
+            // Write value with a leading minus sign if it is negative to out
+            // and return the end of the written characters. Needs space for
+            // up to 20 characters.
+            inline char* format_int(char* out, const int64_t value) noexcept {
+                if (value < 0) {
+                    *out++ = '-';
+                    return format_uint(out, 0 - static_cast<uint64_t>(value));
+                }
+                return format_uint(out, static_cast<uint64_t>(value));
+            }
+
+            // Write a coordinate as stored in osmium::Location (ie. in units
+            // of 1/10^7 degree) as decimal number without trailing zeros to
+            // out and return the end of the written characters. Needs space
+            // for up to 12 characters. The fractional part always has seven
+            // digits, so they are written directly from the lookup table
+            // without a loop.
+            inline char* format_location_coordinate(char* out, const int32_t value) noexcept {
+                const char* const pairs = decimal_digit_pairs();
+
+                uint32_t v = static_cast<uint32_t>(value);
+                if (value < 0) {
+                    *out++ = '-';
+                    v = 0 - v;
+                }
+
+                out = format_uint(out, v / 10000000U);
+
+                uint32_t fraction = v % 10000000U;
+                if (fraction == 0) {
+                    return out;
+                }
+
+                *out++ = '.';
+                *out = static_cast<char>('0' + fraction / 1000000U);
+                fraction %= 1000000U;
+                std::memcpy(out + 1, pairs + (fraction / 10000U) * 2, 2);
+                fraction %= 10000U;
+                std::memcpy(out + 3, pairs + (fraction / 100U) * 2, 2);
+                std::memcpy(out + 5, pairs + (fraction % 100U) * 2, 2);
+
+                out += 7;
+                while (out[-1] == '0') {
+                    --out;
+                }
+                return out;
+            }
+
+            // Append value as decimal number to out.
+            inline void append_int(std::string& out, const int64_t value) {
+                char buffer[20];
+                out.append(buffer, format_int(buffer, value));
+            }
+
+            // Append a coordinate as stored in osmium::Location to out. This
+            // gives the same result as Location::as_string() but is faster.
+            inline void append_location_coordinate(std::string& out, const int32_t value) {
+                char buffer[12];
+                out.append(buffer, format_location_coordinate(buffer, value));
+            }
+
             // Write out the value with exactly two hex digits.
             inline void append_2_hex_digits(std::string& out, uint32_t value, const char* const hex_digits) {
                 out += hex_digits[(value >> 4U) & 0xfU];
@@ -207,7 +308,28 @@ namespace osmium {
                 static const char* lookup_hex = "0123456789abcdef";
                 const char* end = data + std::strlen(data);
 
+                // Start of the current run of characters which are
+                // copied unchanged.
+                const char* run = data;
+
                 while (data != end) {
+                    // Skip ASCII characters which are never escaped.
+                    data = osmium::detail::find_first_byte(data, end, [](const uint64_t word) {
+                        return osmium::detail::swar_has_non_ascii(word) ||
+                               osmium::detail::swar_has_less(word, 0x21) ||
+                               osmium::detail::swar_has_byte(word, 0x25) ||
+                               osmium::detail::swar_has_byte(word, 0x2c) ||
+                               osmium::detail::swar_has_byte(word, 0x3d) ||
+                               osmium::detail::swar_has_byte(word, 0x40) ||
+                               osmium::detail::swar_has_byte(word, 0x7f);
+                    }, [](const unsigned char c) {
+                        // bit mask of 0x00-0x20, 0x25, 0x2c, and 0x3d
+                        return c < 64 ? ((0x20001021ffffffffULL >> c) & 1U) : (c == 0x40 || c >= 0x7f);
+                    });
+                    if (data == end) {
+                        break;
+                    }
+
                     const char* last = data;
                     const uint32_t c = next_utf8_codepoint(&data, end);
 
@@ -224,22 +346,43 @@ namespace osmium {
                         (0x0041 <= c && c <= 0x007e) ||
                         (0x00a1 <= c && c <= 0x00ac) ||
                         (0x00ae <= c && c <= 0x05ff)) {
-                        out.append(last, data);
+                        continue;
+                    }
+
+                    out.append(run, last);
+                    out += '%';
+                    if (c <= 0xff) {
+                        append_2_hex_digits(out, c, lookup_hex);
                     } else {
-                        out += '%';
-                        if (c <= 0xff) {
-                            append_2_hex_digits(out, c, lookup_hex);
-                        } else {
-                            append_min_4_hex_digits(out, c, lookup_hex);
-                        }
-                        out += '%';
+                        append_min_4_hex_digits(out, c, lookup_hex);
                     }
+                    out += '%';
+                    run = data;
                 }
+
+                out.append(run, end);
             }
 
             inline void append_xml_encoded_string(std::string& out, const char* data) {
-                for (; *data != '\0'; ++data) {
-                    switch (*data) {
+                const char* end = data + std::strlen(data);
+
+                while (data != end) {
+                    const char* special = osmium::detail::find_first_byte(data, end, [](const uint64_t word) {
+                        return osmium::detail::swar_has_less(word, 0x0e) ||
+                               osmium::detail::swar_has_byte(word, '&') ||
+                               osmium::detail::swar_has_byte(word, '\"') ||
+                               osmium::detail::swar_has_byte(word, '\'') ||
+                               osmium::detail::swar_has_byte(word, '<') ||
+                               osmium::detail::swar_has_byte(word, '>');
+                    }, [](const unsigned char c) {
+                        // bit mask of \t, \n, \r, ", &, ', <, and >
+                        return c < 64 && ((0x500000c400002600ULL >> c) & 1U);
+                    });
+                    out.append(data, special);
+                    if (special == end) {
+                        break;
+                    }
+                    switch (*special) {
                         case '&':  out += "&amp;";  break;
                         case '\"': out += "&quot;"; break;
                         case '\'': out += "&apos;"; break;
@@ -247,9 +390,9 @@ namespace osmium {
                         case '>':  out += "&gt;";   break;
                         case '\n': out += "&#xA;";  break;
                         case '\r': out += "&#xD;";  break;
-                        case '\t': out += "&#x9;";  break;
-                        default:   out += *data;    break;
+                        default:   out += "&#x9;";  break;
                     }
+                    data = special + 1;
                 }
             }
 
@@ -257,9 +400,29 @@ namespace osmium {
                 static const char* lookup_hex = "0123456789ABCDEF";
                 const char* end = data + std::strlen(data);
 
+                // Start of the current run of characters which are
+                // copied unchanged.
+                const char* run = data;
+
                 while (data != end) {
+                    // Skip ASCII characters which are never escaped.
+                    data = osmium::detail::find_first_byte(data, end, [](const uint64_t word) {
+                        return osmium::detail::swar_has_non_ascii(word) ||
+                               osmium::detail::swar_has_less(word, 0x20) ||
+                               osmium::detail::swar_has_byte(word, 0x22) ||
+                               osmium::detail::swar_has_byte(word, 0x3c) ||
+                               osmium::detail::swar_has_byte(word, 0x3e) ||
+                               osmium::detail::swar_has_byte(word, 0x7f);
+                    }, [](const unsigned char c) {
+                        // bit mask of 0x00-0x1f, 0x22, 0x3c, and 0x3e
+                        return c < 64 ? ((0x50000004ffffffffULL >> c) & 1U) : c >= 0x7f;
+                    });
+                    if (data == end) {
+                        break;
+                    }
+
                     const char* last = data;
-                    uint32_t c = next_utf8_codepoint(&data, end);
+                    const uint32_t c = next_utf8_codepoint(&data, end);
 
                     // This is a list of Unicode code points that we let
                     // through instead of escaping them. It is incomplete
@@ -272,15 +435,19 @@ namespace osmium {
                         (0x003f <= c && c <= 0x007e) ||
                         (0x00a1 <= c && c <= 0x00ac) ||
                         (0x00ae <= c && c <= 0x05ff)) {
-                        out.append(last, data);
-                    } else {
-                        out.append(prefix);
-                        out.append("<U+");
-                        append_min_4_hex_digits(out, c, lookup_hex);
-                        out.append(">");
-                        out.append(suffix);
+                        continue;
                     }
+
+                    out.append(run, last);
+                    out.append(prefix);
+                    out.append("<U+");
+                    append_min_4_hex_digits(out, c, lookup_hex);
+                    out.append(">");
+                    out.append(suffix);
+                    run = data;
                 }
+
+                out.append(run, end);
             }
 
             template <typename TOutputIterator>
@@ -35,8 +35,10 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/thread/util.hpp>
 
+#include <atomic>
 #include <exception>
 #include <future>
 #include <memory>
@@ -59,15 +61,18 @@ namespace osmium {
                 queue_wrapper<std::string> m_queue;
                 std::unique_ptr<osmium::io::Compressor> m_compressor;
                 std::promise<std::size_t> m_promise;
+                writer_counters* m_counters;
 
             public:
 
-                WriteThread(future_string_queue_type& input_queue,
+                WriteThread(string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
-                            std::promise<std::size_t>&& promise) :
+                            std::promise<std::size_t>&& promise,
+                            writer_counters* counters = nullptr) :
                     m_queue(input_queue),
                     m_compressor(std::move(compressor)),
-                    m_promise(std::move(promise)) {
+                    m_promise(std::move(promise)),
+                    m_counters(counters) {
                 }
 
                 WriteThread(const WriteThread&) = delete;
@@ -87,7 +92,14 @@ namespace osmium {
                             if (at_end_of_data(data)) {
                                 break;
                             }
-                            m_compressor->write(data);
+                            if (m_counters) {
+                                const auto start = osmium::thread::detail::stats_clock::now();
+                                m_compressor->write(data);
+                                m_counters->write_busy.add_since(start);
+                                m_counters->bytes_encoded.fetch_add(data.size(), std::memory_order_relaxed);
+                            } else {
+                                m_compressor->write(data);
+                            }
                         }
                         m_compressor->close();
                         m_promise.set_value(m_compressor->file_size());
@@ -37,9 +37,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/changeset.hpp>
@@ -54,18 +56,27 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/thread/trace.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/swar.hpp>
 
 #include <expat.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <exception>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -94,6 +105,19 @@ namespace osmium {
             error_string(XML_ErrorString(error_code)) {
         }
 
+        xml_error(const uint64_t l, const uint64_t c, const XML_Error code) :
+            io_error(std::string{"XML parsing error at line "}
+                    + std::to_string(l)
+                    + ", column "
+                    + std::to_string(c)
+                    + ": "
+                    + XML_ErrorString(code)),
+            line(l),
+            column(c),
+            error_code(code),
+            error_string(XML_ErrorString(code)) {
+        }
+
         explicit xml_error(const std::string& message) :
             io_error(message),
             error_code(),
@@ -125,11 +149,13 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser final : public Parser {
+            /**
+             * Builds OSM objects from the elements of an OSM XML document
+             * reported by one of the XML parsers.
+             */
+            class XMLElementHandler {
 
-                enum {
-                    initial_buffer_size = 1024UL * 1024UL
-                };
+            public:
 
                 enum class context {
                     osm,
@@ -152,12 +178,13 @@ namespace osmium {
                     other
                 }; // enum class context
 
+            private:
+
                 std::vector<context> m_context_stack;
 
                 osmium::io::Header m_header{};
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
+                osmium::memory::Buffer m_buffer;
 
                 std::unique_ptr<osmium::builder::NodeBuilder>                m_node_builder{};
                 std::unique_ptr<osmium::builder::WayBuilder>                 m_way_builder{};
@@ -171,108 +198,10 @@ namespace osmium {
 
                 std::string m_comment_text;
 
-                /**
-                 * A C++ wrapper for the Expat parser that makes sure no memory
-                 * is leaked.
-                 */
-                class ExpatXMLParser {
-
-                    XML_Parser m_parser;
-                    std::exception_ptr m_exception_ptr{};
-
-                    template <typename TFunc>
-                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
-                        if (m_exception_ptr) {
-                            return;
-                        }
-                        try {
-                            std::forward<TFunc>(func)(xml_parser);
-                        } catch (...) {
-                            m_exception_ptr = std::current_exception();
-                            XML_StopParser(m_parser, 0);
-                        }
-                    }
-
-                    template <typename TFunc>
-                    static void wrap(void* data, TFunc&& func) noexcept {
-                        assert(data);
-                        auto& xml_parser = *static_cast<XMLParser*>(data);
-                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
-                    }
-
-                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.start_element(element, attrs);
-                        });
-                    }
-
-                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.end_element(element);
-                        });
-                    }
-
-                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
-                        wrap(data, [&](XMLParser& xml_parser) {
-                            xml_parser.characters(text, len);
-                        });
-                    }
-
-                    // This handler is called when there are any XML entities
-                    // declared in the OSM file. Entities are normally not used,
-                    // but they can be misused. See
-                    // https://en.wikipedia.org/wiki/Billion_laughs
-                    // The handler will just throw an error.
-                    static void entity_declaration_handler(void* data,
-                            const XML_Char* /*entityName*/,
-                            int /*is_parameter_entity*/,
-                            const XML_Char* /*value*/,
-                            int /*value_length*/,
-                            const XML_Char* /*base*/,
-                            const XML_Char* /*systemId*/,
-                            const XML_Char* /*publicId*/,
-                            const XML_Char* /*notationName*/) noexcept {
-                        wrap(data, [&](XMLParser& /*xml_parser*/) {
-                            throw osmium::xml_error{"XML entities are not supported"};
-                        });
-                    }
-
-                public:
-
-                    explicit ExpatXMLParser(void* callback_object) :
-                        m_parser(XML_ParserCreate(nullptr)) {
-                        if (!m_parser) {
-                            throw osmium::io_error{"Internal error: Can not create parser"};
-                        }
-                        XML_SetUserData(m_parser, callback_object);
-                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
-                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
-                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
-                    }
-
-                    ExpatXMLParser(const ExpatXMLParser&) = delete;
-                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
-
-                    ExpatXMLParser(ExpatXMLParser&&) = delete;
-                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
-
-                    ~ExpatXMLParser() noexcept {
-                        XML_ParserFree(m_parser);
-                    }
-
-                    void operator()(const std::string& data, bool last) {
-                        assert(data.size() < std::numeric_limits<int>::max());
-                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
-                            if (m_exception_ptr) {
-                                std::rethrow_exception(m_exception_ptr);
-                            }
-                            throw osmium::xml_error{m_parser};
-                        }
-                    }
-
-                }; // class ExpatXMLParser
+                osmium::osm_entity_bits::type m_read_types;
+                const osmium::io::read_filter* m_filter;
 
-                ExpatXMLParser* m_expat_xml_parser{nullptr};
+                bool m_header_is_complete = false;
 
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T&& check) {
@@ -350,8 +279,8 @@ namespace osmium {
                     m_tl_builder->add_tag(k, v);
                 }
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
+                void mark_header_as_done() noexcept {
+                    m_header_is_complete = true;
                 }
 
                 void top_level_element(const XML_Char* element, const XML_Char** attrs) {
@@ -396,7 +325,7 @@ namespace osmium {
                     if (!std::strcmp(element, "node")) {
                         m_context_stack.push_back(context::node);
                         mark_header_as_done();
-                        if (read_types() & osmium::osm_entity_bits::node) {
+                        if (m_read_types & osmium::osm_entity_bits::node) {
                             m_node_builder.reset(new osmium::builder::NodeBuilder{m_buffer});
                             m_node_builder->set_user(init_object(m_node_builder->object(), attrs));
                         }
@@ -406,7 +335,7 @@ namespace osmium {
                     if (!std::strcmp(element, "way")) {
                         m_context_stack.push_back(context::way);
                         mark_header_as_done();
-                        if (read_types() & osmium::osm_entity_bits::way) {
+                        if (m_read_types & osmium::osm_entity_bits::way) {
                             m_way_builder.reset(new osmium::builder::WayBuilder{m_buffer});
                             m_way_builder->set_user(init_object(m_way_builder->object(), attrs));
                         }
@@ -416,7 +345,7 @@ namespace osmium {
                     if (!std::strcmp(element, "relation")) {
                         m_context_stack.push_back(context::relation);
                         mark_header_as_done();
-                        if (read_types() & osmium::osm_entity_bits::relation) {
+                        if (m_read_types & osmium::osm_entity_bits::relation) {
                             m_relation_builder.reset(new osmium::builder::RelationBuilder{m_buffer});
                             m_relation_builder->set_user(init_object(m_relation_builder->object(), attrs));
                         }
@@ -430,7 +359,7 @@ namespace osmium {
                     if (!std::strcmp(element, "changeset")) {
                         m_context_stack.push_back(context::changeset);
                         mark_header_as_done();
-                        if (read_types() & osmium::osm_entity_bits::changeset) {
+                        if (m_read_types & osmium::osm_entity_bits::changeset) {
                             m_changeset_builder.reset(new osmium::builder::ChangesetBuilder{m_buffer});
                             init_changeset(*m_changeset_builder, attrs);
                         }
@@ -475,6 +404,44 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                XMLElementHandler(osmium::memory::Buffer&& buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_filter* filter) :
+                    m_buffer(std::move(buffer)),
+                    m_read_types(read_types),
+                    m_filter(filter) {
+                }
+
+                /**
+                 * Set the context for parsing a fragment of a document
+                 * inside the given elements.
+                 */
+                void set_context(const std::vector<context>& contexts) {
+                    m_context_stack = contexts;
+                    m_header_is_complete = true;
+                }
+
+                const std::vector<context>& context_stack() const noexcept {
+                    return m_context_stack;
+                }
+
+                const osmium::io::Header& header() const noexcept {
+                    return m_header;
+                }
+
+                /**
+                 * Has the header been completely read? This is the case
+                 * as soon as the first OSM object or the end of the
+                 * document was found.
+                 */
+                bool header_is_complete() const noexcept {
+                    return m_header_is_complete;
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
                 void start_element(const XML_Char* element, const XML_Char** attrs) {
                     if (m_context_stack.empty()) {
                         top_level_element(element, attrs);
@@ -497,7 +464,7 @@ namespace osmium {
                         case context::node:
                             if (!std::strcmp(element, "tag")) {
                                 m_context_stack.push_back(context::tag);
-                                if (read_types() & osmium::osm_entity_bits::node) {
+                                if (m_read_types & osmium::osm_entity_bits::node) {
                                     get_tag(*m_node_builder, attrs);
                                 }
                             } else {
@@ -507,7 +474,7 @@ namespace osmium {
                         case context::way:
                             if (!std::strcmp(element, "nd")) {
                                 m_context_stack.push_back(context::nd);
-                                if (read_types() & osmium::osm_entity_bits::way) {
+                                if (m_read_types & osmium::osm_entity_bits::way) {
                                     m_tl_builder.reset();
 
                                     if (!m_wnl_builder) {
@@ -528,7 +495,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "tag")) {
                                 m_context_stack.push_back(context::tag);
-                                if (read_types() & osmium::osm_entity_bits::way) {
+                                if (m_read_types & osmium::osm_entity_bits::way) {
                                     m_wnl_builder.reset();
                                     get_tag(*m_way_builder, attrs);
                                 }
@@ -541,7 +508,7 @@ namespace osmium {
                         case context::relation:
                             if (!std::strcmp(element, "member")) {
                                 m_context_stack.push_back(context::member);
-                                if (read_types() & osmium::osm_entity_bits::relation) {
+                                if (m_read_types & osmium::osm_entity_bits::relation) {
                                     m_tl_builder.reset();
 
                                     if (!m_rml_builder) {
@@ -572,7 +539,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "tag")) {
                                 m_context_stack.push_back(context::tag);
-                                if (read_types() & osmium::osm_entity_bits::relation) {
+                                if (m_read_types & osmium::osm_entity_bits::relation) {
                                     m_rml_builder.reset();
                                     get_tag(*m_relation_builder, attrs);
                                 }
@@ -591,7 +558,7 @@ namespace osmium {
                         case context::changeset:
                             if (!std::strcmp(element, "discussion")) {
                                 m_context_stack.push_back(context::discussion);
-                                if (read_types() & osmium::osm_entity_bits::changeset) {
+                                if (m_read_types & osmium::osm_entity_bits::changeset) {
                                     m_tl_builder.reset();
                                     if (!m_changeset_discussion_builder) {
                                         m_changeset_discussion_builder.reset(new osmium::builder::ChangesetDiscussionBuilder{*m_changeset_builder});
@@ -599,7 +566,7 @@ namespace osmium {
                                 }
                             } else if (!std::strcmp(element, "tag")) {
                                 m_context_stack.push_back(context::tag);
-                                if (read_types() & osmium::osm_entity_bits::changeset) {
+                                if (m_read_types & osmium::osm_entity_bits::changeset) {
                                     m_changeset_discussion_builder.reset();
                                     get_tag(*m_changeset_builder, attrs);
                                 }
@@ -610,7 +577,7 @@ namespace osmium {
                         case context::discussion:
                             if (!std::strcmp(element, "comment")) {
                                 m_context_stack.push_back(context::comment);
-                                if (read_types() & osmium::osm_entity_bits::changeset) {
+                                if (m_read_types & osmium::osm_entity_bits::changeset) {
                                     osmium::Timestamp date;
                                     osmium::user_id_type uid = 0;
                                     const char* user = "";
@@ -673,31 +640,28 @@ namespace osmium {
                             break;
                         case context::node:
                             assert(!std::strcmp(element, "node"));
-                            if (read_types() & osmium::osm_entity_bits::node) {
+                            if (m_read_types & osmium::osm_entity_bits::node) {
                                 m_tl_builder.reset();
                                 m_node_builder.reset();
-                                m_buffer.commit();
-                                flush_buffer();
+                                commit_if_wanted(m_buffer, m_filter);
                             }
                             break;
                         case context::way:
                             assert(!std::strcmp(element, "way"));
-                            if (read_types() & osmium::osm_entity_bits::way) {
+                            if (m_read_types & osmium::osm_entity_bits::way) {
                                 m_tl_builder.reset();
                                 m_wnl_builder.reset();
                                 m_way_builder.reset();
-                                m_buffer.commit();
-                                flush_buffer();
+                                commit_if_wanted(m_buffer, m_filter);
                             }
                             break;
                         case context::relation:
                             assert(!std::strcmp(element, "relation"));
-                            if (read_types() & osmium::osm_entity_bits::relation) {
+                            if (m_read_types & osmium::osm_entity_bits::relation) {
                                 m_tl_builder.reset();
                                 m_rml_builder.reset();
                                 m_relation_builder.reset();
-                                m_buffer.commit();
-                                flush_buffer();
+                                commit_if_wanted(m_buffer, m_filter);
                             }
                             break;
                         case context::tag:
@@ -708,12 +672,11 @@ namespace osmium {
                             break;
                         case context::changeset:
                             assert(!std::strcmp(element, "changeset"));
-                            if (read_types() & osmium::osm_entity_bits::changeset) {
+                            if (m_read_types & osmium::osm_entity_bits::changeset) {
                                 m_tl_builder.reset();
                                 m_changeset_discussion_builder.reset();
                                 m_changeset_builder.reset();
-                                m_buffer.commit();
-                                flush_buffer();
+                                commit_if_wanted(m_buffer, m_filter);
                             }
                             break;
                         case context::discussion:
@@ -724,7 +687,7 @@ namespace osmium {
                             break;
                         case context::text:
                             assert(!std::strcmp(element, "text"));
-                            if (read_types() & osmium::osm_entity_bits::changeset) {
+                            if (m_read_types & osmium::osm_entity_bits::changeset) {
                                 m_changeset_discussion_builder->add_comment_text(m_comment_text);
                                 m_comment_text.clear();
                             }
@@ -742,52 +705,1408 @@ namespace osmium {
                 }
 
                 void characters(const XML_Char* text, int len) {
-                    if ((read_types() & osmium::osm_entity_bits::changeset) &&
+                    if ((m_read_types & osmium::osm_entity_bits::changeset) &&
                         !m_context_stack.empty() &&
                         m_context_stack.back() == context::text) {
                         m_comment_text.append(text, len);
                     }
                 }
 
-                void flush_buffer() {
-                    if (m_buffer.has_nested_buffers()) {
-                        std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
-                        send_to_output_queue(std::move(*buffer_ptr));
+            }; // class XMLElementHandler
+
+            inline bool xml_is_space(const char c) noexcept {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+            }
+
+            // Find the string str of length len in the range [p, e).
+            inline const char* xml_find(const char* p, const char* const e, const char* str, const std::size_t len) noexcept {
+                while (static_cast<std::size_t>(e - p) >= len) {
+                    p = static_cast<const char*>(std::memchr(p, str[0], static_cast<std::size_t>(e - p) - len + 1));
+                    if (!p) {
+                        return nullptr;
+                    }
+                    if (!std::memcmp(p, str, len)) {
+                        return p;
                     }
+                    ++p;
                 }
+                return nullptr;
+            }
 
-            public:
+            inline bool xml_is_utf8_continuation(const char c) noexcept {
+                return (static_cast<unsigned char>(c) & 0xc0U) == 0x80U;
+            }
 
-                explicit XMLParser(parser_arguments& args) :
-                    Parser(args) {
+            // Advance line and column over the text in [p, e). Like Expat
+            // columns are counted in characters, not bytes.
+            inline void xml_update_position(const char* p, const char* const e, uint64_t& line, uint64_t& column) noexcept {
+                const char* line_start = nullptr;
+                while (const auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(e - p)))) {
+                    ++line;
+                    p = nl + 1;
+                    line_start = p;
                 }
+                if (line_start) {
+                    column = 0;
+                }
+                for (; p != e; ++p) {
+                    if (!xml_is_utf8_continuation(*p)) {
+                        ++column;
+                    }
+                }
+            }
 
-                XMLParser(const XMLParser&) = delete;
-                XMLParser& operator=(const XMLParser&) = delete;
+            // Returns the length of the UTF-8 encoded character starting
+            // with the non-ASCII byte at p if it is valid and allowed in
+            // XML documents, 0 otherwise.
+            inline std::size_t xml_utf8_char_length(const char* p, const char* const e) noexcept {
+                const auto c = static_cast<unsigned char>(p[0]);
+                const auto size = e - p;
+                if (c < 0xc2U) { // continuation byte or overlong encoding
+                    return 0;
+                }
+                if (c < 0xe0U) {
+                    return (size >= 2 && xml_is_utf8_continuation(p[1])) ? 2 : 0;
+                }
+                const auto c1 = static_cast<unsigned char>(size >= 2 ? p[1] : 0);
+                if (c < 0xf0U) {
+                    if (size < 3 || !xml_is_utf8_continuation(p[1]) || !xml_is_utf8_continuation(p[2]) ||
+                        (c == 0xe0U && c1 < 0xa0U) || // overlong encoding
+                        (c == 0xedU && c1 >= 0xa0U) || // surrogates
+                        (c == 0xefU && c1 == 0xbfU && static_cast<unsigned char>(p[2]) >= 0xbeU)) { // U+FFFE, U+FFFF
+                        return 0;
+                    }
+                    return 3;
+                }
+                if (c < 0xf5U) {
+                    if (size < 4 || !xml_is_utf8_continuation(p[1]) || !xml_is_utf8_continuation(p[2]) || !xml_is_utf8_continuation(p[3]) ||
+                        (c == 0xf0U && c1 < 0x90U) || // overlong encoding
+                        (c == 0xf4U && c1 >= 0x90U)) { // above U+10FFFF
+                        return 0;
+                    }
+                    return 4;
+                }
+                return 0;
+            }
 
-                XMLParser(XMLParser&&) = delete;
-                XMLParser& operator=(XMLParser&&) = delete;
+            // Find the first byte in [p, e) which doesn't start a character
+            // allowed in XML documents. Returns nullptr if there is none.
+            inline const char* xml_find_invalid_char(const char* p, const char* const e) noexcept {
+                while (p != e) {
+                    // skip over plain ASCII text without control characters
+                    while (e - p >= 8) {
+                        const uint64_t word = osmium::detail::swar_load(p);
+                        if (osmium::detail::swar_has_non_ascii(word) || osmium::detail::swar_has_less(word, 0x20)) {
+                            break;
+                        }
+                        p += 8;
+                    }
+                    if (p == e) {
+                        break;
+                    }
+                    const auto c = static_cast<unsigned char>(*p);
+                    if (c >= 0x80U) {
+                        const auto len = xml_utf8_char_length(p, e);
+                        if (len == 0) {
+                            return p;
+                        }
+                        p += len;
+                    } else if (c < 0x20U && c != '\t' && c != '\n' && c != '\r') {
+                        return p;
+                    } else {
+                        ++p;
+                    }
+                }
+                return nullptr;
+            }
 
-                ~XMLParser() noexcept override = default;
+            /**
+             * A parser for the subset of XML used in OSM files. It
+             * understands elements, attributes, character data, CDATA
+             * sections, comments, processing instructions, the predefined
+             * entities and character references and calls the
+             * start_element(), end_element(), and characters() functions of
+             * the handler like the ExpatXMLParser does.
+             *
+             * Documents with a DOCTYPE declaration, an encoding other
+             * than UTF-8, or anything else unusual before the root element
+             * are left to Expat: In that case the function call operator
+             * returns false and the (unchanged) input data seen so far
+             * can be retrieved with release_input(). Errors after the
+             * start of the root element are reported with the same error
+             * codes Expat uses.
+             *
+             * It can also parse fragments of a document (see parse_chunk()).
+             */
+            template <typename THandler>
+            class FastXMLParser {
+
+                enum class state {
+                    prolog,
+                    document,
+                    epilog
+                };
 
-                void run() override {
-                    osmium::thread::set_thread_name("_osmium_xml_in");
+                THandler& m_handler;
+
+                // Input data, everything before m_pos has been parsed.
+                std::string m_data{};
+                std::size_t m_pos = 0;
+
+                // Line and column of the beginning of m_data.
+                uint64_t m_line = 1;
+                uint64_t m_column = 0;
+
+                // Names of the currently open elements. The strings are
+                // re-used to avoid memory allocations.
+                std::vector<std::string> m_elements{};
+                std::size_t m_depth = 0;
+
+                // Element name, attribute names and decoded attribute
+                // values of the current start tag, each followed by a
+                // null byte, and the attribute array pointing into it.
+                std::string m_tag_data{};
+                std::vector<std::size_t> m_attr_offsets{};
+                std::vector<const XML_Char*> m_attrs{};
+
+                // Decoded character data.
+                std::string m_text{};
+
+                // Like Expat, duplicate attributes and undefined
+                // entities or bad character references in attribute
+                // values are only reported after the whole tag has been
+                // checked. The first such error in the current tag.
+                const char* m_tag_error_pos = nullptr;
+                XML_Error m_tag_error_code = XML_ERROR_NONE;
+
+                state m_state = state::prolog;
+                bool m_use_expat = false;
+
+                static bool is_name_start_char(const char c) noexcept {
+                    return (c >= 'a' && c <= 'z') ||
+                           (c >= 'A' && c <= 'Z') ||
+                           c == '_' || c == ':';
+                }
 
-                    ExpatXMLParser parser{this};
-                    m_expat_xml_parser = &parser;
+                static bool is_name_char(const char c) noexcept {
+                    return is_name_start_char(c) ||
+                           (c >= '0' && c <= '9') ||
+                           c == '-' || c == '.' ||
+                           (static_cast<unsigned char>(c) & 0x80U);
+                }
 
-                    while (!input_done()) {
-                        const std::string data{get_input()};
-                        parser(data, input_done());
-                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
-                            break;
+                [[noreturn]] void error(const XML_Error code, const char* p) const {
+                    uint64_t line = m_line;
+                    uint64_t column = m_column;
+                    xml_update_position(m_data.data(), p, line, column);
+                    throw osmium::xml_error{line, column, code};
+                }
+
+                // Names with non-ASCII characters are rare, they are
+                // checked by letting Expat parse an empty element with
+                // that name.
+                void check_name_with_expat(const char* const p, const char* const e) const {
+                    std::string document{"<"};
+                    document.append(p, e);
+                    document += "/>";
+
+                    XML_Parser parser = XML_ParserCreate(nullptr);
+                    if (!parser) {
+                        throw osmium::io_error{"Internal error: Can not create parser"};
+                    }
+                    const bool okay = XML_Parse(parser, document.data(), static_cast<int>(document.size()), 1) != XML_STATUS_ERROR;
+                    const XML_Error code = XML_GetErrorCode(parser);
+                    auto column = XML_GetCurrentColumnNumber(parser);
+                    XML_ParserFree(parser);
+                    if (okay) {
+                        return;
+                    }
+
+                    // Expat counts characters, skip column - 1 characters
+                    // of the name to find the position of the error.
+                    const char* s = p;
+                    while (column > 1 && s != e) {
+                        ++s;
+                        while (s != e && xml_is_utf8_continuation(*s)) {
+                            ++s;
+                        }
+                        --column;
+                    }
+                    error(code, s);
+                }
+
+                // Check that [p, e) is a valid name and report an error
+                // like Expat does if it isn't.
+                void check_name(const char* const p, const char* const e) const {
+                    if (p == e) {
+                        error(XML_ERROR_INVALID_TOKEN, p);
+                    }
+                    for (const char* s = p; s != e; ++s) {
+                        if (static_cast<unsigned char>(*s) & 0x80U) {
+                            check_name_with_expat(p, e);
+                            return;
+                        }
+                        if (s == p ? !is_name_start_char(*s) : !is_name_char(*s)) {
+                            // a '/' must be followed by '>'
+                            error(XML_ERROR_INVALID_TOKEN, *s == '/' ? s + 1 : s);
+                        }
+                    }
+                }
+
+                // Report an error found in a start tag that Expat
+                // reports only after the whole tag has been checked.
+                void tag_error(const XML_Error code, const char* const p) noexcept {
+                    if (!m_tag_error_pos) {
+                        m_tag_error_pos = p;
+                        m_tag_error_code = code;
+                    }
+                }
+
+                void append_input(std::string&& data) {
+                    // The prolog is kept so it can be handed to Expat.
+                    if (m_state != state::prolog && m_pos > 0) {
+                        xml_update_position(m_data.data(), m_data.data() + m_pos, m_line, m_column);
+                        if (m_pos == m_data.size()) {
+                            m_data = std::move(data);
+                        } else {
+                            m_data.erase(0, m_pos);
+                            m_data.append(data);
+                        }
+                        m_pos = 0;
+                    } else if (m_data.empty()) {
+                        m_data = std::move(data);
+                    } else {
+                        m_data.append(data);
+                    }
+                }
+
+                // Decode the entity or character reference starting at
+                // p and append it to out. Returns the end of the
+                // reference. Like Expat, undefined entities in attribute
+                // values are reported at the start of the tag.
+                const char* decode_reference(const char* const p, const char* const e, std::string& out, const char* const tag) {
+                    const char* s = p + 1;
+                    const char* semicolon = s;
+                    if (semicolon != e && *semicolon == '#') {
+                        ++semicolon;
+                    }
+                    while (semicolon != e && is_name_char(*semicolon)) {
+                        ++semicolon;
+                    }
+                    if (semicolon == e || *semicolon != ';' || semicolon == s) {
+                        error(XML_ERROR_INVALID_TOKEN, semicolon);
+                    }
+
+                    if (*s != '#') {
+                        const auto len = static_cast<std::size_t>(semicolon - s);
+                        if (len == 2 && s[0] == 'l' && s[1] == 't') {
+                            out += '<';
+                        } else if (len == 2 && s[0] == 'g' && s[1] == 't') {
+                            out += '>';
+                        } else if (len == 3 && !std::memcmp(s, "amp", 3)) {
+                            out += '&';
+                        } else if (len == 4 && !std::memcmp(s, "quot", 4)) {
+                            out += '"';
+                        } else if (len == 4 && !std::memcmp(s, "apos", 4)) {
+                            out += '\'';
+                        } else if (tag) {
+                            tag_error(XML_ERROR_UNDEFINED_ENTITY, tag);
+                        } else {
+                            error(XML_ERROR_UNDEFINED_ENTITY, p);
+                        }
+                        return semicolon + 1;
+                    }
+
+                    ++s;
+                    uint32_t base = 10;
+                    if (s != semicolon && *s == 'x') {
+                        base = 16;
+                        ++s;
+                    }
+                    if (s == semicolon) {
+                        error(XML_ERROR_INVALID_TOKEN, s);
+                    }
+
+                    uint32_t value = 0;
+                    bool too_large = false;
+                    for (; s != semicolon; ++s) {
+                        uint32_t digit = 0;
+                        if (*s >= '0' && *s <= '9') {
+                            digit = static_cast<uint32_t>(*s - '0');
+                        } else if (base == 16 && *s >= 'a' && *s <= 'f') {
+                            digit = static_cast<uint32_t>(*s - 'a' + 10);
+                        } else if (base == 16 && *s >= 'A' && *s <= 'F') {
+                            digit = static_cast<uint32_t>(*s - 'A' + 10);
+                        } else {
+                            error(XML_ERROR_INVALID_TOKEN, s);
+                        }
+                        if (!too_large) {
+                            value = value * base + digit;
+                            too_large = value > 0x10ffffU;
+                        }
+                    }
+
+                    if (too_large ||
+                        (value < 0x20U && value != 0x09U && value != 0x0aU && value != 0x0dU) ||
+                        (value >= 0xd800U && value <= 0xdfffU) ||
+                        value == 0xfffeU || value == 0xffffU) {
+                        if (!tag) {
+                            error(XML_ERROR_BAD_CHAR_REF, p);
+                        }
+                        tag_error(XML_ERROR_BAD_CHAR_REF, p);
+                        return semicolon + 1;
+                    }
+
+                    append_codepoint_as_utf8(value, std::back_inserter(out));
+                    return semicolon + 1;
+                }
+
+                // Append the text in [p, e) to out, decoding references
+                // and normalizing line ends. For attribute values tag is
+                // the start of the tag and all whitespace characters are
+                // replaced by spaces, for character data it is nullptr.
+                void decode(const char* p, const char* const e, std::string& out, const char* const tag) {
+                    const bool attribute = tag != nullptr;
+                    while (p != e) {
+                        const char* const run = p;
+                        while (p != e && static_cast<unsigned char>(*p) >= 0x20U &&
+                               static_cast<unsigned char>(*p) < 0x80U && *p != '&' && *p != '<') {
+                            ++p;
                         }
+                        out.append(run, p);
+                        if (p == e) {
+                            return;
+                        }
+                        if (static_cast<unsigned char>(*p) >= 0x80U) {
+                            const auto len = xml_utf8_char_length(p, e);
+                            if (len == 0) {
+                                error(XML_ERROR_INVALID_TOKEN, p);
+                            }
+                            out.append(p, len);
+                            p += len;
+                            continue;
+                        }
+                        switch (*p) {
+                            case '&':
+                                p = decode_reference(p, e, out, tag);
+                                break;
+                            case '\r':
+                                out += attribute ? ' ' : '\n';
+                                ++p;
+                                if (p != e && *p == '\n') {
+                                    ++p;
+                                }
+                                break;
+                            case '\n':
+                            case '\t':
+                                out += attribute ? ' ' : *p;
+                                ++p;
+                                break;
+                            default: // '<' or other control character
+                                error(XML_ERROR_INVALID_TOKEN, p);
+                        }
+                    }
+                }
+
+                void characters(const char* p, const char* const e) {
+                    if (p == e) {
+                        return;
+                    }
+
+                    // "]]>" is not allowed in character data, Expat
+                    // reports it at the '>'.
+                    const char* const cdata_end = xml_find(p, e, "]]>", 3);
+                    const char* const end = cdata_end ? cdata_end + 2 : e;
+
+                    if (!std::memchr(p, '&', static_cast<std::size_t>(end - p)) &&
+                        !std::memchr(p, '\r', static_cast<std::size_t>(end - p))) {
+                        if (const char* const invalid = xml_find_invalid_char(p, end)) {
+                            error(XML_ERROR_INVALID_TOKEN, invalid);
+                        }
+                        if (cdata_end) {
+                            error(XML_ERROR_INVALID_TOKEN, end);
+                        }
+                        m_handler.characters(p, static_cast<int>(e - p));
+                        return;
+                    }
+                    m_text.clear();
+                    decode(p, end, m_text, nullptr);
+                    if (cdata_end) {
+                        error(XML_ERROR_INVALID_TOKEN, end);
+                    }
+                    m_handler.characters(m_text.data(), static_cast<int>(m_text.size()));
+                }
+
+                // Handle the character data in [p, e).
+                void text(const char* p, const char* const e) {
+                    if (m_state == state::document) {
+                        characters(p, e);
+                        return;
+                    }
+
+                    if (m_state == state::prolog && p == m_data.data() &&
+                        e - p >= 3 && !std::memcmp(p, "\xef\xbb\xbf", 3)) {
+                        p += 3; // skip UTF-8 byte order mark
+                    }
+
+                    for (; p != e; ++p) {
+                        if (!xml_is_space(*p)) {
+                            if (m_state == state::prolog) {
+                                m_use_expat = true;
+                                return;
+                            }
+                            if (xml_find_invalid_char(p, e) == p) {
+                                error(XML_ERROR_INVALID_TOKEN, p);
+                            }
+                            error(XML_ERROR_JUNK_AFTER_DOC_ELEMENT, p);
+                        }
+                    }
+                }
+
+                // Check the encoding declared in the XML declaration in
+                // [p, e).
+                static bool is_utf8_declaration(const char* p, const char* const e) {
+                    const char* s = xml_find(p, e, "encoding", 8);
+                    if (!s) {
+                        return true;
+                    }
+                    s += 8;
+                    while (s != e && xml_is_space(*s)) {
+                        ++s;
+                    }
+                    if (s == e || *s != '=') {
+                        return false;
+                    }
+                    ++s;
+                    while (s != e && xml_is_space(*s)) {
+                        ++s;
+                    }
+                    if (s == e || (*s != '"' && *s != '\'')) {
+                        return false;
+                    }
+                    const char quote = *s++;
+                    std::string encoding;
+                    for (; s != e && *s != quote; ++s) {
+                        encoding += static_cast<char>(std::tolower(static_cast<unsigned char>(*s)));
+                    }
+                    return encoding == "utf-8" || encoding == "us-ascii";
+                }
+
+                // Handle the processing instruction starting at p.
+                const char* processing_instruction(const char* const p, const char* const e) {
+                    const char* const end = xml_find(p + 2, e, "?>", 2);
+                    if (!end) {
+                        return nullptr;
+                    }
+                    if (m_state == state::prolog) {
+                        if (end - p >= 6 && !std::memcmp(p + 2, "xml", 3) && xml_is_space(p[5])) {
+                            // The XML declaration must be at the very
+                            // beginning and have a supported encoding.
+                            if (p != m_data.data() || !is_utf8_declaration(p + 6, end)) {
+                                m_use_expat = true;
+                            }
+                        } else {
+                            // Let Expat check anything else in the prolog.
+                            m_use_expat = true;
+                        }
+                        return end + 2;
+                    }
+
+                    const char* const target = p + 2;
+                    const char* target_end = target;
+                    while (target_end != end && !xml_is_space(*target_end)) {
+                        ++target_end;
+                    }
+                    check_name(target, target_end);
+                    if (target_end - target == 3 &&
+                        std::tolower(static_cast<unsigned char>(target[0])) == 'x' &&
+                        std::tolower(static_cast<unsigned char>(target[1])) == 'm' &&
+                        std::tolower(static_cast<unsigned char>(target[2])) == 'l') {
+                        if (!std::memcmp(target, "xml", 3)) {
+                            error(XML_ERROR_MISPLACED_XML_PI, p);
+                        }
+                        error(XML_ERROR_INVALID_TOKEN, target_end);
+                    }
+                    if (const char* const invalid = xml_find_invalid_char(target_end, end)) {
+                        error(XML_ERROR_INVALID_TOKEN, invalid);
+                    }
+                    return end + 2;
+                }
+
+                // Handle comment, CDATA section, or declaration starting
+                // at p.
+                const char* declaration(const char* const p, const char* const e) {
+                    if (e - p < 4) {
+                        return nullptr;
+                    }
+                    if (!std::memcmp(p, "<!--", 4)) {
+                        // "--" is only allowed at the end of the comment
+                        const char* const end = xml_find(p + 4, e, "--", 2);
+                        if (!end || end + 2 == e) {
+                            return nullptr;
+                        }
+                        const char* invalid = xml_find_invalid_char(p + 4, end);
+                        if (!invalid && end[2] != '>') {
+                            invalid = end + 2;
+                        }
+                        if (invalid) {
+                            if (m_state == state::prolog) {
+                                m_use_expat = true;
+                                return p;
+                            }
+                            error(XML_ERROR_INVALID_TOKEN, invalid);
+                        }
+                        return end + 3;
+                    }
+                    if (e - p < 9) {
+                        return nullptr;
+                    }
+                    if (m_state == state::document && !std::memcmp(p, "<![CDATA[", 9)) {
+                        const char* const end = xml_find(p + 9, e, "]]>", 3);
+                        if (!end) {
+                            return nullptr;
+                        }
+                        if (const char* const invalid = xml_find_invalid_char(p + 9, end)) {
+                            error(XML_ERROR_INVALID_TOKEN, invalid);
+                        }
+                        if (std::memchr(p + 9, '\r', static_cast<std::size_t>(end - p - 9))) {
+                            m_text.clear();
+                            for (const char* s = p + 9; s != end; ++s) {
+                                if (*s != '\r') {
+                                    m_text += *s;
+                                } else if (s + 1 == end || s[1] != '\n') {
+                                    m_text += '\n';
+                                }
+                            }
+                            m_handler.characters(m_text.data(), static_cast<int>(m_text.size()));
+                        } else if (end != p + 9) {
+                            m_handler.characters(p + 9, static_cast<int>(end - p - 9));
+                        }
+                        return end + 3;
+                    }
+                    if (m_state == state::prolog) {
+                        // DOCTYPE declaration
+                        m_use_expat = true;
+                        return p;
+                    }
+                    error(XML_ERROR_INVALID_TOKEN,p + 2);
+                }
+
+                // Handle the end tag starting at p.
+                const char* end_tag(const char* const p, const char* const e) {
+                    const auto* const end = static_cast<const char*>(std::memchr(p + 2, '>', static_cast<std::size_t>(e - p - 2)));
+                    if (!end) {
+                        return nullptr;
+                    }
+                    if (m_state == state::prolog) {
+                        m_use_expat = true;
+                        return p;
+                    }
+                    if (m_state == state::epilog) {
+                        error(XML_ERROR_JUNK_AFTER_DOC_ELEMENT, p);
+                    }
+
+                    const char* const name = p + 2;
+                    const char* name_end = name;
+                    while (name_end != end && !xml_is_space(*name_end)) {
+                        ++name_end;
+                    }
+                    check_name(name, name_end);
+                    for (const char* s = name_end; s != end; ++s) {
+                        if (!xml_is_space(*s)) {
+                            error(XML_ERROR_INVALID_TOKEN, s);
+                        }
+                    }
+
+                    assert(m_depth > 0);
+                    const std::string& element = m_elements[m_depth - 1];
+                    if (element.size() != static_cast<std::size_t>(name_end - name) ||
+                        std::memcmp(element.data(), name, element.size())) {
+                        error(XML_ERROR_TAG_MISMATCH, name);
+                    }
+
+                    m_handler.end_element(element.c_str());
+                    if (--m_depth == 0) {
+                        m_state = state::epilog;
+                    }
+                    return end + 1;
+                }
+
+                // Handle the start tag or empty-element tag starting at p.
+                // The tag is checked from left to right so that errors are
+                // reported at the same position as Expat does.
+                const char* start_tag(const char* const p, const char* const e) {
+                    if (m_state == state::epilog) {
+                        error(XML_ERROR_JUNK_AFTER_DOC_ELEMENT, p);
+                    }
+
+                    const char* s = p + 1;
+                    while (s != e && !xml_is_space(*s) && *s != '/' && *s != '>') {
+                        ++s;
+                    }
+                    if (s == e) {
+                        return nullptr;
+                    }
+                    const char* const name_end = s;
+                    check_name(p + 1, name_end);
+
+                    m_tag_data.assign(p + 1, name_end);
+                    m_tag_data += '\0';
+                    m_attr_offsets.clear();
+                    m_tag_error_pos = nullptr;
+
+                    bool empty = false;
+                    while (true) {
+                        const char* const separator = s;
+                        while (s != e && xml_is_space(*s)) {
+                            ++s;
+                        }
+                        if (s == e) {
+                            return nullptr;
+                        }
+                        if (*s == '>') {
+                            break;
+                        }
+                        if (*s == '/') {
+                            if (s + 1 == e) {
+                                return nullptr;
+                            }
+                            if (s[1] != '>') {
+                                error(XML_ERROR_INVALID_TOKEN, s + 1);
+                            }
+                            empty = true;
+                            ++s;
+                            break;
+                        }
+                        if (s == separator) {
+                            error(XML_ERROR_INVALID_TOKEN, s);
+                        }
+
+                        const char* const attr_name = s;
+                        while (s != e && *s != '=' && !xml_is_space(*s) && *s != '/' && *s != '>') {
+                            ++s;
+                        }
+                        if (s == e) {
+                            return nullptr;
+                        }
+                        check_name(attr_name, s);
+
+                        const auto name_size = static_cast<std::size_t>(s - attr_name);
+                        for (std::size_t i = 0; i < m_attr_offsets.size(); i += 2) {
+                            const char* const other = m_tag_data.data() + m_attr_offsets[i];
+                            if (other[0] == attr_name[0] && !std::strncmp(other, attr_name, name_size) && other[name_size] == '\0') {
+                                tag_error(XML_ERROR_DUPLICATE_ATTRIBUTE, attr_name);
+                                break;
+                            }
+                        }
+                        m_attr_offsets.push_back(m_tag_data.size());
+                        m_tag_data.append(attr_name, s);
+                        m_tag_data += '\0';
+
+                        while (s != e && xml_is_space(*s)) {
+                            ++s;
+                        }
+                        if (s == e) {
+                            return nullptr;
+                        }
+                        if (*s != '=') {
+                            error(XML_ERROR_INVALID_TOKEN, s);
+                        }
+                        ++s;
+                        while (s != e && xml_is_space(*s)) {
+                            ++s;
+                        }
+                        if (s == e) {
+                            return nullptr;
+                        }
+                        if (*s != '"' && *s != '\'') {
+                            error(XML_ERROR_INVALID_TOKEN, s);
+                        }
+
+                        const char quote = *s++;
+                        const auto* const value_end = static_cast<const char*>(std::memchr(s, quote, static_cast<std::size_t>(e - s)));
+                        if (!value_end) {
+                            return nullptr;
+                        }
+                        m_attr_offsets.push_back(m_tag_data.size());
+                        decode(s, value_end, m_tag_data, p);
+                        m_tag_data += '\0';
+                        s = value_end + 1;
+                    }
+                    const char* const end = s;
+
+                    if (m_tag_error_pos) {
+                        error(m_tag_error_code, m_tag_error_pos);
+                    }
+
+                    m_attrs.clear();
+                    for (const auto offset : m_attr_offsets) {
+                        m_attrs.push_back(m_tag_data.data() + offset);
+                    }
+                    m_attrs.push_back(nullptr);
+
+                    m_state = state::document;
+                    m_handler.start_element(m_tag_data.data(), m_attrs.data());
+
+                    if (empty) {
+                        m_handler.end_element(m_tag_data.data());
+                        if (m_depth == 0) {
+                            m_state = state::epilog;
+                        }
+                    } else {
+                        if (m_depth == m_elements.size()) {
+                            m_elements.emplace_back();
+                        }
+                        m_elements[m_depth].assign(p + 1, name_end);
+                        ++m_depth;
+                    }
+
+                    return end + 1;
+                }
+
+                // Handle the markup starting at p. Returns the end of
+                // the markup or nullptr if it is incomplete.
+                const char* markup(const char* const p, const char* const e) {
+                    if (e - p < 2) {
+                        return nullptr;
+                    }
+                    switch (p[1]) {
+                        case '?':
+                            return processing_instruction(p, e);
+                        case '!':
+                            return declaration(p, e);
+                        case '/':
+                            return end_tag(p, e);
+                        default:
+                            break;
+                    }
+                    return start_tag(p, e);
+                }
+
+            public:
+
+                explicit FastXMLParser(THandler& handler) :
+                    m_handler(handler) {
+                }
+
+                /**
+                 * Create a parser for a fragment of a document starting at
+                 * the given line and column inside the given open elements.
+                 */
+                FastXMLParser(THandler& handler, const std::vector<std::string>& open_elements, const uint64_t line, const uint64_t column) :
+                    m_handler(handler),
+                    m_line(line),
+                    m_column(column),
+                    m_elements(open_elements),
+                    m_depth(open_elements.size()),
+                    m_state(state::document) {
+                    assert(!open_elements.empty());
+                }
+
+                /**
+                 * Parse the next chunk of data.
+                 *
+                 * @returns false if the document has to be parsed by
+                 *          Expat, true otherwise.
+                 */
+                bool operator()(std::string&& data, const bool last) {
+                    append_input(std::move(data));
+
+                    while (m_pos < m_data.size()) {
+                        const char* const begin = m_data.data();
+                        const char* const end = begin + m_data.size();
+                        const char* const p = begin + m_pos;
+
+                        if (*p != '<') {
+                            const auto* text_end = static_cast<const char*>(std::memchr(p, '<', static_cast<std::size_t>(end - p)));
+                            if (!text_end) {
+                                if (!last) {
+                                    break;
+                                }
+                                text_end = end;
+                            }
+                            text(p, text_end);
+                            if (m_use_expat) {
+                                return false;
+                            }
+                            m_pos = static_cast<std::size_t>(text_end - begin);
+                            continue;
+                        }
+
+                        const char* const markup_end = markup(p, end);
+                        if (m_use_expat) {
+                            return false;
+                        }
+                        if (!markup_end) {
+                            if (!last) {
+                                break;
+                            }
+                            if (m_state == state::prolog) {
+                                return false;
+                            }
+                            error(XML_ERROR_UNCLOSED_TOKEN, p);
+                        }
+                        m_pos = static_cast<std::size_t>(markup_end - begin);
+                    }
+
+                    if (last) {
+                        if (m_state == state::prolog) {
+                            return false;
+                        }
+                        if (m_state == state::document) {
+                            error(XML_ERROR_NO_ELEMENTS, m_data.data() + m_data.size());
+                        }
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Parse a fragment of a document. Unless this is the last
+                 * fragment (end_elements is nullptr), it must end inside
+                 * the elements given in end_elements, where the next
+                 * fragment starts.
+                 */
+                void parse_fragment(std::string&& data, const std::vector<std::string>* end_elements) {
+                    if (!end_elements) {
+                        operator()(std::move(data), true);
+                        return;
+                    }
+
+                    operator()(std::move(data), false);
+
+                    const char* const end = m_data.data() + m_data.size();
+                    const char* const p = m_data.data() + m_pos;
+                    if (p != end) {
+                        if (*p == '<') {
+                            error(XML_ERROR_UNCLOSED_TOKEN, p);
+                        }
+                        text(p, end);
+                    }
+
+                    if (m_state == state::epilog) {
+                        error(XML_ERROR_JUNK_AFTER_DOC_ELEMENT, end);
+                    }
+                    if (end_elements->size() != m_depth ||
+                        !std::equal(end_elements->begin(), end_elements->end(), m_elements.begin())) {
+                        error(XML_ERROR_TAG_MISMATCH, end);
+                    }
+                }
+
+                /**
+                 * The names of the currently open elements.
+                 */
+                std::vector<std::string> open_elements() const {
+                    return std::vector<std::string>(m_elements.begin(), m_elements.begin() + m_depth);
+                }
+
+                /**
+                 * Return all input data. Only call this after the
+                 * function call operator returned false.
+                 */
+                std::string release_input() {
+                    assert(m_state == state::prolog);
+                    return std::move(m_data);
+                }
+
+            }; // class FastXMLParser
+
+            // Find the next tag in [p, e) skipping comments, CDATA sections,
+            // and processing instructions. Returns e if there is none or
+            // nullptr if more data is needed to decide.
+            inline const char* xml_find_tag(const char* p, const char* const e) noexcept {
+                while ((p = static_cast<const char*>(std::memchr(p, '<', static_cast<std::size_t>(e - p))))) {
+                    if (e - p < 2) {
+                        return nullptr;
+                    }
+                    const char* end = nullptr;
+                    if (p[1] == '?') {
+                        end = xml_find(p + 2, e, "?>", 2);
+                    } else if (p[1] == '!') {
+                        if (e - p < 9) {
+                            return nullptr;
+                        }
+                        if (!std::memcmp(p + 2, "--", 2)) {
+                            end = xml_find(p + 4, e, "-->", 3);
+                        } else if (!std::memcmp(p + 2, "[CDATA[", 7)) {
+                            end = xml_find(p + 9, e, "]]>", 3);
+                        } else {
+                            return p;
+                        }
+                    } else {
+                        return p;
+                    }
+                    if (!end) {
+                        return nullptr;
+                    }
+                    p = end + 2;
+                }
+                return e;
+            }
+
+            // Find the first position at or after target in [p, e) where an
+            // OSM XML document can be split into chunks for parsing, ie. the
+            // start of a node, way, relation, or changeset element or of a
+            // create, modify, or delete section in a change file. Scanning
+            // starts at p which must not be inside a comment or CDATA
+            // section. Returns nullptr if there is no such position or more
+            // data is needed to decide. In that case resume (if set) is set
+            // to the position where the search can be continued when more
+            // data is available.
+            inline const char* xml_find_split_point(const char* p, const char* const target, const char* const e, const char** resume = nullptr) noexcept {
+                static const char* const names[] = {
+                    "node", "way", "relation", "changeset", "create", "modify", "delete"
+                };
+
+                const char* tag = p;
+                while ((tag = xml_find_tag(p, e)) && tag != e) {
+                    p = tag;
+                    if (p >= target) {
+                        if (e - p < 11) {
+                            break;
+                        }
+                        for (const char* name : names) {
+                            const auto len = std::strlen(name);
+                            const char c = p[len + 1];
+                            if (!std::memcmp(p + 1, name, len) && (xml_is_space(c) || c == '>' || c == '/')) {
+                                return p;
+                            }
+                        }
+                    }
+                    ++p;
+                }
+                if (resume) {
+                    *resume = tag == e ? e : p;
+                }
+                return nullptr;
+            }
+
+            // Update the list of open elements with the create, modify, and
+            // delete sections of OSM change files opened and closed in the
+            // complete chunk [p, e).
+            inline void xml_update_change_sections(const char* p, const char* const e, std::vector<std::string>& elements) {
+                while ((p = xml_find_tag(p, e)) && p != e) {
+                    const bool close = p[1] == '/';
+                    const char* const name = p + (close ? 2 : 1);
+                    p = name;
+                    if (e - name < 7 ||
+                        (std::memcmp(name, "create", 6) && std::memcmp(name, "modify", 6) && std::memcmp(name, "delete", 6)) ||
+                        (!xml_is_space(name[6]) && name[6] != '>' && name[6] != '/')) {
+                        continue;
+                    }
+                    if (close) {
+                        if (elements.size() > 1 && !elements.back().compare(0, std::string::npos, name, 6)) {
+                            elements.pop_back();
+                        }
+                    } else {
+                        const auto* const end = static_cast<const char*>(std::memchr(name, '>', static_cast<std::size_t>(e - name)));
+                        if (end && end[-1] != '/') {
+                            elements.emplace_back(name, 6);
+                        }
+                    }
+                }
+            }
+
+            // Task parsing a chunk of an OSM XML document into a buffer. The
+            // chunk starts inside the elements given in start_elements and,
+            // unless it is the last chunk, must end inside the elements
+            // given in end_elements.
+            class XMLChunkParser {
+
+                std::string m_data;
+                osmium::memory::Buffer m_buffer;
+                std::vector<std::string> m_start_elements;
+                std::vector<std::string> m_end_elements;
+                uint64_t m_line;
+                uint64_t m_column;
+                osmium::osm_entity_bits::type m_read_types;
+                const osmium::io::read_filter* m_filter;
+                bool m_last;
+
+                static XMLElementHandler::context element_context(const std::string& element) noexcept {
+                    if (element == "osm") {
+                        return XMLElementHandler::context::osm;
+                    }
+                    if (element == "osmChange") {
+                        return XMLElementHandler::context::osmChange;
+                    }
+                    if (element == "create") {
+                        return XMLElementHandler::context::create_section;
+                    }
+                    if (element == "modify") {
+                        return XMLElementHandler::context::modify_section;
+                    }
+                    if (element == "delete") {
+                        return XMLElementHandler::context::delete_section;
+                    }
+                    return XMLElementHandler::context::other;
+                }
+
+            public:
+
+                XMLChunkParser(std::string&& data,
+                               osmium::memory::Buffer&& buffer,
+                               const std::vector<std::string>& start_elements,
+                               const std::vector<std::string>& end_elements,
+                               const uint64_t line,
+                               const uint64_t column,
+                               const osmium::osm_entity_bits::type read_types,
+                               const osmium::io::read_filter* filter,
+                               const bool last) :
+                    m_data(std::move(data)),
+                    m_buffer(std::move(buffer)),
+                    m_start_elements(start_elements),
+                    m_end_elements(end_elements),
+                    m_line(line),
+                    m_column(column),
+                    m_read_types(read_types),
+                    m_filter(filter),
+                    m_last(last) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    OSMIUM_TRACE_SCOPE("parse_xml_chunk");
+
+                    std::vector<XMLElementHandler::context> contexts;
+                    for (const auto& element : m_start_elements) {
+                        contexts.push_back(element_context(element));
+                    }
+
+                    XMLElementHandler handler{std::move(m_buffer), m_read_types, m_filter};
+                    handler.set_context(contexts);
+
+                    FastXMLParser<XMLElementHandler> parser{handler, m_start_elements, m_line, m_column};
+                    parser.parse_fragment(std::move(m_data), m_last ? nullptr : &m_end_elements);
+
+                    return std::move(handler.buffer());
+                }
+
+            }; // class XMLChunkParser
+
+            class XMLParser final : public Parser {
+
+                enum {
+                    initial_buffer_size = 1024UL * 1024UL
+                };
+
+                XMLElementHandler m_handler;
+
+                /**
+                 * A C++ wrapper for the Expat parser that makes sure no memory
+                 * is leaked.
+                 */
+                class ExpatXMLParser {
+
+                    XML_Parser m_parser;
+                    std::exception_ptr m_exception_ptr{};
+
+                    template <typename TFunc>
+                    void member_wrap(XMLParser& xml_parser, TFunc&& func) noexcept {
+                        if (m_exception_ptr) {
+                            return;
+                        }
+                        try {
+                            std::forward<TFunc>(func)(xml_parser);
+                        } catch (...) {
+                            m_exception_ptr = std::current_exception();
+                            XML_StopParser(m_parser, 0);
+                        }
+                    }
+
+                    template <typename TFunc>
+                    static void wrap(void* data, TFunc&& func) noexcept {
+                        assert(data);
+                        auto& xml_parser = *static_cast<XMLParser*>(data);
+                        xml_parser.m_expat_xml_parser->member_wrap(xml_parser, std::forward<TFunc>(func));
+                    }
+
+                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.start_element(element, attrs);
+                        });
+                    }
+
+                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.end_element(element);
+                        });
+                    }
+
+                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) noexcept {
+                        wrap(data, [&](XMLParser& xml_parser) {
+                            xml_parser.characters(text, len);
+                        });
+                    }
+
+                    // This handler is called when there are any XML entities
+                    // declared in the OSM file. Entities are normally not used,
+                    // but they can be misused. See
+                    // https://en.wikipedia.org/wiki/Billion_laughs
+                    // The handler will just throw an error.
+                    static void entity_declaration_handler(void* data,
+                            const XML_Char* /*entityName*/,
+                            int /*is_parameter_entity*/,
+                            const XML_Char* /*value*/,
+                            int /*value_length*/,
+                            const XML_Char* /*base*/,
+                            const XML_Char* /*systemId*/,
+                            const XML_Char* /*publicId*/,
+                            const XML_Char* /*notationName*/) noexcept {
+                        wrap(data, [&](XMLParser& /*xml_parser*/) {
+                            throw osmium::xml_error{"XML entities are not supported"};
+                        });
+                    }
+
+                public:
+
+                    explicit ExpatXMLParser(void* callback_object) :
+                        m_parser(XML_ParserCreate(nullptr)) {
+                        if (!m_parser) {
+                            throw osmium::io_error{"Internal error: Can not create parser"};
+                        }
+                        XML_SetUserData(m_parser, callback_object);
+                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
+                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
+                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
+                    }
+
+                    ExpatXMLParser(const ExpatXMLParser&) = delete;
+                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
+
+                    ExpatXMLParser(ExpatXMLParser&&) = delete;
+                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
+
+                    ~ExpatXMLParser() noexcept {
+                        XML_ParserFree(m_parser);
+                    }
+
+                    void operator()(const std::string& data, bool last) {
+                        assert(data.size() < std::numeric_limits<int>::max());
+                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
+                            if (m_exception_ptr) {
+                                std::rethrow_exception(m_exception_ptr);
+                            }
+                            throw osmium::xml_error{m_parser};
+                        }
+                    }
+
+                }; // class ExpatXMLParser
+
+                ExpatXMLParser* m_expat_xml_parser{nullptr};
+
+                friend class FastXMLParser<XMLParser>;
+
+                // Called after each element, sends the header as soon as
+                // it is complete and buffers as soon as they are full.
+                void flush_buffer() {
+                    if (!header_is_done() && m_handler.header_is_complete()) {
+                        set_header_value(m_handler.header());
+                    }
+                    auto& buffer = m_handler.buffer();
+                    if (buffer.has_nested_buffers()) {
+                        std::unique_ptr<osmium::memory::Buffer> buffer_ptr{buffer.get_last_nested()};
+                        send_to_output_queue(std::move(*buffer_ptr));
+                    }
+                }
+
+                void start_element(const XML_Char* element, const XML_Char** attrs) {
+                    m_handler.start_element(element, attrs);
+                    flush_buffer();
+                }
+
+                void end_element(const XML_Char* element) {
+                    m_handler.end_element(element);
+                    flush_buffer();
+                }
+
+                void characters(const XML_Char* text, int len) {
+                    m_handler.characters(text, len);
+                }
+
+                osmium::memory::Buffer get_buffer() {
+                    if (buffer_pool()) {
+                        return buffer_pool()->get(initial_buffer_size);
+                    }
+                    return osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                }
+
+                // Parse a chunk starting inside the given elements in the
+                // thread pool and update elements, line, and column to the
+                // end of the chunk.
+                void parse_chunk(std::string&& chunk, std::vector<std::string>& elements, uint64_t& line, uint64_t& column, const bool last) {
+                    const std::vector<std::string> start_elements{elements};
+                    const uint64_t start_line = line;
+                    const uint64_t start_column = column;
+
+                    const char* const begin = chunk.data();
+                    const char* const end = begin + chunk.size();
+                    xml_update_position(begin, end, line, column);
+                    if (!last && elements.front() == "osmChange") {
+                        xml_update_change_sections(begin, end, elements);
+                    }
+
+                    submit_to_output_queue(XMLChunkParser{std::move(chunk), get_buffer(), start_elements, elements,
+                                                          start_line, start_column, read_types(), filter(), last});
+                }
+
+                // Split the data starting at a split point inside the given
+                // elements and the rest of the input into chunks of at least
+                // min_chunk_size bytes and parse them in the thread pool.
+                void parse_in_chunks(std::string&& data, std::vector<std::string>&& elements, uint64_t line, uint64_t column) {
+                    std::string chunk{std::move(data)};
+
+                    // The split point search continues where the previous
+                    // one stopped.
+                    std::size_t scanned = 0;
+
+                    while (!input_done()) {
+                        chunk.append(get_input());
+                        if (chunk.size() <= min_chunk_size) {
+                            continue;
+                        }
+
+                        const char* const begin = chunk.data();
+                        const char* resume = nullptr;
+                        const char* const split = xml_find_split_point(begin + scanned, begin + min_chunk_size, begin + chunk.size(), &resume);
+                        if (!split) {
+                            scanned = static_cast<std::size_t>(resume - begin);
+                            continue;
+                        }
+
+                        std::string rest{split, begin + chunk.size()};
+                        chunk.resize(static_cast<std::size_t>(split - begin));
+                        parse_chunk(std::move(chunk), elements, line, column, false);
+                        chunk = std::move(rest);
+                        scanned = 0;
+                    }
+
+                    parse_chunk(std::move(chunk), elements, line, column, true);
+                }
+
+                // Parse input with the FastXMLParser. Returns false if the
+                // document has to be parsed by Expat, in this case the input
+                // read so far is returned in data.
+                //
+                // If enabled, everything up to the first OSM object is parsed
+                // here to get the header and, if the document looks as
+                // expected, the rest is parsed in chunks in the thread pool.
+                // If there is no OSM object in the first max_header_size
+                // bytes, the whole document is parsed here.
+                bool parse_fast(std::string& data) {
+                    FastXMLParser<XMLParser> parser{*this};
+                    std::string input;
+
+                    if (osmium::config::use_pool_threads_for_xml_parsing()) {
+                        const char* split = nullptr;
+                        std::size_t scanned = 0;
+                        while (!split && !input_done() && input.size() < max_header_size) {
+                            input.append(get_input());
+                            const char* resume = nullptr;
+                            split = xml_find_split_point(input.data() + scanned, input.data(), input.data() + input.size(), &resume);
+                            if (!split) {
+                                scanned = static_cast<std::size_t>(resume - input.data());
+                            }
+                        }
+
+                        if (split) {
+                            std::string rest{split, input.data() + input.size()};
+                            input.resize(static_cast<std::size_t>(split - input.data()));
+
+                            uint64_t line = 1;
+                            uint64_t column = 0;
+                            xml_update_position(input.data(), input.data() + input.size(), line, column);
+
+                            if (!parser(std::move(input), false)) {
+                                data = parser.release_input();
+                                data.append(rest);
+                                return false;
+                            }
+
+                            auto elements = parser.open_elements();
+                            if (elements.size() == 1) {
+                                set_header_value(m_handler.header());
+                                if (read_types() != osmium::osm_entity_bits::nothing) {
+                                    parse_in_chunks(std::move(rest), std::move(elements), line, column);
+                                }
+                                return true;
+                            }
+
+                            input = std::move(rest);
+                        }
+                    }
+
+                    while (true) {
+                        if (!parser(std::move(input), input_done())) {
+                            data = parser.release_input();
+                            return false;
+                        }
+                        if (input_done() || (read_types() == osmium::osm_entity_bits::nothing && header_is_done())) {
+                            break;
+                        }
+                        input = get_input();
+                    }
+
+                    return true;
+                }
+
+                void parse_with_expat(const std::string* initial_data) {
+                    ExpatXMLParser parser{this};
+                    m_expat_xml_parser = &parser;
+
+                    if (initial_data) {
+                        parser(*initial_data, input_done());
+                    }
+
+                    while (!input_done()) {
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+                        const std::string data{get_input()};
+                        parser(data, input_done());
+                    }
+
+                    m_expat_xml_parser = nullptr;
+                }
+
+            public:
+
+                enum : std::size_t {
+                    min_chunk_size = 1024UL * 1024UL,
+                    max_header_size = 4UL * min_chunk_size
+                };
+
+                explicit XMLParser(parser_arguments& args) :
+                    Parser(args),
+                    m_handler(osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal},
+                              args.read_which_entities,
+                              args.filter) {
+                }
+
+                XMLParser(const XMLParser&) = delete;
+                XMLParser& operator=(const XMLParser&) = delete;
+
+                XMLParser(XMLParser&&) = delete;
+                XMLParser& operator=(XMLParser&&) = delete;
+
+                ~XMLParser() noexcept override = default;
+
+                void run() override {
+                    osmium::thread::set_thread_name("_osmium_xml_in");
+
+                    if (osmium::config::use_fast_xml_parser()) {
+                        std::string data;
+                        if (!parse_fast(data)) {
+                            parse_with_expat(&data);
+                        }
+                    } else {
+                        parse_with_expat(nullptr);
                     }
 
-                    mark_header_as_done();
+                    set_header_value(m_handler.header());
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                    auto& buffer = m_handler.buffer();
+                    if (buffer.committed() > 0) {
+                        send_to_output_queue(std::move(buffer));
                     }
                 }
 
@@ -58,7 +58,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
-#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -96,11 +95,11 @@ namespace osmium {
                     out += ' ';
                     out += lat;
                     out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.y());
+                    append_location_coordinate(out, location.y());
                     out += "\" ";
                     out += lon;
                     out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.x());
+                    append_location_coordinate(out, location.x());
                     out += "\"";
                 }
 
@@ -426,7 +425,7 @@ namespace osmium {
 
             public:
 
-                XMLOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                XMLOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) :
                     OutputFormat(pool, output_queue) {
                     m_options.add_metadata      = osmium::metadata_options{file.get("add_metadata")};
                     m_options.use_change_ops    = file.is_true("xml_change_format");
@@ -464,7 +463,7 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    submit_to_queue(m_pool, m_output_queue, XMLOutputBlock{std::move(buffer), m_options});
                 }
 
                 void write_end() final {
@@ -484,7 +483,7 @@ namespace osmium {
             // we want the register_output_format() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_xml_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::xml,
-                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, string_queue_type& output_queue) {
                     return new osmium::io::detail::XMLOutputFormat(pool, file, output_queue);
             });
 
@@ -43,16 +43,23 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <string>
 
@@ -248,6 +255,354 @@ namespace osmium {
 
         }; // class GzipDecompressor
 
+        namespace detail {
+
+            /**
+             * The gzip files written by the GzipParallelCompressor consist
+             * of many independent gzip members. Each member has an extra
+             * field in its header with the subfield "OM" containing the
+             * size of the whole member (4 bytes, little endian). This is
+             * similar to the BGZF format used in bioinformatics, but allows
+             * larger members. The member sizes allow the
+             * GzipParallelDecompressor to find the members without
+             * decompressing them.
+             */
+            enum : std::size_t {
+                gzip_member_header_size = 20,
+                gzip_member_trailer_size = 8
+            };
+
+            inline void append_uint32_le(std::string& out, uint32_t value) {
+                for (int i = 0; i < 4; ++i) {
+                    out += static_cast<char>(value & 0xffU);
+                    value >>= 8U;
+                }
+            }
+
+            inline uint32_t get_uint32_le(const char* data) noexcept {
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                return static_cast<uint32_t>(d[0]) |
+                       (static_cast<uint32_t>(d[1]) << 8U) |
+                       (static_cast<uint32_t>(d[2]) << 16U) |
+                       (static_cast<uint32_t>(d[3]) << 24U);
+            }
+
+            inline bool has_gzip_magic(const char* data, const std::size_t size) noexcept {
+                return size >= 2 && data[0] == '\x1f' && data[1] == '\x8b';
+            }
+
+            /**
+             * Get the size of the gzip member starting at data as
+             * recorded in its header. Returns 0 if this is not a member
+             * written by the GzipParallelCompressor or if there is not
+             * enough data to tell.
+             */
+            inline std::size_t gzip_member_size(const char* data, const std::size_t size) noexcept {
+                static const char header[] = "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x08\x00OM\x04\x00";
+                if (size < gzip_member_header_size ||
+                    std::memcmp(data, header, gzip_member_header_size - 4) != 0) {
+                    return 0;
+                }
+                const std::size_t member_size = get_uint32_le(data + gzip_member_header_size - 4);
+                if (member_size < gzip_member_header_size + gzip_member_trailer_size) {
+                    return 0;
+                }
+                return member_size;
+            }
+
+            [[noreturn]] inline void throw_zlib_error(const z_stream& zstream, const char* msg, const int result) {
+                std::string message{"gzip error: "};
+                message += msg;
+                message += ": ";
+                if (zstream.msg) {
+                    message.append(zstream.msg);
+                }
+                throw osmium::gzip_error{message, result};
+            }
+
+            // Block compressor for the ParallelCompressor writing a gzip
+            // member with its size in the header.
+            class gzip_block_compressor {
+
+            public:
+
+                std::string operator()(const std::string& data) const {
+                    assert(data.size() < std::numeric_limits<uint32_t>::max());
+
+                    z_stream zstream{};
+                    int result = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY); // NOLINT(hicpp-signed-bitwise)
+                    if (result != Z_OK) {
+                        throw_zlib_error(zstream, "compression init failed", result);
+                    }
+
+                    std::string output{"\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x08\x00OM\x04\x00\x00\x00\x00\x00", gzip_member_header_size};
+                    const auto bound = deflateBound(&zstream, static_cast<uLong>(data.size()));
+                    output.resize(gzip_member_header_size + bound);
+
+                    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data.data()));
+                    zstream.avail_in = static_cast<unsigned int>(data.size());
+                    zstream.next_out = reinterpret_cast<unsigned char*>(&output[gzip_member_header_size]);
+                    zstream.avail_out = static_cast<unsigned int>(bound);
+
+                    result = deflate(&zstream, Z_FINISH);
+                    const auto compressed_size = zstream.total_out;
+                    deflateEnd(&zstream);
+                    if (result != Z_STREAM_END) {
+                        throw_zlib_error(zstream, "deflate failed", result);
+                    }
+
+                    output.resize(gzip_member_header_size + compressed_size);
+                    append_uint32_le(output, static_cast<uint32_t>(crc32(0L, reinterpret_cast<const unsigned char*>(data.data()), static_cast<unsigned int>(data.size()))));
+                    append_uint32_le(output, static_cast<uint32_t>(data.size()));
+
+                    assert(output.size() < std::numeric_limits<uint32_t>::max());
+                    std::string size;
+                    append_uint32_le(size, static_cast<uint32_t>(output.size()));
+                    output.replace(gzip_member_header_size - 4, 4, size);
+
+                    return output;
+                }
+
+            }; // class gzip_block_compressor
+
+            /**
+             * Decompresses gzip data which can contain several members
+             * one after the other. The input can be given in pieces. Like
+             * the GzipDecompressor data that is not gzip-compressed at all
+             * is passed through unchanged and garbage after the last
+             * member is ignored.
+             */
+            class gzip_stream_decoder {
+
+                enum class state {
+                    start,
+                    in_member,
+                    after_member,
+                    transparent,
+                    garbage
+                };
+
+                z_stream m_zstream;
+                state m_state = state::start;
+                bool m_initialized = false;
+
+            public:
+
+                gzip_stream_decoder() noexcept :
+                    m_zstream() {
+                }
+
+                gzip_stream_decoder(const gzip_stream_decoder&) = delete;
+                gzip_stream_decoder& operator=(const gzip_stream_decoder&) = delete;
+
+                gzip_stream_decoder(gzip_stream_decoder&&) = delete;
+                gzip_stream_decoder& operator=(gzip_stream_decoder&&) = delete;
+
+                ~gzip_stream_decoder() noexcept {
+                    if (m_initialized) {
+                        inflateEnd(&m_zstream);
+                    }
+                }
+
+                /**
+                 * Decompress data from the range [next, end) and append it
+                 * to output until all input is used up or the output has
+                 * reached max_output bytes. Updates next to point to the
+                 * first byte not used.
+                 *
+                 * @throws gzip_error If the data is not valid.
+                 */
+                void decompress(const char*& next, const char* const end, std::string& output, const std::size_t max_output) {
+                    while (output.size() < max_output) {
+                        if (m_state == state::transparent) {
+                            const auto size = std::min(static_cast<std::size_t>(end - next), max_output - output.size());
+                            output.append(next, size);
+                            next += size;
+                            return;
+                        }
+
+                        if (m_state == state::garbage) {
+                            next = end;
+                            return;
+                        }
+
+                        if (m_state != state::in_member) {
+                            if (end - next < 2) {
+                                return; // need more input
+                            }
+                            if (!has_gzip_magic(next, static_cast<std::size_t>(end - next))) {
+                                m_state = m_state == state::start ? state::transparent : state::garbage;
+                                continue;
+                            }
+                            const int result = m_initialized ? inflateReset(&m_zstream)
+                                                             : inflateInit2(&m_zstream, MAX_WBITS | 16); // NOLINT(hicpp-signed-bitwise)
+                            if (result != Z_OK) {
+                                throw_zlib_error(m_zstream, "decompression init failed", result);
+                            }
+                            m_initialized = true;
+                            m_state = state::in_member;
+                        }
+
+                        const std::size_t old_size = output.size();
+                        const std::size_t chunk_size = std::min(max_output - old_size, static_cast<std::size_t>(osmium::io::Decompressor::input_buffer_size));
+                        output.resize(old_size + chunk_size);
+
+                        m_zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(next));
+                        m_zstream.avail_in = static_cast<unsigned int>(std::min(static_cast<std::size_t>(end - next), static_cast<std::size_t>(std::numeric_limits<unsigned int>::max())));
+                        m_zstream.next_out = reinterpret_cast<unsigned char*>(&output[old_size]);
+                        m_zstream.avail_out = static_cast<unsigned int>(chunk_size);
+
+                        const int result = inflate(&m_zstream, Z_NO_FLUSH);
+
+                        next = reinterpret_cast<const char*>(m_zstream.next_in);
+                        output.resize(old_size + chunk_size - m_zstream.avail_out);
+
+                        if (result == Z_STREAM_END) {
+                            m_state = state::after_member;
+                        } else if (result == Z_BUF_ERROR) {
+                            return; // need more input
+                        } else if (result != Z_OK) {
+                            throw_zlib_error(m_zstream, "inflate failed", result);
+                        } else if (next == end && m_zstream.avail_out != 0) {
+                            return; // need more input
+                        }
+                    }
+                }
+
+                /**
+                 * Called at the end of the input. Less than two bytes at
+                 * the start are passed through, because they can't be
+                 * gzip data.
+                 *
+                 * @throws gzip_error If the input ended inside a member.
+                 */
+                void finish(const char*& next, const char* const end, std::string& output) const {
+                    if (m_state == state::in_member) {
+                        throw osmium::gzip_error{"gzip error: read failed: unexpected end of file", Z_BUF_ERROR};
+                    }
+                    if (m_state == state::start || m_state == state::transparent) {
+                        output.append(next, end);
+                    }
+                    next = end;
+                }
+
+            }; // class gzip_stream_decoder
+
+            /**
+             * Unit finder for the ParallelDecompressor. A unit is a gzip
+             * member written by the GzipParallelCompressor. Any other gzip
+             * data is decompressed sequentially.
+             */
+            class gzip_member_finder {
+
+                bool m_found_any = false;
+
+            public:
+
+                unit_result operator()(const char* data, const std::size_t size, const bool input_done, std::size_t& unit_size) {
+                    if (size < 2 && !input_done) {
+                        return unit_result::incomplete;
+                    }
+
+                    if (!has_gzip_magic(data, size)) {
+                        // The stream decoder passes data that isn't
+                        // gzip-compressed through, but only at the start.
+                        return m_found_any ? unit_result::ignore_rest : unit_result::not_found;
+                    }
+
+                    if (size < gzip_member_header_size) {
+                        return unit_result::incomplete;
+                    }
+
+                    const auto member_size = gzip_member_size(data, size);
+                    if (member_size == 0) {
+                        return unit_result::not_found;
+                    }
+                    if (member_size > size) {
+                        return unit_result::incomplete;
+                    }
+
+                    m_found_any = true;
+                    unit_size = member_size;
+                    return unit_result::found;
+                }
+
+            }; // class gzip_member_finder
+
+        } // namespace detail
+
+        /**
+         * Compressor for gzip files using the threads in the pool.
+         *
+         * The data is split into blocks of (at least) block_size bytes
+         * which are compressed independently into gzip members, the
+         * resulting file is a normal gzip file readable by any gzip tool.
+         * Because the members are independent, the GzipParallelDecompressor
+         * can decompress them in parallel again.
+         */
+        class GzipParallelCompressor final : public detail::ParallelCompressor<detail::gzip_block_compressor> {
+
+        public:
+
+            enum : std::size_t {
+                default_block_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Create compressor.
+             *
+             * @param fd File descriptor to write to.
+             * @param sync Should the file be synced on close?
+             * @param pool Thread pool to use.
+             * @param block_size Minimum size of the uncompressed data in
+             *        each gzip member.
+             */
+            GzipParallelCompressor(const int fd,
+                                   const fsync sync,
+                                   osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                   const std::size_t block_size = default_block_size) :
+                ParallelCompressor(fd, sync, pool, detail::gzip_block_compressor{}, block_size, "gzip_compress") {
+            }
+
+        }; // class GzipParallelCompressor
+
+        /**
+         * Decompressor for gzip files using the threads in the pool.
+         *
+         * Files written by the GzipParallelCompressor consist of many
+         * gzip members with their sizes recorded in the header, these
+         * are decompressed in parallel. Any other gzip file (or the rest
+         * of it after the first member not written by the
+         * GzipParallelCompressor) is decompressed in the reading thread.
+         * Like the GzipDecompressor data that is not gzip-compressed at
+         * all is passed through unchanged and garbage after the last
+         * gzip member is ignored.
+         */
+        class GzipParallelDecompressor final : public detail::ParallelDecompressor<detail::gzip_member_finder, detail::gzip_stream_decoder> {
+
+        public:
+
+            enum : std::size_t {
+                default_max_member_size = 16UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Create decompressor.
+             *
+             * @param fd File descriptor to read from.
+             * @param pool Thread pool to use.
+             * @param max_member_size If a member is larger than this (in
+             *        compressed bytes), the rest of the file is
+             *        decompressed in the calling thread.
+             */
+            explicit GzipParallelDecompressor(const int fd,
+                                              osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                              const std::size_t max_member_size = default_max_member_size) :
+                ParallelDecompressor(fd, pool, max_member_size, "gzip_decompress") {
+            }
+
+        }; // class GzipParallelDecompressor
+
         class GzipBufferDecompressor final : public Decompressor {
 
             const char* m_buffer;
@@ -293,7 +648,7 @@ namespace osmium {
                 if (m_buffer) {
                     const std::size_t buffer_size = 10240;
                     output.append(buffer_size, '\0');
-                    m_zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+                    m_zstream.next_out = reinterpret_cast<unsigned char*>(&output[0]);
                     m_zstream.avail_out = buffer_size;
                     const int result = inflate(&m_zstream, Z_SYNC_FLUSH);
 
@@ -327,8 +682,18 @@ namespace osmium {
             // we want the register_compression() function to run, setting
             // the variable is only a side-effect, it will never be used
             const bool registered_gzip_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::gzip,
-                [](const int fd, const fsync sync) { return new osmium::io::GzipCompressor{fd, sync}; },
-                [](const int fd) { return new osmium::io::GzipDecompressor{fd}; },
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) -> osmium::io::Compressor* {
+                    if (osmium::config::use_pool_threads_for_gzip_compression()) {
+                        return new osmium::io::GzipParallelCompressor{fd, sync, pool};
+                    }
+                    return new osmium::io::GzipCompressor{fd, sync};
+                },
+                [](const int fd, osmium::thread::Pool& pool) -> osmium::io::Decompressor* {
+                    if (osmium::config::use_pool_threads_for_gzip()) {
+                        return new osmium::io::GzipParallelDecompressor{fd, pool};
+                    }
+                    return new osmium::io::GzipDecompressor{fd};
+                },
                 [](const char* buffer, const std::size_t size) { return new osmium::io::GzipBufferDecompressor{buffer, size}; }
             );
 
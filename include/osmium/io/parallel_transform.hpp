@@ -0,0 +1,173 @@
+#ifndef OSMIUM_IO_PARALLEL_TRANSFORM_HPP
+#define OSMIUM_IO_PARALLEL_TRANSFORM_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            inline std::size_t get_transform_queue_size() noexcept {
+                return osmium::config::get_max_queue_size("TRANSFORM", 20);
+            }
+
+            /**
+             * Task running the user function on one buffer. The input
+             * buffer is given back to the reader for re-use if the
+             * function didn't move it away.
+             */
+            template <typename TFunction>
+            class transform_task {
+
+                TFunction* m_function;
+                osmium::io::Reader* m_reader;
+                osmium::memory::Buffer m_buffer;
+
+            public:
+
+                transform_task(TFunction& function, osmium::io::Reader& reader, osmium::memory::Buffer&& buffer) noexcept :
+                    m_function(&function),
+                    m_reader(&reader),
+                    m_buffer(std::move(buffer)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    osmium::memory::Buffer result{(*m_function)(m_buffer)};
+                    if (m_buffer) {
+                        m_reader->recycle(std::move(m_buffer));
+                    }
+
+                    // An invalid buffer marks the end of data in the queue,
+                    // so it has to be replaced by an (empty) valid one.
+                    if (!result) {
+                        return osmium::memory::Buffer{osmium::memory::align_bytes, osmium::memory::Buffer::auto_grow::no};
+                    }
+
+                    return result;
+                }
+
+            }; // class transform_task
+
+        } // namespace detail
+
+        /**
+         * Read all buffers from the reader, run the function on each of
+         * them in the thread pool and give the resulting buffers to the
+         * sink in the original order. This is a "map" stage between a
+         * Reader and a Writer (or anything else taking buffers) that uses
+         * all threads of the pool.
+         *
+         * The function is called as
+         * `osmium::memory::Buffer function(osmium::memory::Buffer& input)`
+         * for each buffer from several threads at the same time, so it must
+         * not change any shared state without synchronization. It can
+         * change the input buffer in place and return it (moved) or
+         * create a new buffer. If the input buffer is still valid after
+         * the call, it is given back to the reader for re-use.
+         *
+         * The sink is called as `sink(osmium::memory::Buffer&&)` in the
+         * thread calling this function. Empty buffers are not given to
+         * the sink. An osmium::io::Writer can be used as sink directly.
+         *
+         * Do not call this from a thread of the pool.
+         *
+         * @param reader The reader to get the data from.
+         * @param function Function transforming a buffer.
+         * @param sink Function object getting the transformed buffers.
+         * @param pool The thread pool to use.
+         * @throws Any exception thrown by the reader, the function, or the
+         *         sink.
+         */
+        template <typename TFunction, typename TSink>
+        void parallel_transform(osmium::io::Reader& reader, TFunction&& function, TSink&& sink,
+                                osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            using function_type = typename std::remove_reference<TFunction>::type;
+
+            detail::buffer_queue_type queue{detail::get_transform_queue_size(), "transform"};
+            std::atomic<bool> done{false};
+
+            osmium::thread::thread_handler producer{[&reader, &function, &queue, &done, &pool]() {
+                osmium::thread::set_thread_name("_osmium_map");
+                try {
+                    while (!done) {
+                        osmium::memory::Buffer buffer{reader.read()};
+                        if (!buffer) {
+                            break;
+                        }
+                        detail::submit_to_queue(pool, queue, detail::transform_task<function_type>{function, reader, std::move(buffer)});
+                    }
+                } catch (...) {
+                    detail::add_to_queue(queue, std::current_exception());
+                }
+                detail::add_end_of_data_to_queue(queue);
+            }};
+
+            detail::queue_wrapper<osmium::memory::Buffer> results{queue};
+            try {
+                while (true) {
+                    osmium::memory::Buffer buffer{results.pop()};
+                    if (detail::at_end_of_data(buffer)) {
+                        break;
+                    }
+                    if (buffer.committed() > 0) {
+                        sink(std::move(buffer));
+                    }
+                }
+            } catch (...) {
+                done = true;
+                results.drain();
+                throw;
+            }
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PARALLEL_TRANSFORM_HPP
@@ -0,0 +1,451 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/blob_selection.hpp>
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_index_data.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <protozero/data_view.hpp>
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Read exactly size bytes from fd into buffer starting at
+             * position pos in the buffer. The buffer is resized to
+             * pos + size bytes.
+             *
+             * @returns false if we are at the end of the file
+             * @throws osmium::pbf_error if the file ends in the middle
+             */
+            inline bool read_exactly(int fd, std::string& buffer, std::size_t size, std::size_t pos = 0) {
+                buffer.resize(pos + size);
+                std::size_t offset = 0;
+                while (offset < size) {
+                    const auto nread = reliable_read(fd, &buffer[pos + offset], static_cast<unsigned int>(size - offset));
+                    if (nread == 0) {
+                        if (offset == 0) {
+                            return false;
+                        }
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    offset += static_cast<std::size_t>(nread);
+                }
+                return true;
+            }
+
+            /**
+             * Read the length and BlobHeader of the next blob from fd into
+             * buffer (which will contain exactly those bytes afterwards).
+             * The data views in the info point into the buffer.
+             *
+             * @returns false if we are at the end of the file
+             * @throws osmium::pbf_error if the data is invalid
+             */
+            inline bool read_blob_header(int fd, std::string& buffer, pbf_blob_header_info& info) {
+                if (!read_exactly(fd, buffer, 4)) {
+                    return false;
+                }
+
+                const auto header_size = decode_blob_header_size(buffer.data());
+                if (!read_exactly(fd, buffer, header_size, 4)) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+
+                info = decode_blob_header(protozero::data_view{buffer.data() + 4, header_size});
+
+                return true;
+            }
+
+            /**
+             * Find out which types of entities and which range of IDs are
+             * in the given (uncompressed) PrimitiveBlock. This is used for
+             * blobs without index data in the BlobHeader.
+             */
+            inline pbf_blob_index_data scan_primitive_block(const protozero::data_view& data) {
+                pbf_blob_index_data index_data;
+
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group{pbf_primitive_block.get_view()};
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Node> pbf_node{pbf_primitive_group.get_view()};
+                                    if (pbf_node.next(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint)) {
+                                        index_data.add(osmium::osm_entity_bits::node, pbf_node.get_sint64());
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{pbf_primitive_group.get_view()};
+                                    while (pbf_dense_nodes.next(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited)) {
+                                        osmium::object_id_type id = 0;
+                                        for (const auto delta : pbf_dense_nodes.get_packed_sint64()) {
+                                            id += delta;
+                                            index_data.add(osmium::osm_entity_bits::node, id);
+                                        }
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Way> pbf_way{pbf_primitive_group.get_view()};
+                                    if (pbf_way.next(OSMFormat::Way::required_int64_id, protozero::pbf_wire_type::varint)) {
+                                        index_data.add(osmium::osm_entity_bits::way, pbf_way.get_int64());
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Relation> pbf_relation{pbf_primitive_group.get_view()};
+                                    if (pbf_relation.next(OSMFormat::Relation::required_int64_id, protozero::pbf_wire_type::varint)) {
+                                        index_data.add(osmium::osm_entity_bits::relation, pbf_relation.get_int64());
+                                    }
+                                }
+                                break;
+                            default:
+                                pbf_primitive_group.skip();
+                        }
+                    }
+                }
+
+                return index_data;
+            }
+
+            inline void append_uint64(std::string& out, uint64_t value) {
+                for (int i = 0; i < 8; ++i) {
+                    out += static_cast<char>(value & 0xffU);
+                    value >>= 8U;
+                }
+            }
+
+            inline uint64_t get_uint64(const char* data) noexcept {
+                uint64_t value = 0;
+                for (int i = 7; i >= 0; --i) {
+                    value = (value << 8U) | static_cast<unsigned char>(data[i]);
+                }
+                return value;
+            }
+
+        } // namespace detail
+
+        /**
+         * Index of the data blobs in a PBF file. For each blob it contains
+         * the offset in the file, the types of OSM entities and the range
+         * of IDs in that blob. This can be used to read only the blobs
+         * containing specific entity types or IDs:
+         *
+         * @code
+         * osmium::io::PBFBlobIndex index{"input.osm.pbf"};
+         * osmium::io::Reader reader{"input.osm.pbf",
+         *                           index.select(osmium::osm_entity_bits::way, 1000, 2000),
+         *                           osmium::osm_entity_bits::way};
+         * @endcode
+         *
+         * Note that the reader will still return all objects from the
+         * selected blobs, so you have to check the IDs if you only need
+         * some.
+         *
+         * The index can be written to and read from a file ("sidecar")
+         * next to the PBF file so it only needs to be created once.
+         */
+        class PBFBlobIndex {
+
+        public:
+
+            struct entry {
+
+                /// Offset of the blob in the file.
+                uint64_t offset;
+
+                /// Size of the blob including its BlobHeader.
+                uint64_t size;
+
+                /// Types of entities in this blob.
+                osmium::osm_entity_bits::type types;
+
+                /// Smallest ID of any object in this blob.
+                osmium::object_id_type min_id;
+
+                /// Largest ID of any object in this blob.
+                osmium::object_id_type max_id;
+
+            }; // struct entry
+
+        private:
+
+            // Magic bytes and format version at the start of a sidecar file.
+            static constexpr const char* sidecar_magic() noexcept {
+                return "OSMBLIDX";
+            }
+
+            enum {
+                sidecar_version = 1,
+                sidecar_header_size = 8 + 8 + 8 + 8,
+                sidecar_entry_size = 5 * 8
+            };
+
+            std::vector<entry> m_entries;
+
+            uint64_t m_file_size = 0;
+
+            void scan(int fd) {
+                m_file_size = osmium::file_size(fd);
+
+                std::string buffer;
+                std::string blob_data;
+                std::string uncompressed;
+                detail::pbf_blob_header_info info;
+                uint64_t offset = 0;
+                bool first = true;
+
+                while (detail::read_blob_header(fd, buffer, info)) {
+                    const uint64_t blob_size = info.blob_size();
+
+                    if (first) {
+                        if (info.type != protozero::data_view{"OSMHeader"}) {
+                            throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                        }
+                        first = false;
+                        osmium::file_seek(fd, offset + blob_size);
+                    } else if (info.type == protozero::data_view{"OSMData"}) {
+                        auto index_data = detail::decode_blob_index_data(info.index_data);
+                        if (index_data.valid()) {
+                            osmium::file_seek(fd, offset + blob_size);
+                        } else {
+                            // No index data, we have to decode the blob
+                            if (!detail::read_exactly(fd, blob_data, info.data_size)) {
+                                throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                            }
+                            index_data = detail::scan_primitive_block(detail::decode_blob(blob_data, uncompressed));
+                        }
+                        m_entries.push_back(entry{offset, blob_size, index_data.types, index_data.min_id, index_data.max_id});
+                    } else {
+                        // ignore unknown blob types
+                        osmium::file_seek(fd, offset + blob_size);
+                    }
+
+                    offset += blob_size;
+                }
+
+                if (offset != m_file_size) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+            }
+
+        public:
+
+            /// Create an empty index.
+            PBFBlobIndex() = default;
+
+            /**
+             * Create the index by scanning the given PBF file. Only the
+             * BlobHeaders are read if they contain index data (which is
+             * only the case for files written by Osmium with the output
+             * file option pbf_add_index_data=true), otherwise all blobs
+             * have to be decompressed and scanned. Only uncompressed PBF
+             * files are supported (ie. no .osm.pbf.gz etc.).
+             *
+             * @param filename Name of the PBF file.
+             * @throws std::system_error If the file can not be opened.
+             * @throws osmium::pbf_error If the file isn't a valid PBF file.
+             */
+            explicit PBFBlobIndex(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    scan(fd);
+                } catch (...) {
+                    detail::reliable_close(fd);
+                    throw;
+                }
+                detail::reliable_close(fd);
+            }
+
+            /**
+             * The name of the sidecar file usually used to store the index
+             * for the given PBF file.
+             */
+            static std::string sidecar_filename(const std::string& filename) {
+                return filename + ".idx";
+            }
+
+            /**
+             * Size of the PBF file this index was created from. Compare this
+             * with the current file size to detect an outdated sidecar file.
+             */
+            uint64_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            /// The number of data blobs in the index.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            std::vector<entry>::const_iterator begin() const noexcept {
+                return m_entries.cbegin();
+            }
+
+            std::vector<entry>::const_iterator end() const noexcept {
+                return m_entries.cend();
+            }
+
+            /**
+             * Select all blobs that contain any of the given entity types
+             * and whose ID range overlaps [min_id, max_id].
+             *
+             * @returns Selection to be given to the Reader constructor.
+             */
+            osmium::io::blob_selection select(osmium::osm_entity_bits::type types,
+                                              osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::min(),
+                                              osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::max()) const {
+                std::vector<uint64_t> offsets;
+                for (const auto& e : m_entries) {
+                    if ((e.types & types) && e.max_id >= min_id && e.min_id <= max_id) {
+                        offsets.push_back(e.offset);
+                    }
+                }
+                return osmium::io::blob_selection{std::move(offsets)};
+            }
+
+            /**
+             * Write index to a sidecar file.
+             *
+             * @param filename Name of the sidecar file.
+             * @param allow_overwrite Allow overwriting of existing file?
+             * @throws std::system_error If the file can not be written.
+             */
+            void write(const std::string& filename, osmium::io::overwrite allow_overwrite = osmium::io::overwrite::no) const {
+                std::string data{sidecar_magic()};
+                detail::append_uint64(data, sidecar_version);
+                detail::append_uint64(data, m_file_size);
+                detail::append_uint64(data, m_entries.size());
+                for (const auto& e : m_entries) {
+                    detail::append_uint64(data, e.offset);
+                    detail::append_uint64(data, e.size);
+                    detail::append_uint64(data, static_cast<uint64_t>(e.types));
+                    detail::append_uint64(data, static_cast<uint64_t>(e.min_id));
+                    detail::append_uint64(data, static_cast<uint64_t>(e.max_id));
+                }
+
+                const int fd = detail::open_for_writing(filename, allow_overwrite);
+                try {
+                    detail::reliable_write(fd, data.data(), data.size());
+                } catch (...) {
+                    detail::reliable_close(fd);
+                    throw;
+                }
+                detail::reliable_close(fd);
+            }
+
+            /**
+             * Read index from a sidecar file.
+             *
+             * @param filename Name of the sidecar file.
+             * @throws std::system_error If the file can not be read.
+             * @throws osmium::io_error If the file is not a valid index.
+             */
+            static PBFBlobIndex read(const std::string& filename) {
+                std::string data;
+                const int fd = detail::open_for_reading(filename);
+                try {
+                    const auto size = osmium::file_size(fd);
+                    if (size > 0 && !detail::read_exactly(fd, data, size)) {
+                        throw osmium::io_error{"error reading PBF blob index file"};
+                    }
+                } catch (...) {
+                    detail::reliable_close(fd);
+                    throw;
+                }
+                detail::reliable_close(fd);
+
+                if (data.size() < sidecar_header_size ||
+                    std::strncmp(data.data(), sidecar_magic(), 8) != 0 ||
+                    detail::get_uint64(data.data() + 8) != sidecar_version) {
+                    throw osmium::io_error{"not a PBF blob index file or wrong version"};
+                }
+
+                PBFBlobIndex index;
+                index.m_file_size = detail::get_uint64(data.data() + 16);
+                const auto count = detail::get_uint64(data.data() + 24);
+                if ((data.size() - sidecar_header_size) / sidecar_entry_size != count ||
+                    (data.size() - sidecar_header_size) % sidecar_entry_size != 0) {
+                    throw osmium::io_error{"PBF blob index file has wrong size"};
+                }
+
+                index.m_entries.reserve(count);
+                for (const char* d = data.data() + sidecar_header_size; d != data.data() + data.size(); d += sidecar_entry_size) {
+                    index.m_entries.push_back(entry{
+                        detail::get_uint64(d),
+                        detail::get_uint64(d + 8),
+                        static_cast<osmium::osm_entity_bits::type>(detail::get_uint64(d + 16) & osmium::osm_entity_bits::all),
+                        static_cast<osmium::object_id_type>(detail::get_uint64(d + 24)),
+                        static_cast<osmium::object_id_type>(detail::get_uint64(d + 32))
+                    });
+                }
+
+                return index;
+            }
+
+        }; // class PBFBlobIndex
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
@@ -0,0 +1,252 @@
+#ifndef OSMIUM_IO_PBF_RAW_BLOB_HPP
+#define OSMIUM_IO_PBF_RAW_BLOB_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_index_data.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <protozero/data_view.hpp>
+
+#include <cstddef>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * A data blob from a PBF file in its original (usually compressed)
+         * form. It can be written unchanged to a PBF file with
+         * Writer::write_raw_blob() or decoded with decode_raw_blob().
+         */
+        struct pbf_raw_blob {
+
+            /// Complete blob including length prefix and BlobHeader.
+            std::string data;
+
+            /// Size of the BlobHeader.
+            std::size_t header_size = 0;
+
+            /**
+             * Types of entities in this blob. This is only available if
+             * the file was written with index data (which Osmium only does
+             * if the output file option pbf_add_index_data=true is set),
+             * otherwise it is osm_entity_bits::nothing.
+             */
+            osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+            /// Smallest ID of any object in this blob (if types is set).
+            osmium::object_id_type min_id = 0;
+
+            /// Largest ID of any object in this blob (if types is set).
+            osmium::object_id_type max_id = 0;
+
+        }; // struct pbf_raw_blob
+
+        /**
+         * Read the data blobs of a PBF file without decompressing or
+         * decoding them. This is much faster than reading the file with
+         * the Reader if the blobs are only copied to another PBF file
+         * (possibly after selecting some of them based on their types and
+         * ID ranges) or if they are decoded later in some other way.
+         *
+         * @code
+         * osmium::io::PBFRawBlobReader reader{"input.osm.pbf"};
+         * osmium::io::Writer writer{"output.osm.pbf", reader.header()};
+         * osmium::io::pbf_raw_blob blob;
+         * while (reader.read(blob)) {
+         *     if (blob.types & osmium::osm_entity_bits::way) {
+         *         writer.write_raw_blob(std::move(blob.data));
+         *     }
+         * }
+         * writer.close();
+         * reader.close();
+         * @endcode
+         *
+         * Only uncompressed PBF files are supported (ie. no .osm.pbf.gz
+         * etc.).
+         */
+        class PBFRawBlobReader {
+
+            osmium::io::Header m_header;
+
+            std::string m_buffer;
+
+            int m_fd;
+
+        public:
+
+            /**
+             * Open the given PBF file and read its header.
+             *
+             * @param filename Name of the PBF file.
+             * @throws std::system_error If the file can not be opened.
+             * @throws osmium::pbf_error If the file isn't a valid PBF file.
+             */
+            explicit PBFRawBlobReader(const std::string& filename) :
+                m_fd(detail::open_for_reading(filename)) {
+                try {
+                    detail::pbf_blob_header_info info;
+                    if (!detail::read_blob_header(m_fd, m_buffer, info) ||
+                        info.type != protozero::data_view{"OSMHeader"}) {
+                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                    }
+                    if (!detail::read_exactly(m_fd, m_buffer, info.data_size)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    m_header = detail::decode_header(m_buffer);
+                } catch (...) {
+                    close();
+                    throw;
+                }
+            }
+
+            PBFRawBlobReader(const PBFRawBlobReader&) = delete;
+            PBFRawBlobReader& operator=(const PBFRawBlobReader&) = delete;
+
+            PBFRawBlobReader(PBFRawBlobReader&&) = delete;
+            PBFRawBlobReader& operator=(PBFRawBlobReader&&) = delete;
+
+            ~PBFRawBlobReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// The header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /**
+             * Read the next OSMData blob from the file. Blobs of unknown
+             * types are skipped.
+             *
+             * @param blob The blob will be stored here.
+             * @returns false if the end of the file was reached.
+             * @throws osmium::pbf_error If the file isn't a valid PBF file.
+             */
+            bool read(pbf_raw_blob& blob) {
+                if (m_fd < 0) {
+                    return false;
+                }
+
+                detail::pbf_blob_header_info info;
+                while (detail::read_blob_header(m_fd, blob.data, info)) {
+                    if (info.type == protozero::data_view{"OSMData"}) {
+                        const auto index_data = detail::decode_blob_index_data(info.index_data);
+                        blob.header_size = info.header_size;
+                        blob.types = index_data.types;
+                        blob.min_id = index_data.min_id;
+                        blob.max_id = index_data.max_id;
+                        if (!detail::read_exactly(m_fd, blob.data, info.data_size, blob.data.size())) {
+                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                        }
+                        return true;
+                    }
+                    // ignore unknown blob types
+                    if (!detail::read_exactly(m_fd, m_buffer, info.data_size)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             * Close the file. Is called automatically by the destructor.
+             */
+            void close() {
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    if (fd > 0) { // don't close stdin
+                        detail::reliable_close(fd);
+                    }
+                }
+            }
+
+        }; // class PBFRawBlobReader
+
+        /**
+         * Decompress and decode a raw blob read with the PBFRawBlobReader.
+         *
+         * @param blob The raw blob.
+         * @param read_types Which types of OSM entities should be decoded.
+         * @param read_metadata Should metadata of OSM objects be decoded?
+         * @returns Buffer with the decoded OSM objects.
+         * @throws osmium::pbf_error If the blob isn't valid.
+         */
+        inline osmium::memory::Buffer decode_raw_blob(const pbf_raw_blob& blob,
+                                                      osmium::osm_entity_bits::type read_types = osmium::osm_entity_bits::all,
+                                                      osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) {
+            const std::size_t offset = 4 + blob.header_size;
+            if (blob.data.size() <= offset) {
+                throw osmium::pbf_error{"invalid blob"};
+            }
+            detail::PBFDataBlobDecoder decoder{protozero::data_view{blob.data.data() + offset, blob.data.size() - offset}, read_types, read_metadata};
+            auto buffer = decoder();
+
+            if (!buffer.has_nested_buffers()) {
+                return buffer;
+            }
+
+            // The decoder puts the data into nested buffers if it doesn't
+            // fit into the first one, copy everything into a single buffer.
+            osmium::memory::Buffer result{buffer.capacity() * 2, osmium::memory::Buffer::auto_grow::yes};
+            while (buffer.has_nested_buffers()) {
+                result.add_buffer(*buffer.get_last_nested());
+                result.commit();
+            }
+            result.add_buffer(buffer);
+            result.commit();
+
+            return result;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_RAW_BLOB_HPP
@@ -0,0 +1,167 @@
+#ifndef OSMIUM_IO_PIPELINE_STATS_HPP
+#define OSMIUM_IO_PIPELINE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/stats.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Runtime statistics of a Reader. Get them by calling
+         * Reader::stats() at any time while reading or after reading.
+         *
+         * The time counters are summed over all threads, so they can be
+         * larger than the wall clock time. Time spent waiting on queues is
+         * available in the queue statistics.
+         */
+        struct reader_stats {
+
+            /**
+             * Size of the input file. This is only filled in when reading
+             * from a regular file, it is 0 when reading from a buffer,
+             * stdin, or a pipe.
+             */
+            std::size_t file_size = 0;
+
+            /// Number of bytes read from the input file so far.
+            std::size_t bytes_read = 0;
+
+            /**
+             * Number of bytes handed to the parser after the file was
+             * decompressed (same as bytes_read for uncompressed files).
+             */
+            uint64_t bytes_decompressed = 0;
+
+            /// Number of (PBF) blobs decoded.
+            uint64_t blobs_decoded = 0;
+
+            /// Number of bytes in the (PBF) blobs after decompression.
+            uint64_t blob_bytes_decompressed = 0;
+
+            /// Number of buffers returned by Reader::read().
+            uint64_t buffers_read = 0;
+
+            /// Time spent in the read thread reading and decompressing.
+            std::chrono::nanoseconds read_busy{0};
+
+            /// Time spent decompressing (PBF) blobs.
+            std::chrono::nanoseconds blob_decompress_busy{0};
+
+            /// Time spent decoding (PBF) blobs into OSM objects.
+            std::chrono::nanoseconds blob_decode_busy{0};
+
+            /// Queue between the read thread and the parser.
+            osmium::thread::queue_stats input_queue;
+
+            /// Queue between the parser and Reader::read().
+            osmium::thread::queue_stats osmdata_queue;
+
+        }; // struct reader_stats
+
+        /**
+         * Runtime statistics of a Writer. Get them by calling
+         * Writer::stats() at any time while writing or after writing.
+         */
+        struct writer_stats {
+
+            /// Number of non-empty buffers handed to the output format.
+            uint64_t buffers_written = 0;
+
+            /// Number of bytes created by the output format (before
+            /// compression).
+            uint64_t bytes_encoded = 0;
+
+            /// Time spent in the write thread compressing and writing.
+            std::chrono::nanoseconds write_busy{0};
+
+            /// Queue between the output format and the write thread.
+            osmium::thread::queue_stats output_queue;
+
+        }; // struct writer_stats
+
+        namespace detail {
+
+            /**
+             * The counters behind reader_stats. They are updated from the
+             * different threads in the reading pipeline.
+             */
+            struct reader_counters {
+                std::atomic<uint64_t> bytes_decompressed{0};
+                std::atomic<uint64_t> blobs_decoded{0};
+                std::atomic<uint64_t> blob_bytes_decompressed{0};
+                std::atomic<uint64_t> buffers_read{0};
+                osmium::thread::detail::time_counter read_busy;
+                osmium::thread::detail::time_counter blob_decompress_busy;
+                osmium::thread::detail::time_counter blob_decode_busy;
+
+                void fill(reader_stats& stats) const noexcept {
+                    stats.bytes_decompressed = bytes_decompressed.load(std::memory_order_relaxed);
+                    stats.blobs_decoded = blobs_decoded.load(std::memory_order_relaxed);
+                    stats.blob_bytes_decompressed = blob_bytes_decompressed.load(std::memory_order_relaxed);
+                    stats.buffers_read = buffers_read.load(std::memory_order_relaxed);
+                    stats.read_busy = read_busy.get();
+                    stats.blob_decompress_busy = blob_decompress_busy.get();
+                    stats.blob_decode_busy = blob_decode_busy.get();
+                }
+            }; // struct reader_counters
+
+            /**
+             * The counters behind writer_stats.
+             */
+            struct writer_counters {
+                std::atomic<uint64_t> buffers_written{0};
+                std::atomic<uint64_t> bytes_encoded{0};
+                osmium::thread::detail::time_counter write_busy;
+
+                void fill(writer_stats& stats) const noexcept {
+                    stats.buffers_written = buffers_written.load(std::memory_order_relaxed);
+                    stats.bytes_encoded = bytes_encoded.load(std::memory_order_relaxed);
+                    stats.write_busy = write_busy.get();
+                }
+            }; // struct writer_counters
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PIPELINE_STATS_HPP
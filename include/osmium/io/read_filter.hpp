@@ -0,0 +1,234 @@
+#ifndef OSMIUM_IO_READ_FILTER_HPP
+#define OSMIUM_IO_READ_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * A filter on OSM objects that is applied by the parsers while
+         * reading a file. Give an object of this type to the Reader
+         * constructor and only objects matching the filter will be
+         * returned by the Reader.
+         *
+         * The filter can check the tags of objects: Only objects of the
+         * given types that have at least one tag matching the predicate
+         * will be returned. Objects of other types are not affected.
+         * The predicate is called with the key and value of a tag. This
+         * can be, for instance, an osmium::TagsFilter or an
+         * osmium::TagMatcher. The predicate is called from several
+         * threads at the same time, so it must not change any state.
+         *
+         * The filter can also check the locations and ids of nodes, see
+         * set_node_box() and set_node_ids(). Ways and relations are not
+         * affected by those.
+         *
+         * The PBF parser checks the filter before an object is decoded, so
+         * objects not matching the filter cost very little. Other parsers
+         * remove non-matching objects right after they have been parsed.
+         *
+         * A default constructed read_filter doesn't filter anything.
+         *
+         * Usage:
+         * @code
+         * osmium::TagsFilter filter{false};
+         * filter.add_rule(true, "amenity");
+         * osmium::io::Reader reader{"input.osm.pbf",
+         *     osmium::io::read_filter{filter, osmium::osm_entity_bits::nwr}};
+         * @endcode
+         */
+        class read_filter {
+
+            std::function<bool(const char*, const char*)> m_predicate{};
+            osmium::osm_entity_bits::type m_entities = osmium::osm_entity_bits::nothing;
+            osmium::Box m_node_box{};
+            const osmium::index::IdSetDense<osmium::unsigned_object_id_type>* m_node_ids = nullptr;
+
+        public:
+
+            /// Do not filter anything.
+            read_filter() = default;
+
+            /**
+             * Construct a filter.
+             *
+             * @param predicate Callable with the signature
+             *        bool(const char* key, const char* value).
+             * @param entities The types of objects this filter applies to.
+             */
+            template <typename TPredicate, typename std::enable_if<!std::is_same<typename std::decay<TPredicate>::type, read_filter>::value, int>::type = 0>
+            explicit read_filter(TPredicate&& predicate, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                m_predicate(std::forward<TPredicate>(predicate)),
+                m_entities(entities) {
+            }
+
+            /**
+             * Only read nodes with a location inside the given box. Nodes
+             * without a valid location are not read either. Setting an
+             * invalid box (such as a default constructed one) removes
+             * this filter.
+             *
+             * @returns Reference to this filter for chaining.
+             */
+            read_filter& set_node_box(const osmium::Box& box) noexcept {
+                m_node_box = box;
+                return *this;
+            }
+
+            /**
+             * Only read nodes with their ids in the given set. The set is
+             * not copied, it must be kept alive and must not be changed
+             * while the Reader is using this filter. Setting a nullptr
+             * removes this filter.
+             *
+             * @returns Reference to this filter for chaining.
+             */
+            read_filter& set_node_ids(const osmium::index::IdSetDense<osmium::unsigned_object_id_type>* ids) noexcept {
+                m_node_ids = ids;
+                return *this;
+            }
+
+            /// The types of objects the tag filter applies to.
+            osmium::osm_entity_bits::type entities() const noexcept {
+                return m_entities;
+            }
+
+            /// Does this filter apply to any objects?
+            bool empty() const noexcept {
+                return m_entities == osmium::osm_entity_bits::nothing &&
+                       !has_node_filter();
+            }
+
+            /// Is there a filter on node locations or ids?
+            bool has_node_filter() const noexcept {
+                return m_node_box.valid() || m_node_ids;
+            }
+
+            /**
+             * Check a node with the given id and location against the
+             * node box and node id set (but not the tags).
+             */
+            bool match_node(const osmium::object_id_type id, const osmium::Location location) const noexcept {
+                if (m_node_box.valid() && !(location.valid() && m_node_box.contains(location))) {
+                    return false;
+                }
+
+                return !m_node_ids || m_node_ids->get(static_cast<osmium::unsigned_object_id_type>(id));
+            }
+
+            /// Does the tag filter apply to objects of the given type?
+            bool applies_to(osmium::item_type type) const noexcept {
+                return (m_entities & osmium::osm_entity_bits::from_item_type(type)) != 0;
+            }
+
+            /// Does the tag with the given key and value match?
+            bool match(const char* key, const char* value) const {
+                return m_predicate(key, value);
+            }
+
+            /// Does any of the tags match?
+            bool match(const osmium::TagList& tags) const {
+                return std::any_of(tags.cbegin(), tags.cend(), [this](const osmium::Tag& tag) {
+                    return match(tag.key(), tag.value());
+                });
+            }
+
+            /**
+             * Should this entity be kept? Nodes have to match the node
+             * box and id set, if set. Then this is true for all entities
+             * of types the tag filter doesn't apply to and for entities
+             * with at least one matching tag.
+             */
+            bool operator()(const osmium::OSMEntity& entity) const {
+                if (entity.type() == osmium::item_type::node && has_node_filter()) {
+                    const auto& node = static_cast<const osmium::Node&>(entity);
+                    if (!match_node(node.id(), node.location())) {
+                        return false;
+                    }
+                }
+
+                if (!applies_to(entity.type())) {
+                    return true;
+                }
+
+                if (entity.type() == osmium::item_type::changeset) {
+                    return match(static_cast<const osmium::Changeset&>(entity).tags());
+                }
+
+                return match(static_cast<const osmium::OSMObject&>(entity).tags());
+            }
+
+        }; // class read_filter
+
+        namespace detail {
+
+            /**
+             * Commit the entity that was just added to the buffer if it
+             * matches the filter (or if there is no filter). Otherwise
+             * remove it from the buffer again.
+             */
+            inline void commit_if_wanted(osmium::memory::Buffer& buffer, const osmium::io::read_filter* filter) {
+                if (filter && !(*filter)(buffer.get<osmium::OSMEntity>(buffer.committed()))) {
+                    buffer.rollback();
+                    return;
+                }
+                buffer.commit();
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READ_FILTER_HPP
@@ -33,20 +33,29 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/blob_selection.hpp>
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/buffer_pool.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/read_thread.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/read_filter.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <atomic>
 #include <cerrno>
 #include <cstdlib>
 #include <fcntl.h>
@@ -94,6 +103,10 @@ namespace osmium {
             // here, because read() can only return a single unnested buffer.
             osmium::memory::Buffer m_back_buffers{};
 
+            // Buffers given back by the user through recycle() for re-use
+            // by the parser.
+            detail::BufferPool m_buffer_pool{};
+
             osmium::io::File m_file;
 
             osmium::thread::Pool* m_pool = nullptr;
@@ -109,13 +122,22 @@ namespace osmium {
 
             int m_childpid = 0;
 
-            detail::future_string_queue_type m_input_queue;
+            // Updated by the threads in the reading pipeline, see stats().
+            detail::reader_counters m_counters{};
+
+            detail::string_queue_type m_input_queue;
 
-            std::unique_ptr<osmium::io::Decompressor> m_decompressor;
+            // If the input is an uncompressed PBF file, it is memory-mapped
+            // and the parser reads the data directly from the mapping. In
+            // that case there is no decompressor and no read thread.
+            std::unique_ptr<osmium::util::MemoryMapping> m_mapping{};
+            detail::DirectInput m_direct_input{};
 
-            osmium::io::detail::ReadThreadManager m_read_thread_manager;
+            std::unique_ptr<osmium::io::Decompressor> m_decompressor{};
 
-            detail::future_buffer_queue_type m_osmdata_queue;
+            std::unique_ptr<osmium::io::detail::ReadThreadManager> m_read_thread_manager;
+
+            detail::buffer_queue_type m_osmdata_queue;
             detail::queue_wrapper<osmium::memory::Buffer> m_osmdata_queue_wrapper;
 
             std::future<osmium::io::Header> m_header_future{};
@@ -128,6 +150,26 @@ namespace osmium {
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
 
+            osmium::io::blob_selection m_blob_selection{};
+
+            osmium::io::read_filter m_read_filter{};
+
+            // The pool is needed before the other options are set, because
+            // the decompressor created in open_input() might use it.
+            static osmium::thread::Pool& pool_option() {
+                return osmium::thread::Pool::default_instance();
+            }
+
+            template <typename... TArgs>
+            static osmium::thread::Pool& pool_option(osmium::thread::Pool& pool, TArgs&&... /*args*/) noexcept {
+                return pool;
+            }
+
+            template <typename T, typename... TArgs>
+            static osmium::thread::Pool& pool_option(T&& /*option*/, TArgs&&... args) {
+                return pool_option(std::forward<TArgs>(args)...);
+            }
+
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
@@ -136,6 +178,14 @@ namespace osmium {
                 m_read_which_entities = value;
             }
 
+            void set_option(const osmium::io::blob_selection& value) {
+                m_blob_selection = value;
+            }
+
+            void set_option(const osmium::io::read_filter& value) {
+                m_read_filter = value;
+            }
+
             void set_option(osmium::io::read_meta value) noexcept {
                 // Ignore this setting if we have a history/change file,
                 // because if this is set to "no", we don't see the difference
@@ -148,11 +198,16 @@ namespace osmium {
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       const detail::ParserFactory::create_parser_type& creator,
-                                      detail::future_string_queue_type& input_queue,
-                                      detail::future_buffer_queue_type& osmdata_queue,
+                                      detail::string_queue_type& input_queue,
+                                      detail::buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
                                       osmium::osm_entity_bits::type read_which_entities,
-                                      osmium::io::read_meta read_metadata) {
+                                      osmium::io::read_meta read_metadata,
+                                      detail::DirectInput* direct_input,
+                                      const osmium::io::blob_selection* blobs,
+                                      detail::BufferPool* buffer_pool,
+                                      const osmium::io::read_filter* filter,
+                                      detail::reader_counters* counters) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -160,7 +215,12 @@ namespace osmium {
                     osmdata_queue,
                     promise,
                     read_which_entities,
-                    read_metadata
+                    read_metadata,
+                    direct_input,
+                    blobs,
+                    buffer_pool,
+                    filter,
+                    counters
                 };
                 creator(args)->parse();
             }
@@ -234,6 +294,76 @@ namespace osmium {
                 return osmium::io::detail::open_for_reading(filename);
             }
 
+            /**
+             * Try to memory-map the input file. This only works for regular
+             * files (not for stdin or data read from the network).
+             *
+             * @returns true if the file could be mapped, false otherwise.
+             */
+            bool map_input_file(const int fd) {
+                if (m_file.filename().empty() || m_childpid != 0) {
+                    return false;
+                }
+
+                const std::size_t size = osmium::file_size(fd);
+                if (size == 0) {
+                    return false;
+                }
+
+                try {
+                    m_mapping.reset(new osmium::util::MemoryMapping{size, osmium::util::MemoryMapping::mapping_mode::readonly, fd});
+                } catch (const std::system_error&) {
+                    return false; // fall back to reading through the read thread
+                }
+
+                osmium::io::detail::reliable_close(fd);
+
+                m_direct_input.set_data(m_mapping->get_addr<char>(), size);
+
+                return true;
+            }
+
+            /**
+             * Open the input. If possible, the data is made available to the
+             * parser directly in memory. Otherwise a decompressor is created
+             * and a read thread is started that sends the (decompressed)
+             * data to the parser through the input queue.
+             *
+             * @returns The manager for the read thread or nullptr if no
+             *          read thread is needed.
+             * @throws std::system_error if a system call fails.
+             */
+            std::unique_ptr<detail::ReadThreadManager> open_input() {
+                const auto& factory = osmium::io::CompressionFactory::instance();
+                const bool direct_input_possible = m_file.format() == file_format::pbf &&
+                                                   m_file.compression() == file_compression::none;
+
+                if (m_file.buffer()) {
+                    if (direct_input_possible) {
+                        m_direct_input.set_data(m_file.buffer(), m_file.buffer_size());
+                    } else {
+                        m_decompressor = factory.create_decompressor(m_file.compression(), m_file.buffer(), m_file.buffer_size());
+                    }
+                } else {
+                    const int fd = open_input_file_or_url(m_file.filename(), &m_childpid);
+                    if (!direct_input_possible ||
+                        !osmium::config::use_mmap_for_pbf_input() ||
+                        !map_input_file(fd)) {
+                        m_decompressor = factory.create_decompressor(m_file.compression(), fd, *m_pool);
+                    }
+                }
+
+                if (m_decompressor) {
+                    return std::unique_ptr<detail::ReadThreadManager>{new detail::ReadThreadManager{*m_decompressor, m_input_queue, &m_counters}};
+                }
+
+                // The input queue is not used, but the parser still
+                // expects the end of data marker in there.
+                detail::add_end_of_data_to_queue(m_input_queue);
+
+                return nullptr;
+            }
+
         public:
 
             /**
@@ -265,33 +395,38 @@ namespace osmium {
              *      For instance when your program will fork, using the
              *      statically initialized pool will not work.
              *
+             * * const osmium::io::blob_selection&: Read only the selected
+             *      blobs from the input file. Usually created from a
+             *      PBFBlobIndex. Only the PBF format supports this, other
+             *      formats ignore this setting.
+             *
+             * * const osmium::io::read_filter&: Read only objects with
+             *      tags matching this filter and/or only nodes inside a
+             *      bounding box or with ids from an id set. The parsers
+             *      check the filter before handing out objects, so this
+             *      is faster than filtering later.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
             explicit Reader(const osmium::io::File& file, TArgs&&... args) :
                 m_file(file.check()),
+                m_pool(&pool_option(args...)),
                 m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
                 m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
+                m_read_thread_manager(open_input()),
                 m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
                 m_osmdata_queue_wrapper(m_osmdata_queue),
-                m_file_size(m_decompressor->file_size()) {
+                m_file_size(m_decompressor ? m_decompressor->file_size() : (m_mapping ? m_mapping->size() : 0)) {
 
                 (void)std::initializer_list<int>{
                     (set_option(args), 0)...
                 };
 
-                if (!m_pool) {
-                    m_pool = &thread::Pool::default_instance();
-                }
-
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata};
+                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata, m_direct_input.valid() ? &m_direct_input : nullptr, m_blob_selection.all() ? nullptr : &m_blob_selection, &m_buffer_pool, m_read_filter.empty() ? nullptr : &m_read_filter, &m_counters};
             }
 
             template <typename... TArgs>
@@ -329,14 +464,19 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
-                m_read_thread_manager.stop();
+                m_direct_input.stop();
+                if (m_read_thread_manager) {
+                    m_read_thread_manager->stop();
+                }
 
                 m_osmdata_queue_wrapper.drain();
 
-                try {
-                    m_read_thread_manager.close();
-                } catch (...) {
-                    // Ignore any exceptions.
+                if (m_read_thread_manager) {
+                    try {
+                        m_read_thread_manager->close();
+                    } catch (...) {
+                        // Ignore any exceptions.
+                    }
                 }
 
 #ifndef _WIN32
@@ -391,6 +531,7 @@ namespace osmium {
 
                 // If there are buffers on the stack, return those first.
                 if (m_back_buffers) {
+                    m_counters.buffers_read.fetch_add(1, std::memory_order_relaxed);
                     if (m_back_buffers.has_nested_buffers()) {
                         buffer = std::move(*m_back_buffers.get_last_nested());
                     } else {
@@ -418,7 +559,9 @@ namespace osmium {
                         buffer = m_osmdata_queue_wrapper.pop();
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
-                            m_read_thread_manager.close();
+                            if (m_read_thread_manager) {
+                                m_read_thread_manager->close();
+                            }
                             return buffer;
                         }
                         if (buffer.has_nested_buffers()) {
@@ -426,8 +569,10 @@ namespace osmium {
                             buffer = std::move(*m_back_buffers.get_last_nested());
                         }
                         if (buffer.committed() > 0) {
+                            m_counters.buffers_read.fetch_add(1, std::memory_order_relaxed);
                             return buffer;
                         }
+                        m_buffer_pool.put(std::move(buffer));
                     }
                 } catch (...) {
                     close();
@@ -436,6 +581,22 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Give a buffer returned by read() back to the reader after you
+             * are done with it. The reader can then re-use the memory for
+             * future buffers instead of allocating new memory. This is
+             * optional, buffers not given back are simply freed when they
+             * go out of scope. Not all file formats make use of this.
+             *
+             * The content of the buffer is discarded. Make sure there are
+             * no references to anything in the buffer any more.
+             *
+             * This function is thread-safe.
+             */
+            void recycle(osmium::memory::Buffer&& buffer) {
+                m_buffer_pool.put(std::move(buffer));
+            }
+
             /**
              * Has the end of file been reached? This is set after the last
              * data has been read. It is also set by calling close().
@@ -445,8 +606,9 @@ namespace osmium {
             }
 
             /**
-             * Get the size of the input file. Returns 0 if the file size
-             * is not available (for instance when reading from stdin).
+             * Get the size of the input file. The size is only available
+             * when reading from a regular file, this returns 0 when reading
+             * from a buffer, stdin, or a pipe.
              */
             std::size_t file_size() const noexcept {
                 return m_file_size;
@@ -467,7 +629,31 @@ namespace osmium {
              * do an expensive system call.
              */
             std::size_t offset() const noexcept {
-                return m_decompressor->offset();
+                if (m_decompressor) {
+                    return m_decompressor->offset();
+                }
+                return m_direct_input.offset();
+            }
+
+            /**
+             * Get statistics about the reading pipeline: How much data was
+             * read and decoded, how much time the threads spent working
+             * and how often they had to wait for each other. This can be
+             * called at any time from any thread. It is cheap enough to be
+             * called periodically, for instance to show it in a progress
+             * display. Not all numbers are available for all file formats.
+             */
+            osmium::io::reader_stats stats() const noexcept {
+                osmium::io::reader_stats result;
+                result.file_size = m_file_size;
+                result.bytes_read = offset();
+                m_counters.fill(result);
+                if (m_direct_input.valid()) {
+                    result.bytes_decompressed = m_direct_input.offset();
+                }
+                result.input_queue = m_input_queue.stats();
+                result.osmdata_queue = m_osmdata_queue.stats();
+                return result;
             }
 
         }; // class Reader
@@ -41,6 +41,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/pool.hpp>
@@ -48,6 +49,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/config.hpp>
 #include <osmium/version.hpp>
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <exception>
@@ -105,7 +107,10 @@ namespace osmium {
 
             osmium::io::File m_file;
 
-            detail::future_string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
+            // Updated by the write thread, see stats().
+            detail::writer_counters m_counters{};
+
+            detail::string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output{nullptr};
 
@@ -124,17 +129,20 @@ namespace osmium {
             } m_status = status::okay;
 
             // This function will run in a separate thread.
-            static void write_thread(detail::future_string_queue_type& output_queue,
+            static void write_thread(detail::string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
-                                     std::promise<std::size_t>&& write_promise) {
+                                     std::promise<std::size_t>&& write_promise,
+                                     detail::writer_counters* counters) {
                 detail::WriteThread write_thread{output_queue,
                                                  std::move(compressor),
-                                                 std::move(write_promise)};
+                                                 std::move(write_promise),
+                                                 counters};
                 write_thread();
             }
 
             void do_write(osmium::memory::Buffer&& buffer) {
                 if (buffer && buffer.committed() > 0) {
+                    m_counters.buffers_written.fetch_add(1, std::memory_order_relaxed);
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -147,6 +155,7 @@ namespace osmium {
                     using std::swap;
                     swap(m_buffer, buffer);
 
+                    m_counters.buffers_written.fetch_add(1, std::memory_order_relaxed);
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -256,11 +265,12 @@ namespace osmium {
                 std::unique_ptr<osmium::io::Compressor> compressor =
                     CompressionFactory::instance().create_compressor(file.compression(),
                                                                      osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
+                                                                     options.sync,
+                                                                     *options.pool);
 
                 std::promise<std::size_t> write_promise;
                 m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
+                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_counters};
 
                 ensure_cleanup([&](){
                     m_output->write_header(options.header);
@@ -334,6 +344,26 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Write a raw data blob as returned by the PBFRawBlobReader
+             * unchanged to the output file. Any objects written before are
+             * flushed first, so the order is kept. Only works for PBF
+             * files. The blob is not checked in any way, it is up to the
+             * caller to make sure it fits the header of the output file
+             * (for instance by using the header of the input file).
+             *
+             * @param data Data of the blob. It is moved into this function.
+             * @throws Some form of osmium::io_error when there is a problem,
+             *         if the output format is not PBF, or if the data is
+             *         empty.
+             */
+            void write_raw_blob(std::string&& data) {
+                ensure_cleanup([&](){
+                    do_flush();
+                    m_output->write_raw_blob(std::move(data));
+                });
+            }
+
             /**
              * Add item to the internal buffer for eventual writing to the
              * output file.
@@ -377,6 +407,17 @@ namespace osmium {
                 return 0;
             }
 
+            /**
+             * Get statistics about the writing pipeline. This can be
+             * called at any time from any thread, also after close().
+             */
+            osmium::io::writer_stats stats() const noexcept {
+                osmium::io::writer_stats result;
+                m_counters.fill(result);
+                result.output_queue = m_output_queue.stats();
+                return result;
+            }
+
         }; // class Writer
 
     } // namespace io
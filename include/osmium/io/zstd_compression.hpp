@@ -0,0 +1,389 @@
+#ifndef OSMIUM_IO_ZSTD_COMPRESSION_HPP
+#define OSMIUM_IO_ZSTD_COMPRESSION_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read or write zstd-compressed OSM
+ * files.
+ *
+ * @attention If you include this file, you'll need to link with `libzstd`.
+ */
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compression.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <zstd.h>
+#include <zstd_errors.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there are problems compressing or
+     * decompressing zstd files.
+     */
+    struct zstd_error : public io_error {
+
+        std::size_t zstd_error_code = 0;
+
+        explicit zstd_error(const std::string& what) :
+            io_error(what) {
+        }
+
+        zstd_error(const std::string& what, const std::size_t error_code) :
+            io_error(what),
+            zstd_error_code(error_code) {
+        }
+
+    }; // struct zstd_error
+
+    namespace io {
+
+        namespace detail {
+
+            [[noreturn]] inline void throw_zstd_error(const char* msg, const std::size_t result) {
+                std::string error{"zstd error: "};
+                error += msg;
+                error += ": ";
+                error += ::ZSTD_getErrorName(result);
+                throw osmium::zstd_error{error, result};
+            }
+
+            /**
+             * Streaming zstd decoder. Handles any number of zstd frames
+             * one after the other.
+             */
+            class zstd_stream_decoder {
+
+                struct dctx_deleter {
+                    void operator()(ZSTD_DCtx* ctx) const noexcept {
+                        ::ZSTD_freeDCtx(ctx);
+                    }
+                };
+
+                std::unique_ptr<ZSTD_DCtx, dctx_deleter> m_dctx;
+                bool m_in_frame = false;
+
+            public:
+
+                zstd_stream_decoder() :
+                    m_dctx(::ZSTD_createDCtx()) {
+                    if (!m_dctx) {
+                        throw zstd_error{"zstd error: can not create decompression context"};
+                    }
+                }
+
+                /// Is the decoder in the middle of a frame?
+                bool in_frame() const noexcept {
+                    return m_in_frame;
+                }
+
+                /**
+                 * Decompress data from the range [next, end) and append it
+                 * to output until all input is used up or the output has
+                 * reached max_output bytes. Updates next to point to the
+                 * first byte not used.
+                 *
+                 * @throws zstd_error If the data is not valid.
+                 */
+                void decompress(const char*& next, const char* const end, std::string& output, const std::size_t max_output) {
+                    while (output.size() < max_output) {
+                        if (next == end && !m_in_frame) {
+                            return;
+                        }
+
+                        const std::size_t old_size = output.size();
+                        const std::size_t chunk_size = std::min(max_output - old_size, static_cast<std::size_t>(osmium::io::Decompressor::input_buffer_size));
+                        output.resize(old_size + chunk_size);
+
+                        ZSTD_inBuffer input{next, static_cast<std::size_t>(end - next), 0};
+                        ZSTD_outBuffer out{&output[old_size], chunk_size, 0};
+                        const std::size_t result = ::ZSTD_decompressStream(m_dctx.get(), &out, &input);
+
+                        next += input.pos;
+                        output.resize(old_size + out.pos);
+
+                        if (::ZSTD_isError(result)) {
+                            m_in_frame = false;
+                            throw_zstd_error("decompress failed", result);
+                        }
+                        m_in_frame = result != 0;
+
+                        if (next == end && out.pos < out.size) {
+                            return; // need more input
+                        }
+                    }
+                }
+
+                /**
+                 * Called at the end of the input.
+                 *
+                 * @throws zstd_error If the input ended inside a frame.
+                 */
+                void finish(const char*& /*next*/, const char* const /*end*/, std::string& /*output*/) const {
+                    if (m_in_frame) {
+                        throw zstd_error{"zstd error: unexpected end of file"};
+                    }
+                }
+
+            }; // class zstd_stream_decoder
+
+            // Block compressor for the ParallelCompressor writing a zstd
+            // frame.
+            class zstd_block_compressor {
+
+                struct cctx_deleter {
+                    void operator()(ZSTD_CCtx* ctx) const noexcept {
+                        ::ZSTD_freeCCtx(ctx);
+                    }
+                };
+
+                int m_compression_level;
+
+            public:
+
+                explicit zstd_block_compressor(const int compression_level) noexcept :
+                    m_compression_level(compression_level) {
+                }
+
+                std::string operator()(const std::string& data) const {
+                    const std::unique_ptr<ZSTD_CCtx, cctx_deleter> cctx{::ZSTD_createCCtx()};
+                    if (!cctx) {
+                        throw zstd_error{"zstd error: can not create compression context"};
+                    }
+
+                    std::size_t result = ::ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, m_compression_level);
+                    if (!::ZSTD_isError(result)) {
+                        // Add checksum like the zstd command line tool does
+                        result = ::ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_checksumFlag, 1);
+                    }
+                    if (::ZSTD_isError(result)) {
+                        throw_zstd_error("compression init failed", result);
+                    }
+
+                    std::string output(::ZSTD_compressBound(data.size()), '\0');
+                    result = ::ZSTD_compress2(cctx.get(), &*output.begin(), output.size(), data.data(), data.size());
+                    if (::ZSTD_isError(result)) {
+                        throw_zstd_error("compress failed", result);
+                    }
+                    output.resize(result);
+                    return output;
+                }
+
+            }; // class zstd_block_compressor
+
+            /**
+             * Unit finder for the ParallelDecompressor. A unit is a
+             * complete zstd frame found using the frame and block headers.
+             */
+            class zstd_frame_finder {
+
+            public:
+
+                unit_result operator()(const char* data, const std::size_t size, const bool /*input_done*/, std::size_t& unit_size) const {
+                    if (size == 0) {
+                        return unit_result::ignore_rest;
+                    }
+
+                    const std::size_t frame_size = ::ZSTD_findFrameCompressedSize(data, size);
+                    if (!::ZSTD_isError(frame_size)) {
+                        unit_size = frame_size;
+                        return unit_result::found;
+                    }
+
+                    if (::ZSTD_getErrorCode(frame_size) != ZSTD_error_srcSize_wrong) {
+                        // Not a zstd frame, let the sequential decoder
+                        // report the error after all results are in.
+                        return unit_result::not_found;
+                    }
+
+                    return unit_result::incomplete;
+                }
+
+            }; // class zstd_frame_finder
+
+        } // namespace detail
+
+        /**
+         * Compressor for zstd files using the threads in the pool.
+         *
+         * The data is split into blocks of (at least) block_size bytes
+         * which are compressed independently into zstd frames. The
+         * resulting file can be read by any zstd tool and the
+         * ZstdDecompressor can decompress the frames in parallel again.
+         */
+        class ZstdCompressor final : public detail::ParallelCompressor<detail::zstd_block_compressor> {
+
+        public:
+
+            enum : std::size_t {
+                default_block_size = 4UL * 1024UL * 1024UL
+            };
+
+            enum {
+                default_compression_level = 3
+            };
+
+            /**
+             * Create compressor.
+             *
+             * @param fd File descriptor to write to.
+             * @param sync Should the file be synced on close?
+             * @param pool Thread pool to use.
+             * @param block_size Minimum size of the uncompressed data in
+             *        each zstd frame.
+             * @param compression_level The zstd compression level.
+             */
+            ZstdCompressor(const int fd,
+                           const fsync sync,
+                           osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                           const std::size_t block_size = default_block_size,
+                           const int compression_level = default_compression_level) :
+                ParallelCompressor(fd, sync, pool, detail::zstd_block_compressor{compression_level}, block_size, "zstd_compress") {
+            }
+
+        }; // class ZstdCompressor
+
+        /**
+         * Decompressor for zstd files using the threads in the pool.
+         *
+         * Complete zstd frames are found using the frame and block headers
+         * and decompressed in parallel. Files written by the ZstdCompressor
+         * (or other tools writing many frames like pzstd) are decompressed
+         * fully in parallel. If a frame gets too large (because the file
+         * was created by the zstd command line tool, which writes only a
+         * single frame), the rest of the file is decompressed in the
+         * reading thread.
+         */
+        class ZstdDecompressor final : public detail::ParallelDecompressor<detail::zstd_frame_finder, detail::zstd_stream_decoder> {
+
+        public:
+
+            enum : std::size_t {
+                default_max_frame_size = 16UL * 1024UL * 1024UL
+            };
+
+            /**
+             * Create decompressor.
+             *
+             * @param fd File descriptor to read from.
+             * @param pool Thread pool to use.
+             * @param max_frame_size If a frame is larger than this (in
+             *        compressed bytes), the rest of the file is
+             *        decompressed in the calling thread.
+             */
+            explicit ZstdDecompressor(const int fd,
+                                      osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                      const std::size_t max_frame_size = default_max_frame_size) :
+                ParallelDecompressor(fd, pool, max_frame_size, "zstd_decompress") {
+            }
+
+        }; // class ZstdDecompressor
+
+        class ZstdBufferDecompressor final : public Decompressor {
+
+            const char* m_buffer;
+            const char* m_end;
+            detail::zstd_stream_decoder m_decoder{};
+
+        public:
+
+            ZstdBufferDecompressor(const char* buffer, const std::size_t size) :
+                m_buffer(buffer),
+                m_end(buffer + size) {
+            }
+
+            ZstdBufferDecompressor(const ZstdBufferDecompressor&) = delete;
+            ZstdBufferDecompressor& operator=(const ZstdBufferDecompressor&) = delete;
+
+            ZstdBufferDecompressor(ZstdBufferDecompressor&&) = delete;
+            ZstdBufferDecompressor& operator=(ZstdBufferDecompressor&&) = delete;
+
+            ~ZstdBufferDecompressor() noexcept override = default;
+
+            std::string read() override {
+                std::string output;
+
+                if (m_buffer) {
+                    m_decoder.decompress(m_buffer, m_end, output, osmium::io::Decompressor::input_buffer_size);
+                    if (output.empty()) {
+                        if (m_decoder.in_frame()) {
+                            throw zstd_error{"zstd error: unexpected end of data"};
+                        }
+                        m_buffer = nullptr;
+                    }
+                }
+
+                return output;
+            }
+
+            void close() override {
+                m_buffer = nullptr;
+            }
+
+        }; // class ZstdBufferDecompressor
+
+        namespace detail {
+
+            // we want the register_compression() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_zstd_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::zstd,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) { return new osmium::io::ZstdCompressor{fd, sync, pool}; },
+                [](const int fd, osmium::thread::Pool& pool) { return new osmium::io::ZstdDecompressor{fd, pool}; },
+                [](const char* buffer, const std::size_t size) { return new osmium::io::ZstdBufferDecompressor{buffer, size}; }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_zstd_compression() noexcept {
+                return registered_zstd_compression;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_ZSTD_COMPRESSION_HPP
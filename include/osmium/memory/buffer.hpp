@@ -504,6 +504,31 @@ namespace osmium {
                 return committed;
             }
 
+            /**
+             * Prepare the buffer for re-use. This clears the buffer, removes
+             * any nested buffers and the full callback and sets the auto
+             * grow policy. The memory is kept, so this is a cheap way of
+             * getting an empty buffer without a new memory allocation.
+             *
+             * Only valid buffers with internal memory management can be
+             * re-used. For other buffers this does nothing.
+             *
+             * @pre No builder can be open on this buffer.
+             *
+             * @param auto_grow Auto grow policy for the re-used buffer.
+             * @returns true if the buffer can be re-used, false otherwise.
+             */
+            bool reset_for_reuse(auto_grow auto_grow) {
+                if (!m_memory) {
+                    return false;
+                }
+                clear();
+                m_next_buffer.reset();
+                m_full = nullptr;
+                m_auto_grow = auto_grow;
+                return true;
+            }
+
             /**
              * Get the data in the buffer at the given offset.
              *
@@ -0,0 +1,256 @@
+#ifndef OSMIUM_PARALLEL_APPLY_HPP
+#define OSMIUM_PARALLEL_APPLY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * The handler replicas and the bookkeeping shared between the
+         * thread calling parallel_apply() and the tasks in the pool.
+         */
+        template <typename THandler>
+        class parallel_apply_state {
+
+            std::vector<THandler> m_handlers;
+            std::vector<THandler*> m_free_handlers;
+
+            std::mutex m_mutex;
+            std::condition_variable m_handler_free;
+            std::condition_variable m_all_done;
+            std::size_t m_outstanding = 0;
+            std::exception_ptr m_exception{};
+
+            // Get a handler not in use by another task. Returns nullptr if
+            // a task failed, so there is no need to do any more work.
+            THandler* acquire_handler() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_handler_free.wait(lock, [this] {
+                    return m_exception || !m_free_handlers.empty();
+                });
+                if (m_exception) {
+                    return nullptr;
+                }
+                THandler* handler = m_free_handlers.back();
+                m_free_handlers.pop_back();
+                return handler;
+            }
+
+        public:
+
+            template <typename TFactory>
+            parallel_apply_state(TFactory& factory, std::size_t num_handlers) {
+                m_handlers.reserve(num_handlers);
+                for (std::size_t i = 0; i < num_handlers; ++i) {
+                    m_handlers.push_back(factory());
+                }
+                for (auto& handler : m_handlers) {
+                    m_free_handlers.push_back(&handler);
+                }
+            }
+
+            std::vector<THandler>& handlers() noexcept {
+                return m_handlers;
+            }
+
+            bool failed() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_exception != nullptr;
+            }
+
+            void task_added() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                ++m_outstanding;
+            }
+
+            void task_not_added() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                --m_outstanding;
+            }
+
+            // Called from the pool threads. Never throws, exceptions from
+            // the handlers are stored and re-thrown by parallel_apply().
+            // This must be the last thing a task does, parallel_apply()
+            // might return as soon as the last task is finished.
+            void run(osmium::memory::Buffer&& buffer, osmium::io::Reader& reader) noexcept {
+                std::exception_ptr exception;
+                THandler* handler = nullptr;
+                try {
+                    handler = acquire_handler();
+                    if (handler) {
+                        for (auto& entity : buffer.select<osmium::OSMEntity>()) {
+                            osmium::apply_item(entity, *handler);
+                        }
+                    }
+                    reader.recycle(std::move(buffer));
+                } catch (...) {
+                    exception = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (handler) {
+                    m_free_handlers.push_back(handler);
+                    m_handler_free.notify_one();
+                }
+                if (exception && !m_exception) {
+                    m_exception = exception;
+                    m_handler_free.notify_all();
+                }
+                if (--m_outstanding == 0) {
+                    m_all_done.notify_all();
+                }
+            }
+
+            void wait_for_all_tasks() {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_all_done.wait(lock, [this] {
+                    return m_outstanding == 0;
+                });
+            }
+
+            void rethrow_exception() {
+                if (m_exception) {
+                    std::rethrow_exception(m_exception);
+                }
+            }
+
+        }; // class parallel_apply_state
+
+        template <typename THandler>
+        class parallel_apply_task {
+
+            parallel_apply_state<THandler>* m_state;
+            osmium::io::Reader* m_reader;
+            osmium::memory::Buffer m_buffer;
+
+        public:
+
+            parallel_apply_task(parallel_apply_state<THandler>& state, osmium::io::Reader& reader, osmium::memory::Buffer&& buffer) noexcept :
+                m_state(&state),
+                m_reader(&reader),
+                m_buffer(std::move(buffer)) {
+            }
+
+            void operator()() {
+                m_state->run(std::move(m_buffer), *m_reader);
+            }
+
+        }; // class parallel_apply_task
+
+    } // namespace detail
+
+    /**
+     * Apply the handler created by the factory to all objects read from
+     * the reader like osmium::apply() does, but use several threads from
+     * the pool. Every thread gets its own copy ("replica") of the handler
+     * created by calling the factory. Each buffer from the reader is handed
+     * to one of the replicas. When all data is read, flush() is called on
+     * all replicas and they are merged into the first one by calling
+     * merge(THandler& result, THandler& replica). The merged handler is
+     * returned.
+     *
+     * This only works for handlers that don't depend on the order of the
+     * objects, like handlers counting objects, collecting statistics or
+     * ids. Handlers for different buffers run at the same time, so they
+     * must not share any state without synchronization.
+     *
+     * Do not call this from a thread of the pool.
+     *
+     * @tparam TFactory Function object returning a handler.
+     * @tparam TMerge Function object merging two handlers.
+     * @param reader The reader to get the data from.
+     * @param factory Called once per pool thread to create the handlers.
+     * @param merge Called to merge a handler into the result.
+     * @param pool The thread pool to use.
+     * @returns The merged handler.
+     * @throws Any exception thrown by the reader or the handlers.
+     */
+    template <typename TFactory, typename TMerge>
+    typename std::decay<decltype(std::declval<TFactory&>()())>::type
+    parallel_apply(osmium::io::Reader& reader, TFactory&& factory, TMerge&& merge,
+                   osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+        using handler_type = typename std::decay<decltype(std::declval<TFactory&>()())>::type;
+
+        detail::parallel_apply_state<handler_type> state{factory, static_cast<std::size_t>(pool.num_threads())};
+
+        try {
+            while (auto buffer = reader.read()) {
+                if (state.failed()) {
+                    break;
+                }
+                state.task_added();
+                try {
+                    pool.execute(detail::parallel_apply_task<handler_type>{state, reader, std::move(buffer)});
+                } catch (...) {
+                    state.task_not_added();
+                    throw;
+                }
+            }
+        } catch (...) {
+            state.wait_for_all_tasks();
+            throw;
+        }
+
+        state.wait_for_all_tasks();
+        state.rethrow_exception();
+
+        auto& handlers = state.handlers();
+        for (auto& handler : handlers) {
+            osmium::apply_flush(handler);
+        }
+        for (std::size_t i = 1; i < handlers.size(); ++i) {
+            merge(handlers[0], handlers[i]);
+        }
+
+        return std::move(handlers[0]);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_PARALLEL_APPLY_HPP
@@ -0,0 +1,335 @@
+#ifndef OSMIUM_THREAD_ORDERED_RESULT_QUEUE_HPP
+#define OSMIUM_THREAD_ORDERED_RESULT_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/thread/stats.hpp>
+#include <osmium/thread/trace.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A bounded queue of results which are produced out of order (for
+         * instance by tasks running in a thread pool) but consumed in the
+         * order in which their slots were reserved.
+         *
+         * There must be only one producer thread that reserves slots and
+         * one consumer thread that pops results. Any thread can fill a
+         * reserved slot with a value or an exception. Popping blocks until
+         * the next slot in order is filled, reserving blocks while all
+         * slots are in use.
+         *
+         * This does the same job as a queue of std::futures, but it needs
+         * no allocation and no mutex per element. The mutex is only used
+         * when a thread has to wait.
+         *
+         * All reserved slots must be filled before the queue is destroyed.
+         */
+        template <typename T>
+        class OrderedResultQueue {
+
+            struct slot {
+                std::atomic<bool> ready{false};
+                T value{};
+                std::exception_ptr exception{};
+            };
+
+            /// Maximum number of slots in use.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            std::unique_ptr<slot[]> m_slots;
+
+            /// Sequence number of the next slot to pop.
+            std::atomic<std::size_t> m_head{0};
+
+            /// Sequence number of the next slot to reserve.
+            std::atomic<std::size_t> m_tail{0};
+
+            std::mutex m_mutex;
+
+            /// Used to signal the consumer when a result is ready.
+            std::condition_variable m_result_ready;
+
+            /// Used to signal the producer when a slot is free.
+            std::condition_variable m_space_available;
+
+            std::atomic<bool> m_consumer_waiting{false};
+            std::atomic<bool> m_producer_waiting{false};
+
+            /// Number of threads currently in mark_ready().
+            std::atomic<int> m_completing{0};
+
+            // Statistics. The counters are only written by the producer
+            // or the consumer, they are atomic so that stats() can be
+            // called from any thread.
+            std::atomic<std::size_t> m_high_water_mark{0};
+            std::atomic<uint64_t> m_full_count{0};
+            std::atomic<uint64_t> m_empty_count{0};
+            detail::time_counter m_producer_wait;
+            detail::time_counter m_consumer_wait;
+
+            slot& get_slot(std::size_t sequence) noexcept {
+                return m_slots[sequence % m_max_size];
+            }
+
+            void mark_ready(slot& s) {
+                // The consumer might pop the result and destroy the queue
+                // as soon as the ready flag is set, so the destructor has
+                // to wait until we are done here.
+                ++m_completing;
+                s.ready = true;
+
+                // Sequentially consistent operations on the ready flag and
+                // m_consumer_waiting here and in pop() make sure we either
+                // see the waiting consumer or the consumer sees the result.
+                if (m_consumer_waiting) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_result_ready.notify_one();
+                }
+                --m_completing;
+            }
+
+            void wait_for_completing_threads() const noexcept {
+                while (m_completing > 0) {
+                    std::this_thread::yield();
+                }
+            }
+
+        public:
+
+            /**
+             * Construct a queue.
+             *
+             * @param max_size Maximum number of slots in use at the same
+             *                 time. Must be at least 1.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit OrderedResultQueue(std::size_t max_size, std::string name = "") :
+                m_max_size(max_size > 0 ? max_size : 1),
+                m_name(std::move(name)),
+                m_slots(new slot[m_max_size]) {
+            }
+
+            OrderedResultQueue(const OrderedResultQueue&) = delete;
+            OrderedResultQueue& operator=(const OrderedResultQueue&) = delete;
+
+            OrderedResultQueue(OrderedResultQueue&&) = delete;
+            OrderedResultQueue& operator=(OrderedResultQueue&&) = delete;
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            ~OrderedResultQueue() {
+                wait_for_completing_threads();
+                const auto s = stats();
+                std::cerr << "queue '" << m_name
+                          << "' with max_size=" << m_max_size
+                          << " had largest size " << s.high_water_mark
+                          << " and was full " << s.full_count
+                          << " times in " << s.push_count
+                          << " push() calls and was empty " << s.empty_count
+                          << " times in " << s.pop_count
+                          << " pop() calls\n";
+            }
+#else
+            ~OrderedResultQueue() {
+                wait_for_completing_threads();
+            }
+#endif
+
+            /**
+             * Reserve the next slot. This call will block if all slots are
+             * in use. Must only be called by the producer.
+             *
+             * @returns Sequence number of the slot. Use it to call
+             *          set_value() or set_exception() exactly once.
+             */
+            std::size_t reserve() {
+                const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                if (tail - m_head.load(std::memory_order_acquire) >= m_max_size) {
+                    m_full_count.fetch_add(1, std::memory_order_relaxed);
+                    OSMIUM_TRACE_SCOPE_DETAIL("queue_wait_push", m_name);
+                    const auto start = detail::stats_clock::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_producer_waiting = true;
+                    m_space_available.wait(lock, [this, tail] {
+                        return tail - m_head.load() < m_max_size;
+                    });
+                    m_producer_waiting = false;
+                    m_producer_wait.add_since(start);
+                }
+
+                m_tail = tail + 1;
+
+                const std::size_t size = tail + 1 - m_head.load(std::memory_order_relaxed);
+                if (size > m_high_water_mark.load(std::memory_order_relaxed)) {
+                    m_high_water_mark.store(size, std::memory_order_relaxed);
+                }
+
+                return tail;
+            }
+
+            /**
+             * Fill the reserved slot with the given sequence number with
+             * a value. Can be called from any thread.
+             */
+            void set_value(std::size_t sequence, T&& value) {
+                auto& s = get_slot(sequence);
+                s.value = std::move(value);
+                mark_ready(s);
+            }
+
+            /**
+             * Fill the reserved slot with the given sequence number with
+             * an exception that will be re-thrown in pop(). Can be called
+             * from any thread.
+             */
+            void set_exception(std::size_t sequence, std::exception_ptr exception) {
+                auto& s = get_slot(sequence);
+                s.exception = std::move(exception);
+                mark_ready(s);
+            }
+
+            /**
+             * Reserve the next slot and fill it with the value. Must only
+             * be called by the producer.
+             */
+            void push(T&& value) {
+                set_value(reserve(), std::move(value));
+            }
+
+            /**
+             * Reserve the next slot and fill it with the exception. Must
+             * only be called by the producer.
+             */
+            void push_exception(std::exception_ptr exception) {
+                set_exception(reserve(), std::move(exception));
+            }
+
+            /**
+             * Wait until the next result in order is ready and return it.
+             * Must only be called by the consumer.
+             *
+             * @throws Any exception stored in the slot.
+             */
+            T pop() {
+                const std::size_t head = m_head.load(std::memory_order_relaxed);
+                auto& s = get_slot(head);
+                if (!s.ready.load(std::memory_order_acquire)) {
+                    m_empty_count.fetch_add(1, std::memory_order_relaxed);
+                    OSMIUM_TRACE_SCOPE_DETAIL("queue_wait_pop", m_name);
+                    const auto start = detail::stats_clock::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_consumer_waiting = true;
+                    m_result_ready.wait(lock, [&s] {
+                        return s.ready.load();
+                    });
+                    m_consumer_waiting = false;
+                    m_consumer_wait.add_since(start);
+                }
+
+                T value{std::move(s.value)};
+                const std::exception_ptr exception{std::move(s.exception)};
+                s.value = T{};
+                s.exception = nullptr;
+                s.ready = false;
+                m_head = head + 1;
+
+                // See comment in mark_ready().
+                if (m_producer_waiting) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_space_available.notify_one();
+                }
+
+                if (exception) {
+                    std::rethrow_exception(exception);
+                }
+
+                return value;
+            }
+
+            /**
+             * The number of reserved slots. This is only a snapshot if
+             * other threads are accessing the queue.
+             */
+            std::size_t size() const noexcept {
+                const std::size_t head = m_head.load();
+                return m_tail.load() - head;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            /**
+             * Get statistics about this queue. Can be called from any
+             * thread at any time, the numbers are only a snapshot then.
+             */
+            queue_stats stats() const noexcept {
+                queue_stats result;
+                result.max_size = m_max_size;
+                result.push_count = m_tail.load();
+                result.pop_count = m_head.load();
+                result.size = result.push_count > result.pop_count ? result.push_count - result.pop_count : 0;
+                result.high_water_mark = m_high_water_mark.load(std::memory_order_relaxed);
+                result.full_count = m_full_count.load(std::memory_order_relaxed);
+                result.empty_count = m_empty_count.load(std::memory_order_relaxed);
+                result.producer_wait = m_producer_wait.get();
+                result.consumer_wait = m_consumer_wait.get();
+                return result;
+            }
+
+        }; // class OrderedResultQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_ORDERED_RESULT_QUEUE_HPP
@@ -34,12 +34,19 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/stats.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/thread/work_stealing_deque.hpp>
 #include <osmium/util/config.hpp>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -55,9 +62,11 @@ namespace osmium {
         namespace detail {
 
             // Maximum number of allowed pool threads (just to keep the user
-            // from setting something silly).
+            // from setting something silly). There is no shared work queue
+            // all threads contend on, so this can be larger than the number
+            // of cores of most current machines.
             enum {
-                max_pool_threads = 32
+                max_pool_threads = 256
             };
 
             inline int get_pool_size(int num_threads, int user_setting, unsigned hardware_concurrency) {
@@ -85,7 +94,22 @@ namespace osmium {
         } // namespace detail
 
         /**
-         *  Thread pool.
+         * Thread pool.
+         *
+         * Every worker thread has its own queues: A lock-free deque for
+         * tasks submitted from inside this worker (see WorkStealingDeque)
+         * and an "inbox" for tasks submitted from other threads. Tasks
+         * from outside the pool are distributed round-robin onto the
+         * inboxes, so each mutex is only shared between the submitting
+         * thread and one worker most of the time. A worker that runs out
+         * of work steals tasks from the other workers starting at a random
+         * victim. Idle workers sleep on a condition variable.
+         *
+         * Only tasks submitted from inside the pool use the lock-free
+         * deques. The Reader and Writer submit all their tasks from their
+         * own threads, so they always go through the (mutex-protected)
+         * inboxes. They still benefit from the inboxes being per worker
+         * instead of one queue shared by all threads.
          */
         class Pool {
 
@@ -119,19 +143,151 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            struct worker_queues {
+
+                // Tasks submitted by this worker itself.
+                WorkStealingDeque<function_wrapper> local;
+
+                // Tasks submitted from outside the pool.
+                std::mutex inbox_mutex;
+                std::deque<function_wrapper> inbox;
+
+                // Statistics, only written by the worker owning these
+                // queues.
+                std::atomic<uint64_t> tasks_run{0};
+                std::atomic<uint64_t> tasks_stolen{0};
+                detail::time_counter busy;
+                detail::time_counter idle;
+
+                bool pop_inbox(function_wrapper& task) {
+                    std::lock_guard<std::mutex> lock{inbox_mutex};
+                    if (inbox.empty()) {
+                        return false;
+                    }
+                    task = std::move(inbox.front());
+                    inbox.pop_front();
+                    return true;
+                }
+
+            }; // struct worker_queues
+
+            // Identifies the pool and worker the current thread belongs to.
+            struct worker_id {
+                const Pool* pool = nullptr;
+                std::size_t index = 0;
+            };
+
+            static worker_id& this_worker() noexcept {
+                static thread_local worker_id id;
+                return id;
+            }
+
+            const std::size_t m_max_queue_size;
+
+            std::vector<std::unique_ptr<worker_queues>> m_queues;
+
+            // Number of tasks in all queues together.
+            std::atomic<std::size_t> m_pending{0};
+
+            // Used to distribute tasks from outside the pool.
+            std::atomic<std::size_t> m_next_queue{0};
+
+            std::mutex m_mutex;
+
+            // Used to signal sleeping workers when tasks are available.
+            std::condition_variable m_work_available;
+
+            // Used to signal producers when the queues are not full.
+            std::condition_variable m_space_available;
+
+            std::atomic<uint64_t> m_submit_blocked_count{0};
+
+            std::atomic<int> m_sleeping{0};
+            std::atomic<int> m_waiting_for_space{0};
+            std::atomic<bool> m_done{false};
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
             int m_num_threads;
 
-            void worker_thread() {
+            bool find_task(std::size_t index, uint32_t& random, function_wrapper& task) {
+                auto& own = *m_queues[index];
+                if (auto local_task = own.local.pop()) {
+                    task = std::move(*local_task);
+                    return true;
+                }
+                if (own.pop_inbox(task)) {
+                    return true;
+                }
+
+                // xorshift random number generator to select the victim
+                random ^= random << 13U;
+                random ^= random >> 17U;
+                random ^= random << 5U;
+
+                const std::size_t size = m_queues.size();
+                const std::size_t start = random % size;
+                for (std::size_t i = 0; i < size; ++i) {
+                    auto& victim = *m_queues[(start + i) % size];
+                    if (&victim == &own) {
+                        continue;
+                    }
+                    if (auto stolen_task = victim.local.steal()) {
+                        task = std::move(*stolen_task);
+                        own.tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                    if (victim.pop_inbox(task)) {
+                        own.tasks_stolen.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void task_taken() {
+                --m_pending;
+                if (m_waiting_for_space > 0) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_space_available.notify_all();
+                }
+            }
+
+            void task_added() {
+                if (m_sleeping > 0) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_work_available.notify_one();
+                }
+            }
+
+            void worker_thread(std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                this_worker().pool = this;
+                this_worker().index = index;
+
+                auto& own = *m_queues[index];
+                auto random = static_cast<uint32_t>(index * 2654435761U + 1U);
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
-                        // The called tasks returns true only when the
-                        // worker thread should shut down.
+                    if (find_task(index, random, task)) {
+                        task_taken();
+                        const auto start = detail::stats_clock::now();
+                        task();
+                        own.busy.add_since(start);
+                        own.tasks_run.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    const auto start = detail::stats_clock::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    ++m_sleeping;
+                    m_work_available.wait(lock, [this] {
+                        return m_pending > 0 || m_done;
+                    });
+                    --m_sleeping;
+                    own.idle.add_since(start);
+                    if (m_pending == 0 && m_done) {
                         return;
                     }
                 }
@@ -163,13 +319,17 @@ namespace osmium {
              * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
              */
             explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
+                m_max_queue_size(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
                 m_joiner(m_threads),
                 m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
 
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_queues.emplace_back(new worker_queues{});
+                }
+
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, static_cast<std::size_t>(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -188,11 +348,14 @@ namespace osmium {
                 return pool;
             }
 
+            /**
+             * Tell all workers to shut down after all tasks already
+             * submitted are done.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
-                }
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_done = true;
+                m_work_available.notify_all();
             }
 
             Pool(const Pool&) = delete;
@@ -210,24 +373,93 @@ namespace osmium {
             }
 
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_pending;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_pending == 0;
+            }
+
+            /**
+             * Get statistics about this pool. Can be called from any
+             * thread at any time, the numbers are only a snapshot then.
+             * Busy time is only counted when a task finishes.
+             */
+            pool_stats stats() const noexcept {
+                pool_stats result;
+                result.num_threads = m_num_threads;
+                result.queue_size = m_pending;
+                result.submit_blocked_count = m_submit_blocked_count.load(std::memory_order_relaxed);
+                for (const auto& queues : m_queues) {
+                    result.tasks_run += queues->tasks_run.load(std::memory_order_relaxed);
+                    result.tasks_stolen += queues->tasks_stolen.load(std::memory_order_relaxed);
+                    result.busy += queues->busy.get();
+                    result.idle += queues->idle.get();
+                }
+                return result;
             }
 
+            /**
+             * Submit a task to the pool.
+             *
+             * If called from outside the pool and the queues are full (see
+             * max_queue_size in the constructor), this will block until
+             * there is space. Tasks submitted from a worker thread of this
+             * pool go to the queue of that worker and never block.
+             *
+             * @returns Future with the result of the task.
+             */
             template <typename TFunction>
             std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func) {
                 using result_type = typename std::result_of<TFunction()>::type;
 
                 std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
                 std::future<result_type> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                enqueue(std::move(task));
 
                 return future_result;
             }
 
+            /**
+             * Run a function on the pool without getting a future for the
+             * result. This saves the allocation and synchronization of the
+             * future, the function has to deliver its result (and any
+             * exceptions) itself. Blocks like submit() if the queues are
+             * full.
+             */
+            template <typename TFunction>
+            void execute(TFunction&& func) {
+                using function_type = typename std::decay<TFunction>::type;
+                enqueue(function_wrapper{function_type{std::forward<TFunction>(func)}});
+            }
+
+        private:
+
+            void enqueue(function_wrapper&& task) {
+                // The task is counted before it is added to a queue, so
+                // m_pending is never smaller than the real number of tasks.
+                const auto& worker = this_worker();
+                if (worker.pool == this) {
+                    ++m_pending;
+                    m_queues[worker.index]->local.push(std::unique_ptr<function_wrapper>{new function_wrapper{std::move(task)}});
+                } else {
+                    if (m_pending >= m_max_queue_size) {
+                        m_submit_blocked_count.fetch_add(1, std::memory_order_relaxed);
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        ++m_waiting_for_space;
+                        m_space_available.wait(lock, [this] {
+                            return m_pending < m_max_queue_size;
+                        });
+                        --m_waiting_for_space;
+                    }
+                    ++m_pending;
+                    auto& queues = *m_queues[m_next_queue++ % m_queues.size()];
+                    std::lock_guard<std::mutex> lock{queues.inbox_mutex};
+                    queues.inbox.push_back(std::move(task));
+                }
+                task_added();
+            }
+
         }; // class Pool
 
     } // namespace thread
@@ -33,7 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
-#include <chrono>
+#include <osmium/thread/trace.hpp>
+
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
@@ -145,28 +146,26 @@ namespace osmium {
              * this call will block if the queue is full.
              */
             void push(T value) {
-                constexpr const std::chrono::milliseconds max_wait{10};
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 ++m_push_counter;
 #endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
-                        std::unique_lock<std::mutex> lock{m_mutex};
-                        m_space_available.wait_for(lock, max_wait, [this] {
-                            return m_queue.size() < m_max_size;
-                        });
+                std::unique_lock<std::mutex> lock{m_mutex};
+                if (m_max_size && m_queue.size() >= m_max_size) {
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
+                    ++m_full_counter;
 #endif
-                    }
+                    OSMIUM_TRACE_SCOPE_DETAIL("queue_wait_push", m_name);
+                    m_space_available.wait(lock, [this] {
+                        return m_queue.size() < m_max_size;
+                    });
                 }
-                std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_largest_size < m_queue.size()) {
                     m_largest_size = m_queue.size();
                 }
 #endif
+                lock.unlock();
                 m_data_available.notify_one();
             }
 
@@ -175,14 +174,15 @@ namespace osmium {
                 ++m_pop_counter;
 #endif
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                     ++m_empty_counter;
-                }
 #endif
-                m_data_available.wait(lock, [this] {
-                    return !m_queue.empty();
-                });
+                    OSMIUM_TRACE_SCOPE_DETAIL("queue_wait_pop", m_name);
+                    m_data_available.wait(lock, [this] {
+                        return !m_queue.empty();
+                    });
+                }
                 if (!m_queue.empty()) {
                     value = std::move(m_queue.front());
                     m_queue.pop();
@@ -0,0 +1,146 @@
+#ifndef OSMIUM_THREAD_STATS_HPP
+#define OSMIUM_THREAD_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Runtime statistics of a queue between two threads. All counts
+         * are since the queue was created.
+         */
+        struct queue_stats {
+
+            /// Maximum number of elements in the queue.
+            std::size_t max_size = 0;
+
+            /// Current number of elements in the queue.
+            std::size_t size = 0;
+
+            /// Largest number of elements the queue ever had.
+            std::size_t high_water_mark = 0;
+
+            /// Number of elements pushed.
+            uint64_t push_count = 0;
+
+            /// Number of elements popped.
+            uint64_t pop_count = 0;
+
+            /// Number of times the producer had to wait because the queue
+            /// was full.
+            uint64_t full_count = 0;
+
+            /// Number of times the consumer had to wait because the queue
+            /// was empty (or the next result wasn't ready).
+            uint64_t empty_count = 0;
+
+            /// Total time the producer waited for space in the queue.
+            std::chrono::nanoseconds producer_wait{0};
+
+            /// Total time the consumer waited for data in the queue.
+            std::chrono::nanoseconds consumer_wait{0};
+
+        }; // struct queue_stats
+
+        /**
+         * Runtime statistics of a thread pool. All counts are since the
+         * pool was created.
+         */
+        struct pool_stats {
+
+            /// Number of worker threads.
+            int num_threads = 0;
+
+            /// Number of tasks currently waiting to be run.
+            std::size_t queue_size = 0;
+
+            /// Number of tasks run by the workers.
+            uint64_t tasks_run = 0;
+
+            /// Number of tasks a worker stole from another worker.
+            uint64_t tasks_stolen = 0;
+
+            /// Number of times a thread outside the pool had to wait
+            /// because the queues were full.
+            uint64_t submit_blocked_count = 0;
+
+            /// Time spent by all workers together running tasks.
+            std::chrono::nanoseconds busy{0};
+
+            /// Time spent by all workers together waiting for tasks.
+            std::chrono::nanoseconds idle{0};
+
+        }; // struct pool_stats
+
+        namespace detail {
+
+            using stats_clock = std::chrono::steady_clock;
+
+            /**
+             * A time counter that can be updated from several threads.
+             */
+            class time_counter {
+
+                std::atomic<int64_t> m_nanoseconds{0};
+
+            public:
+
+                /// Add the time elapsed since start.
+                void add_since(stats_clock::time_point start) noexcept {
+                    add(stats_clock::now() - start);
+                }
+
+                void add(stats_clock::duration duration) noexcept {
+                    m_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+                                            std::memory_order_relaxed);
+                }
+
+                std::chrono::nanoseconds get() const noexcept {
+                    return std::chrono::nanoseconds{m_nanoseconds.load(std::memory_order_relaxed)};
+                }
+
+            }; // class time_counter
+
+        } // namespace detail
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_STATS_HPP
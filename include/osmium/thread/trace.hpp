@@ -0,0 +1,327 @@
+#ifndef OSMIUM_THREAD_TRACE_HPP
+#define OSMIUM_THREAD_TRACE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * Tracing of the stages of the reading and writing pipelines.
+ *
+ * Compile with OSMIUM_WITH_TRACE defined (for the whole program) to enable
+ * the trace points in Osmium. Then call
+ * osmium::thread::Tracer::instance().start() to start recording and
+ * write() to write the events in the Chrome trace event format which can
+ * be viewed in chrome://tracing or https://ui.perfetto.dev/. Without
+ * OSMIUM_WITH_TRACE the trace points compile to nothing.
+ */
+
+#ifdef OSMIUM_WITH_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Records begin/end events from all threads. There is only one
+         * tracer, use instance() to get it.
+         *
+         * Every thread records into its own list of events, so threads
+         * don't have to wait for each other.
+         */
+        class Tracer {
+
+        public:
+
+            using clock = std::chrono::steady_clock;
+
+        private:
+
+            struct event {
+                const char* name;
+                std::string detail;
+                clock::time_point begin;
+                clock::time_point end;
+            };
+
+            struct thread_data {
+                std::mutex mutex;
+                std::vector<event> events;
+                std::string name;
+                std::size_t id = 0;
+            };
+
+            std::atomic<bool> m_enabled{false};
+
+            mutable std::mutex m_mutex;
+            clock::time_point m_start{clock::now()};
+            std::vector<std::unique_ptr<thread_data>> m_threads;
+
+            Tracer() = default;
+
+            thread_data& this_thread_data() {
+                static thread_local thread_data* data = nullptr;
+                if (!data) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_threads.emplace_back(new thread_data{});
+                    data = m_threads.back().get();
+                    data->id = m_threads.size();
+                }
+                return *data;
+            }
+
+            static void write_escaped(std::ostream& out, const std::string& str) {
+                for (const char c : str) {
+                    if (c == '"' || c == '\\') {
+                        out << '\\' << c;
+                    } else if (static_cast<unsigned char>(c) >= 0x20U) {
+                        out << c;
+                    }
+                }
+            }
+
+            // Chrome trace timestamps are in microseconds.
+            double microseconds(clock::time_point time) const {
+                return std::chrono::duration<double, std::micro>(time - m_start).count();
+            }
+
+        public:
+
+            Tracer(const Tracer&) = delete;
+            Tracer& operator=(const Tracer&) = delete;
+
+            Tracer(Tracer&&) = delete;
+            Tracer& operator=(Tracer&&) = delete;
+
+            ~Tracer() noexcept = default;
+
+            static Tracer& instance() {
+                static Tracer tracer;
+                return tracer;
+            }
+
+            /// Start recording events.
+            void start() noexcept {
+                m_enabled.store(true, std::memory_order_relaxed);
+            }
+
+            /// Stop recording events. Events recorded so far are kept.
+            void stop() noexcept {
+                m_enabled.store(false, std::memory_order_relaxed);
+            }
+
+            bool enabled() const noexcept {
+                return m_enabled.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * Set the name of the current thread as shown in the trace.
+             * This is called from osmium::thread::set_thread_name().
+             */
+            void set_thread_name(const char* name) {
+                auto& data = this_thread_data();
+                std::lock_guard<std::mutex> lock{data.mutex};
+                data.name = name;
+            }
+
+            /**
+             * Add an event for the current thread. Usually you'll use the
+             * trace_scope class or the OSMIUM_TRACE_SCOPE macro instead.
+             *
+             * @param name Name of the event. Must be a string literal or
+             *             otherwise outlive the tracer.
+             * @param begin Start time of the event.
+             * @param end End time of the event.
+             * @param detail Optional detail shown in the event arguments.
+             */
+            void add(const char* name, clock::time_point begin, clock::time_point end, std::string detail = std::string{}) {
+                auto& data = this_thread_data();
+                std::lock_guard<std::mutex> lock{data.mutex};
+                data.events.push_back(event{name, std::move(detail), begin, end});
+            }
+
+            /// The number of events recorded.
+            std::size_t size() const {
+                std::size_t count = 0;
+                std::lock_guard<std::mutex> lock{m_mutex};
+                for (const auto& data : m_threads) {
+                    std::lock_guard<std::mutex> data_lock{data->mutex};
+                    count += data->events.size();
+                }
+                return count;
+            }
+
+            /**
+             * Remove all recorded events. The time in the trace is counted
+             * from the last call to this function (or from the creation of
+             * the tracer).
+             */
+            void clear() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_start = clock::now();
+                for (const auto& data : m_threads) {
+                    std::lock_guard<std::mutex> data_lock{data->mutex};
+                    data->events.clear();
+                }
+            }
+
+            /**
+             * Write all recorded events as JSON in the Chrome trace event
+             * format. This can be called while tracing is running, but
+             * events not finished yet will be missing.
+             */
+            void write(std::ostream& out) const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+                const char* sep = "\n";
+                for (const auto& data : m_threads) {
+                    std::lock_guard<std::mutex> data_lock{data->mutex};
+                    if (!data->name.empty()) {
+                        out << sep << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << data->id
+                            << R"(,"args":{"name":")";
+                        write_escaped(out, data->name);
+                        out << "\"}}";
+                        sep = ",\n";
+                    }
+                    for (const auto& e : data->events) {
+                        out << sep << R"({"name":")" << e.name
+                            << R"(","cat":"osmium","ph":"X","pid":1,"tid":)" << data->id
+                            << ",\"ts\":" << microseconds(e.begin)
+                            << ",\"dur\":" << std::chrono::duration<double, std::micro>(e.end - e.begin).count();
+                        if (!e.detail.empty()) {
+                            out << R"(,"args":{"detail":")";
+                            write_escaped(out, e.detail);
+                            out << "\"}";
+                        }
+                        out << '}';
+                        sep = ",\n";
+                    }
+                }
+                out << "\n]}\n";
+            }
+
+        }; // class Tracer
+
+        /**
+         * Records an event from construction to destruction of this object
+         * if the tracer was enabled at construction time.
+         */
+        class trace_scope {
+
+            const char* m_name;
+            std::string m_detail{};
+            Tracer::clock::time_point m_begin{};
+            bool m_active;
+
+        public:
+
+            explicit trace_scope(const char* name) :
+                m_name(name),
+                m_active(Tracer::instance().enabled()) {
+                if (m_active) {
+                    m_begin = Tracer::clock::now();
+                }
+            }
+
+            trace_scope(const char* name, const std::string& detail) :
+                m_name(name),
+                m_active(Tracer::instance().enabled()) {
+                if (m_active) {
+                    m_detail = detail;
+                    m_begin = Tracer::clock::now();
+                }
+            }
+
+            trace_scope(const trace_scope&) = delete;
+            trace_scope& operator=(const trace_scope&) = delete;
+
+            trace_scope(trace_scope&&) = delete;
+            trace_scope& operator=(trace_scope&&) = delete;
+
+            ~trace_scope() noexcept {
+                if (m_active) {
+                    try {
+                        Tracer::instance().add(m_name, m_begin, Tracer::clock::now(), std::move(m_detail));
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+            }
+
+        }; // class trace_scope
+
+        /**
+         * Set the name of the current thread as shown in the trace. Any
+         * exceptions are ignored, tracing is only for debugging.
+         */
+        inline void trace_thread_name(const char* name) noexcept {
+            try {
+                Tracer::instance().set_thread_name(name);
+            } catch (...) {
+                // ignore
+            }
+        }
+
+    } // namespace thread
+
+} // namespace osmium
+
+#define OSMIUM_TRACE_CONCAT_IMPL(a, b) a##b
+#define OSMIUM_TRACE_CONCAT(a, b) OSMIUM_TRACE_CONCAT_IMPL(a, b)
+
+/// Record an event with the given name until the end of the current scope.
+#define OSMIUM_TRACE_SCOPE(name) const osmium::thread::trace_scope OSMIUM_TRACE_CONCAT(osmium_trace_scope_, __LINE__){name}
+/// Record an event with the given name and detail until the end of the current scope.
+#define OSMIUM_TRACE_SCOPE_DETAIL(name, detail) const osmium::thread::trace_scope OSMIUM_TRACE_CONCAT(osmium_trace_scope_, __LINE__){name, detail}
+/// Set the name of the current thread in the trace.
+#define OSMIUM_TRACE_THREAD_NAME(name) osmium::thread::trace_thread_name(name)
+
+#else
+
+#define OSMIUM_TRACE_SCOPE(name)
+#define OSMIUM_TRACE_SCOPE_DETAIL(name, detail)
+#define OSMIUM_TRACE_THREAD_NAME(name) static_cast<void>(name)
+
+#endif // OSMIUM_WITH_TRACE
+
+#endif // OSMIUM_THREAD_TRACE_HPP
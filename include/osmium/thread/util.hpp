@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/thread/trace.hpp>
+
 #include <chrono>
 #include <future>
 #include <thread>
@@ -71,16 +73,15 @@ namespace osmium {
 
         /**
          * Set name of current thread for debugging. This only works on Linux.
+         * If compiled with OSMIUM_WITH_TRACE, the name is also used in the
+         * trace (see osmium/thread/trace.hpp).
          */
-#ifdef __linux__
         inline void set_thread_name(const char* name) noexcept {
+#ifdef __linux__
             prctl(PR_SET_NAME, name, 0, 0, 0);
-        }
-#else
-        inline void set_thread_name(const char*) noexcept {
-            // intentionally left blank
-        }
 #endif
+            OSMIUM_TRACE_THREAD_NAME(name);
+        }
 
         class thread_handler {
 
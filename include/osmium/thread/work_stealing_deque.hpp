@@ -0,0 +1,220 @@
+#ifndef OSMIUM_THREAD_WORK_STEALING_DEQUE_HPP
+#define OSMIUM_THREAD_WORK_STEALING_DEQUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Lock-free work-stealing deque after Chase and Lev ("Dynamic
+         * Circular Work-Stealing Deque", 2005) in the formulation of Lê
+         * et al. ("Correct and Efficient Work-Stealing for Weak Memory
+         * Models", 2013). It stores pointers to objects of type T and
+         * takes ownership of them.
+         *
+         * Only one thread (the owner) may call push() and pop(), they
+         * work on the bottom end of the deque. Any thread may call steal()
+         * which takes elements from the top end.
+         *
+         * All atomic operations use the default sequentially consistent
+         * memory order. The tasks we schedule are large, so the cost of
+         * that is negligible.
+         */
+        template <typename T>
+        class WorkStealingDeque {
+
+            class circular_array {
+
+                std::size_t m_mask;
+                std::unique_ptr<std::atomic<T*>[]> m_data;
+
+            public:
+
+                explicit circular_array(std::size_t size) :
+                    m_mask(size - 1),
+                    m_data(new std::atomic<T*>[size]) {
+                }
+
+                std::size_t size() const noexcept {
+                    return m_mask + 1;
+                }
+
+                T* get(int64_t index) const noexcept {
+                    return m_data[static_cast<std::size_t>(index) & m_mask].load();
+                }
+
+                void put(int64_t index, T* value) noexcept {
+                    m_data[static_cast<std::size_t>(index) & m_mask].store(value);
+                }
+
+            }; // class circular_array
+
+            std::atomic<int64_t> m_top{0};
+            std::atomic<int64_t> m_bottom{0};
+            std::atomic<circular_array*> m_array;
+
+            // All arrays ever used. Old arrays can not be released while
+            // the deque is in use, because a thief might still read from
+            // them. Arrays only grow, so this wastes at most as much
+            // memory as the current array needs.
+            std::vector<std::unique_ptr<circular_array>> m_arrays;
+
+            circular_array* grow(circular_array* array, int64_t top, int64_t bottom) {
+                std::unique_ptr<circular_array> new_array{new circular_array{array->size() * 2}};
+                for (int64_t i = top; i < bottom; ++i) {
+                    new_array->put(i, array->get(i));
+                }
+                m_arrays.push_back(std::move(new_array));
+                m_array.store(m_arrays.back().get());
+                return m_arrays.back().get();
+            }
+
+        public:
+
+            /**
+             * Construct a deque.
+             *
+             * @param initial_size Initial capacity, must be a power of two.
+             *                     The deque grows as needed.
+             */
+            explicit WorkStealingDeque(std::size_t initial_size = 64) {
+                m_arrays.emplace_back(new circular_array{initial_size});
+                m_array.store(m_arrays.back().get());
+            }
+
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+            WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+            WorkStealingDeque(WorkStealingDeque&&) = delete;
+            WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+            ~WorkStealingDeque() noexcept {
+                while (!empty()) {
+                    pop();
+                }
+            }
+
+            /**
+             * Push an element on the bottom of the deque. Must only be
+             * called by the owner.
+             */
+            void push(std::unique_ptr<T>&& value) {
+                const int64_t bottom = m_bottom.load();
+                const int64_t top = m_top.load();
+                circular_array* array = m_array.load();
+                if (bottom - top > static_cast<int64_t>(array->size()) - 1) {
+                    array = grow(array, top, bottom);
+                }
+                array->put(bottom, value.release());
+                m_bottom.store(bottom + 1);
+            }
+
+            /**
+             * Pop an element from the bottom of the deque. Must only be
+             * called by the owner.
+             *
+             * @returns The element or nullptr if the deque is empty.
+             */
+            std::unique_ptr<T> pop() {
+                const int64_t bottom = m_bottom.load() - 1;
+                circular_array* array = m_array.load();
+                m_bottom.store(bottom);
+                int64_t top = m_top.load();
+
+                if (top > bottom) { // deque was empty
+                    m_bottom.store(bottom + 1);
+                    return nullptr;
+                }
+
+                T* value = array->get(bottom);
+                if (top == bottom) { // last element, race against thieves
+                    if (!m_top.compare_exchange_strong(top, top + 1)) {
+                        value = nullptr;
+                    }
+                    m_bottom.store(bottom + 1);
+                }
+
+                return std::unique_ptr<T>{value};
+            }
+
+            /**
+             * Steal an element from the top of the deque. Can be called
+             * from any thread.
+             *
+             * @returns The element or nullptr if the deque is empty or
+             *          another thread was faster.
+             */
+            std::unique_ptr<T> steal() {
+                int64_t top = m_top.load();
+                const int64_t bottom = m_bottom.load();
+
+                if (top >= bottom) {
+                    return nullptr;
+                }
+
+                T* value = m_array.load()->get(top);
+                if (!m_top.compare_exchange_strong(top, top + 1)) {
+                    return nullptr;
+                }
+
+                return std::unique_ptr<T>{value};
+            }
+
+            /**
+             * The number of elements in the deque. This is only a snapshot
+             * if other threads are accessing the deque.
+             */
+            std::size_t size() const noexcept {
+                const int64_t bottom = m_bottom.load();
+                const int64_t top = m_top.load();
+                return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+        }; // class WorkStealingDeque
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_WORK_STEALING_DEQUE_HPP
@@ -55,6 +55,33 @@ namespace osmium {
         }
 #endif
 
+        /**
+         * Get a boolean setting from the environment variable with the
+         * specified name. The values "on", "true", "yes", and "1" mean
+         * true, "off", "false", "no", and "0" mean false (all case
+         * insensitive). If the variable isn't set or has any other value,
+         * the default value is returned.
+         */
+        inline bool get_bool_env(const char* name, bool default_value) noexcept {
+            assert(name);
+            const char* env = getenv_wrapper(name);
+            if (env) {
+                if (!strcasecmp(env, "off") ||
+                    !strcasecmp(env, "false") ||
+                    !strcasecmp(env, "no") ||
+                    !strcasecmp(env, "0")) {
+                    return false;
+                }
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return default_value;
+        }
+
     } // namespace detail
 
     namespace config {
@@ -68,16 +95,76 @@ namespace osmium {
         }
 
         inline bool use_pool_threads_for_pbf_parsing() noexcept {
-            const char* env = osmium::detail::getenv_wrapper("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING");
-            if (env) {
-                if (!strcasecmp(env, "off") ||
-                    !strcasecmp(env, "false") ||
-                    !strcasecmp(env, "no") ||
-                    !strcasecmp(env, "0")) {
-                    return false;
-                }
-            }
-            return true;
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING", true);
+        }
+
+        /**
+         * Should OPL files be parsed using the threads in the pool? Can be
+         * switched off with the environment variable
+         * OSMIUM_USE_POOL_THREADS_FOR_OPL_PARSING.
+         */
+        inline bool use_pool_threads_for_opl_parsing() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_OPL_PARSING", true);
+        }
+
+        /**
+         * Should uncompressed PBF files be memory-mapped for reading? If
+         * this is set, the PBF parser reads the data directly from the
+         * mapping instead of through the read thread. Can be switched
+         * off with the environment variable OSMIUM_USE_MMAP_FOR_PBF_INPUT.
+         */
+        inline bool use_mmap_for_pbf_input() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_MMAP_FOR_PBF_INPUT", true);
+        }
+
+        /**
+         * Should bzip2-compressed files be decompressed using the threads
+         * in the pool? Can be switched off with the environment variable
+         * OSMIUM_USE_POOL_THREADS_FOR_BZIP2.
+         */
+        inline bool use_pool_threads_for_bzip2() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_BZIP2", true);
+        }
+
+        /**
+         * Should gzip-compressed files be decompressed using the threads
+         * in the pool? Can be switched off with the environment variable
+         * OSMIUM_USE_POOL_THREADS_FOR_GZIP.
+         */
+        inline bool use_pool_threads_for_gzip() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_GZIP", true);
+        }
+
+        /**
+         * Should gzip-compressed files be written using the threads in the
+         * pool? The output consists of many independent gzip members and
+         * is a bit larger than with the GzipCompressor. Switched off by
+         * default, set the environment variable
+         * OSMIUM_USE_POOL_THREADS_FOR_GZIP_COMPRESSION to switch this on.
+         */
+        inline bool use_pool_threads_for_gzip_compression() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_GZIP_COMPRESSION", false);
+        }
+
+        /**
+         * Should OSM XML files be parsed with the built-in OSM XML
+         * tokenizer instead of Expat? Documents the tokenizer can not
+         * handle are always handed to Expat. Expat is used by default,
+         * set the environment variable OSMIUM_USE_FAST_XML_PARSER to
+         * switch this on.
+         */
+        inline bool use_fast_xml_parser() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_FAST_XML_PARSER", false);
+        }
+
+        /**
+         * Should OSM XML files be parsed using the threads in the pool?
+         * This is only done with the built-in OSM XML tokenizer (see
+         * use_fast_xml_parser()). Can be switched off with the environment
+         * variable OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING.
+         */
+        inline bool use_pool_threads_for_xml_parsing() noexcept {
+            return osmium::detail::get_bool_env("OSMIUM_USE_POOL_THREADS_FOR_XML_PARSING", true);
         }
 
         inline std::size_t get_max_queue_size(const char* queue_name, const std::size_t default_value) noexcept {
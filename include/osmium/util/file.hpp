@@ -222,6 +222,26 @@ namespace osmium {
             return static_cast<std::size_t>(offset);
         }
 
+        /**
+         * Set offset into file.
+         * Small wrapper around lseek(2) system call.
+         *
+         * @param fd Open file descriptor.
+         * @param offset New offset from the beginning of the file.
+         * @throws std::system_error If lseek(2) call failed
+         */
+        inline void file_seek(int fd, std::size_t offset) {
+#ifdef _MSC_VER
+            osmium::detail::disable_invalid_parameter_handler diph;
+            assert(offset <= static_cast<std::size_t>(std::numeric_limits<__int64>::max()));
+            if (_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) == -1) {
+#else
+            if (::lseek(fd, static_cast<off_t>(offset), SEEK_SET) == -1) {
+#endif
+                throw std::system_error{errno, std::system_category(), "Could not seek in file"};
+            }
+        }
+
         /**
          * Check whether the file descriptor refers to a TTY.
          *
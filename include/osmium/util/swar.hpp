@@ -0,0 +1,100 @@
+#ifndef OSMIUM_UTIL_SWAR_HPP
+#define OSMIUM_UTIL_SWAR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2021 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstdint>
+#include <cstring>
+
+namespace osmium {
+
+    namespace detail {
+
+        // Functions for scanning strings eight bytes at a time using bit
+        // operations on 64 bit words ("SIMD within a register"). This is
+        // portable and fast if most words don't contain the bytes looked
+        // for.
+        constexpr const uint64_t swar_ones = 0x0101010101010101ULL;
+        constexpr const uint64_t swar_highs = 0x8080808080808080ULL;
+
+        inline uint64_t swar_load(const char* p) noexcept {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            return word;
+        }
+
+        // Does the word contain a byte smaller than n (n <= 128)?
+        inline bool swar_has_less(const uint64_t word, const uint64_t n) noexcept {
+            return ((word - swar_ones * n) & ~word & swar_highs) != 0;
+        }
+
+        // Does the word contain the byte c?
+        inline bool swar_has_byte(const uint64_t word, const uint64_t c) noexcept {
+            const uint64_t x = word ^ (swar_ones * c);
+            return ((x - swar_ones) & ~x & swar_highs) != 0;
+        }
+
+        // Does the word contain a byte with the high bit set?
+        inline bool swar_has_non_ascii(const uint64_t word) noexcept {
+            return (word & swar_highs) != 0;
+        }
+
+        // Find the first byte in [p, e) for which byte_matches() is true.
+        // Words of eight bytes for which word_may_match() is false are
+        // skipped without looking at the individual bytes.
+        template <typename TWordPredicate, typename TBytePredicate>
+        inline const char* find_first_byte(const char* p, const char* const e, TWordPredicate word_may_match, TBytePredicate byte_matches) {
+            while (e - p >= 8) {
+                if (word_may_match(swar_load(p))) {
+                    for (const char* const word_end = p + 8; p != word_end; ++p) {
+                        if (byte_matches(static_cast<unsigned char>(*p))) {
+                            return p;
+                        }
+                    }
+                } else {
+                    p += 8;
+                }
+            }
+            for (; p != e; ++p) {
+                if (byte_matches(static_cast<unsigned char>(*p))) {
+                    return p;
+                }
+            }
+            return e;
+        }
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_SWAR_HPP
@@ -40,6 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm.hpp>
 #include <osmium/osm/entity.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/thread/trace.hpp>
 
 #include <type_traits>
 #include <utility>
@@ -313,6 +314,7 @@ namespace osmium {
 
     template <typename TIterator, typename... THandlers>
     inline void apply_impl(TIterator it, TIterator end, THandlers&&... handlers) {
+        OSMIUM_TRACE_SCOPE("apply");
         for (; it != end; ++it) {
             apply_item(*it, std::forward<THandlers>(handlers)...);
         }
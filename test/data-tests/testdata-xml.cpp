@@ -78,8 +78,8 @@ static std::string read_gz_file(const char* test_id, const char* suffix) {
 // cppcheck-suppress passedByValue
 static header_buffer_type parse_xml(std::string input) {
     osmium::thread::Pool pool;
-    osmium::io::detail::future_string_queue_type input_queue;
-    osmium::io::detail::future_buffer_queue_type output_queue;
+    osmium::io::detail::string_queue_type input_queue{2};
+    osmium::io::detail::buffer_queue_type output_queue{20};
     std::promise<osmium::io::Header> header_promise;
     std::future<osmium::io::Header> header_future = header_promise.get_future();
 
@@ -92,21 +92,22 @@ static header_buffer_type parse_xml(std::string input) {
         output_queue,
         header_promise,
         osmium::osm_entity_bits::all,
-        osmium::io::read_meta::yes
+        osmium::io::read_meta::yes,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
 
     header_buffer_type result;
     result.header = header_future.get();
-    std::future<osmium::memory::Buffer> future_buffer;
-    output_queue.wait_and_pop(future_buffer);
-    result.buffer = future_buffer.get();
+    result.buffer = output_queue.pop();
 
     if (result.buffer) {
-        std::future<osmium::memory::Buffer> future_buffer2;
-        output_queue.wait_and_pop(future_buffer2);
-        assert(!future_buffer2.get());
+        assert(!output_queue.pop());
     }
 
     return result;
@@ -0,0 +1,59 @@
+#ifndef OSMIUM_TEST_FILES_HPP
+#define OSMIUM_TEST_FILES_HPP
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <string>
+#include <utility>
+
+// Helpers for tests that need an OSM file written by the Writer. The
+// output format (and compression) for the file must be included by the
+// test.
+
+// Write the objects in the buffer to a file, overwriting any existing
+// file. The format is given as for osmium::io::File, use "" to get it
+// from the file name suffix.
+inline osmium::io::writer_stats write_test_buffer(osmium::memory::Buffer&& buffer,
+                                                  const std::string& filename,
+                                                  const char* format = "",
+                                                  const osmium::io::Header& header = osmium::io::Header{}) {
+    osmium::io::Writer writer{osmium::io::File{filename, format}, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+    return writer.stats();
+}
+
+// Write num_nodes nodes, num_ways ways, and num_relations relations with
+// ids from 1 and version 1 to a file. All nodes are at (1, 1), ways have
+// the nodes 1, 2, and 3, relations have way 1 as member. In PBF files
+// there are 8000 nodes per blob.
+inline osmium::io::writer_stats write_test_file(const std::string& filename,
+                                                const char* format,
+                                                const osmium::object_id_type num_nodes,
+                                                const osmium::object_id_type num_ways = 0,
+                                                const osmium::object_id_type num_relations = 0,
+                                                const osmium::io::Header& header = osmium::io::Header{}) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= num_nodes; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 1.0));
+    }
+    for (osmium::object_id_type id = 1; id <= num_ways; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({1, 2, 3}));
+    }
+    for (osmium::object_id_type id = 1; id <= num_relations; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _version(1), _member(osmium::item_type::way, 1, ""));
+    }
+
+    return write_test_buffer(std::move(buffer), filename, format, header);
+}
+
+#endif // OSMIUM_TEST_FILES_HPP
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+
+#include <osmium/handler.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/parallel_apply.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct CountHandler : public osmium::handler::Handler {
+
+    uint64_t nodes = 0;
+    uint64_t way_nodes = 0;
+    int64_t id_sum = 0;
+    int flushed = 0;
+
+    void node(const osmium::Node& node) noexcept {
+        ++nodes;
+        id_sum += node.id();
+    }
+
+    void way(const osmium::Way& way) noexcept {
+        way_nodes += way.nodes().size();
+    }
+
+    void flush() noexcept {
+        ++flushed;
+    }
+
+}; // struct CountHandler
+
+struct CollectHandler : public osmium::handler::Handler {
+
+    std::vector<osmium::object_id_type> ids;
+
+    void node(const osmium::Node& node) {
+        ids.push_back(node.id());
+    }
+
+}; // struct CollectHandler
+
+struct ThrowingHandler : public osmium::handler::Handler {
+
+    void node(const osmium::Node& node) {
+        if (node.id() == 30000) {
+            throw std::runtime_error{"test"};
+        }
+    }
+
+}; // struct ThrowingHandler
+
+TEST_CASE("Parallel apply with counting handler") {
+    const std::string filename{"test-parallel-apply-counting.osm.pbf"};
+    write_test_file(filename, "", 50000, 1000);
+
+    osmium::thread::Pool pool{4};
+    osmium::io::Reader reader{filename, pool};
+
+    int handlers_created = 0;
+    const auto result = osmium::parallel_apply(reader, [&handlers_created]() {
+        ++handlers_created;
+        return CountHandler{};
+    }, [](CountHandler& a, const CountHandler& b) {
+        a.nodes += b.nodes;
+        a.way_nodes += b.way_nodes;
+        a.id_sum += b.id_sum;
+        a.flushed += b.flushed;
+    }, pool);
+
+    REQUIRE(handlers_created == 4);
+    REQUIRE(result.nodes == 50000);
+    REQUIRE(result.way_nodes == 3000);
+    REQUIRE(result.id_sum == 50000LL * 50001LL / 2);
+    REQUIRE(result.flushed == 4);
+    REQUIRE(reader.eof());
+}
+
+TEST_CASE("Parallel apply with collecting handler") {
+    const std::string filename{"test-parallel-apply-collecting.osm.pbf"};
+    write_test_file(filename, "", 50000, 1000);
+
+    osmium::io::Reader reader{filename};
+
+    auto result = osmium::parallel_apply(reader, []() {
+        return CollectHandler{};
+    }, [](CollectHandler& a, CollectHandler& b) {
+        a.ids.insert(a.ids.end(), b.ids.begin(), b.ids.end());
+    });
+
+    REQUIRE(result.ids.size() == 50000);
+    std::sort(result.ids.begin(), result.ids.end());
+    REQUIRE(result.ids.front() == 1);
+    REQUIRE(result.ids.back() == 50000);
+    REQUIRE(std::adjacent_find(result.ids.begin(), result.ids.end()) == result.ids.end());
+}
+
+TEST_CASE("Parallel apply with handler throwing exception") {
+    const std::string filename{"test-parallel-apply-throwing.osm.pbf"};
+    write_test_file(filename, "", 50000, 1000);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{filename, pool};
+
+    REQUIRE_THROWS_AS(osmium::parallel_apply(reader, []() {
+        return ThrowingHandler{};
+    }, [](ThrowingHandler& /*a*/, ThrowingHandler& /*b*/) {
+    }, pool), const std::runtime_error&);
+}
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/detail/buffer_pool.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+
+TEST_CASE("Get buffer from empty buffer pool") {
+    osmium::io::detail::BufferPool pool;
+    REQUIRE(pool.size() == 0);
+
+    auto buffer = pool.get(1024);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() == 1024);
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Buffers given back to buffer pool are re-used") {
+    osmium::io::detail::BufferPool pool;
+
+    osmium::memory::Buffer buffer{2048, osmium::memory::Buffer::auto_grow::no};
+    REQUIRE(buffer.reserve_space(64) != nullptr);
+    buffer.commit();
+    const auto* data = buffer.data();
+
+    pool.put(std::move(buffer));
+    REQUIRE(pool.size() == 1);
+
+    auto recycled = pool.get(1024);
+    REQUIRE(pool.size() == 0);
+    REQUIRE(recycled.data() == data);
+    REQUIRE(recycled.capacity() == 2048);
+    REQUIRE(recycled.committed() == 0);
+
+    // auto_grow::internal is set for recycled buffers
+    REQUIRE(recycled.reserve_space(2048) != nullptr);
+    recycled.commit();
+    REQUIRE(recycled.reserve_space(64) != nullptr);
+    REQUIRE(recycled.has_nested_buffers());
+}
+
+TEST_CASE("Buffer pool is bounded") {
+    osmium::io::detail::BufferPool pool{2};
+
+    for (int i = 0; i < 5; ++i) {
+        pool.put(osmium::memory::Buffer{1024});
+    }
+    REQUIRE(pool.size() == 2);
+}
+
+TEST_CASE("Buffer pool ignores buffers that can't be re-used") {
+    osmium::io::detail::BufferPool pool;
+
+    pool.put(osmium::memory::Buffer{});
+
+    std::array<unsigned char, 128> data = {{0}};
+    pool.put(osmium::memory::Buffer{data.data(), data.size()});
+
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Recycle buffers while reading PBF file") {
+    const std::string filename{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+
+    std::size_t count = 0;
+    {
+        osmium::io::Reader reader{filename};
+        while (const auto buffer = reader.read()) {
+            count += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+        }
+    }
+    REQUIRE(count > 0);
+
+    std::size_t count_recycled = 0;
+    osmium::io::Reader reader{filename};
+    while (auto buffer = reader.read()) {
+        count_recycled += static_cast<std::size_t>(std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend()));
+        reader.recycle(std::move(buffer));
+    }
+    REQUIRE(count == count_recycled);
+}
@@ -5,6 +5,9 @@
 #include <osmium/io/bzip2_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
 #include <string>
 
 TEST_CASE("Invalid file descriptor of bzip2-compressed file") {
@@ -134,3 +137,127 @@ TEST_CASE("Write bzip2-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string bzip2_compress(const std::string& data) {
+    std::string output;
+    output.resize(data.size() + data.size() / 100 + 600);
+    auto size = static_cast<unsigned int>(output.size());
+    REQUIRE(BZ2_bzBuffToBuffCompress(&output[0], &size, const_cast<char*>(data.data()), static_cast<unsigned int>(data.size()), 1, 0, 0) == BZ_OK);
+    output.resize(size);
+    return output;
+}
+
+// Create some test data and write it as multistream bzip2 file with one
+// stream per line.
+static std::string write_multistream_file(const std::string& filename, int num_lines) {
+    std::string data;
+    std::string compressed;
+    for (int i = 0; i < num_lines; ++i) {
+        std::string line{"line " + std::to_string(i) + " "};
+        line.append(static_cast<std::size_t>(i % 1000), 'x');
+        line += '\n';
+        data += line;
+        compressed += bzip2_compress(line);
+    }
+
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, compressed.data(), compressed.size());
+    osmium::io::detail::reliable_close(fd);
+
+    return data;
+}
+
+static std::string read_all(osmium::io::Decompressor& decomp) {
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    return all;
+}
+
+TEST_CASE("Find bzip2 stream starts") {
+    const std::string data{"xxBZh9\x31\x41\x59\x26\x53\x59yyBZh0\x31\x41\x59\x26\x53\x59zBZh1\x31\x41\x59\x26\x53\x59"};
+    REQUIRE(osmium::io::detail::find_bzip2_stream_start(data.data(), data.size(), 0) == 2);
+    REQUIRE(osmium::io::detail::find_bzip2_stream_start(data.data(), data.size(), 3) == 25);
+    REQUIRE(osmium::io::detail::find_bzip2_stream_start(data.data(), data.size(), 26) == std::string::npos);
+    REQUIRE(osmium::io::detail::find_bzip2_stream_start(data.data(), 34, 3) == std::string::npos);
+}
+
+TEST_CASE("Read bzip2-compressed file with parallel decompressor") {
+    const int count = count_fds();
+
+    const std::string input_file = with_data_dir("t/io/data_bzip2.txt.bz2");
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    {
+        osmium::io::Bzip2ParallelDecompressor decomp{fd};
+        all = read_all(decomp);
+    }
+
+    REQUIRE(all.size() >= 9);
+    all.resize(8);
+    REQUIRE("TESTDATA" == all);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read multistream bzip2-compressed file with parallel decompressor") {
+    const std::string filename{"test_bzip2_multistream.txt.bz2"};
+    const std::string data = write_multistream_file(filename, 5000);
+
+    osmium::thread::Pool pool{4};
+
+    SECTION("in parallel") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::Bzip2ParallelDecompressor decomp{fd, pool};
+        REQUIRE(read_all(decomp) == data);
+        REQUIRE(decomp.offset() == osmium::file_size(filename));
+    }
+
+    SECTION("falling back to sequential decompression") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::Bzip2ParallelDecompressor decomp{fd, pool, 100};
+        REQUIRE(read_all(decomp) == data);
+    }
+
+    SECTION("with normal decompressor") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::Bzip2Decompressor decomp{fd};
+        REQUIRE(read_all(decomp) == data);
+    }
+}
+
+TEST_CASE("Read empty and corrupted bzip2-compressed file with parallel decompressor") {
+    const int count = count_fds();
+
+    SECTION("empty") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/empty_file"));
+        osmium::io::Bzip2ParallelDecompressor decomp{fd};
+        REQUIRE_THROWS_AS(decomp.read(), const osmium::bzip2_error&);
+        decomp.close();
+    }
+
+    SECTION("corrupted") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/corrupt_data_bzip2.txt.bz2"));
+        osmium::io::Bzip2ParallelDecompressor decomp{fd};
+        REQUIRE_THROWS_AS(decomp.read(), const osmium::bzip2_error&);
+        decomp.close();
+    }
+
+    SECTION("truncated") {
+        const std::string filename{"test_bzip2_truncated.txt.bz2"};
+        const std::string compressed = bzip2_compress(std::string(100000, 'a'));
+        const int wfd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(wfd, compressed.data(), compressed.size() - 10);
+        osmium::io::detail::reliable_close(wfd);
+
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::Bzip2ParallelDecompressor decomp{fd};
+        REQUIRE_THROWS_AS(read_all(decomp), const osmium::bzip2_error&);
+    }
+
+    REQUIRE(count == count_fds());
+}
@@ -1,6 +1,10 @@
 #include "catch.hpp"
 
+#include "utils.hpp"
+
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
 
 TEST_CASE("Create compressor using factory") {
     const auto& factory = osmium::io::CompressionFactory::instance();
@@ -20,3 +24,32 @@ TEST_CASE("Compression factory fails on undefined compression") {
                         "Support for compression 'gzip' not compiled into this binary");
 }
 
+
+TEST_CASE("Compression factory hands pool to callbacks") {
+    auto& factory = osmium::io::CompressionFactory::instance();
+    osmium::thread::Pool pool{1};
+    osmium::thread::Pool* compressor_pool = nullptr;
+    osmium::thread::Pool* decompressor_pool = nullptr;
+
+    factory.register_compression(osmium::io::file_compression::bzip2,
+        [&](const int fd, const osmium::io::fsync sync, osmium::thread::Pool& p) {
+            compressor_pool = &p;
+            return new osmium::io::NoCompressor{fd, sync};
+        },
+        [&](const int fd, osmium::thread::Pool& p) {
+            decompressor_pool = &p;
+            return new osmium::io::NoDecompressor{fd};
+        },
+        [](const char* buffer, const std::size_t size) { return new osmium::io::NoDecompressor{buffer, size}; }
+    );
+
+    REQUIRE(factory.create_compressor(osmium::io::file_compression::bzip2, -1, osmium::io::fsync::no, pool));
+    REQUIRE(compressor_pool == &pool);
+
+    REQUIRE(factory.create_compressor(osmium::io::file_compression::bzip2, -1, osmium::io::fsync::no));
+    REQUIRE(compressor_pool == &osmium::thread::Pool::default_instance());
+
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.osm"));
+    REQUIRE(factory.create_decompressor(osmium::io::file_compression::bzip2, fd, pool));
+    REQUIRE(decompressor_pool == &pool);
+}
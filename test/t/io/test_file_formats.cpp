@@ -94,6 +94,14 @@ TEST_CASE("Detect file format by suffix 'opl.bz2'") {
     f.check();
 }
 
+TEST_CASE("Detect file format by suffix 'opl.zst'") {
+    const osmium::io::File f{"test.opl.zst"};
+    REQUIRE(osmium::io::file_format::opl == f.format());
+    REQUIRE(osmium::io::file_compression::zstd == f.compression());
+    REQUIRE_FALSE(f.has_multiple_object_versions());
+    f.check();
+}
+
 TEST_CASE("Detect file format by suffix 'osc.gz'") {
     const osmium::io::File f{"test.osc.gz"};
     REQUIRE(osmium::io::file_format::xml == f.format());
@@ -174,6 +182,14 @@ TEST_CASE("Override file format by suffix 'osm.opl.bz2'") {
     f.check();
 }
 
+TEST_CASE("Override file format by suffix 'osm.zst'") {
+    const osmium::io::File f{"test", "osm.zst"};
+    REQUIRE(osmium::io::file_format::xml == f.format());
+    REQUIRE(osmium::io::file_compression::zstd == f.compression());
+    REQUIRE_FALSE(f.has_multiple_object_versions());
+    f.check();
+}
+
 TEST_CASE("Override file format by suffix 'osc.gz'") {
     const osmium::io::File f{"test", "osc.gz"};
     REQUIRE(osmium::io::file_format::xml == f.format());
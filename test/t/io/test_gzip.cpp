@@ -4,7 +4,11 @@
 
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/gzip_compression.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
 
+#include <cstdint>
+#include <limits>
 #include <string>
 
 TEST_CASE("Invalid file descriptor of gzip-compressed file") {
@@ -135,3 +139,193 @@ TEST_CASE("Write gzip-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string test_data(int num_lines) {
+    std::string data;
+    for (int i = 0; i < num_lines; ++i) {
+        data += "line " + std::to_string(i) + " ";
+        data.append(static_cast<std::size_t>(i % 1000), 'x');
+        data += '\n';
+    }
+    return data;
+}
+
+static std::string read_all(osmium::io::Decompressor& decomp) {
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    return all;
+}
+
+static void write_parallel(const std::string& filename, const std::string& data, osmium::thread::Pool& pool, std::size_t block_size) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::GzipParallelCompressor comp{fd, osmium::io::fsync::no, pool, block_size};
+    for (std::size_t pos = 0; pos < data.size(); pos += 10000) {
+        comp.write(data.substr(pos, 10000));
+    }
+    comp.close();
+    REQUIRE(comp.file_size() == osmium::file_size(filename));
+}
+
+TEST_CASE("Write and read gzip-compressed file with parallel compressor and decompressor") {
+    const int count = count_fds();
+
+    const std::string filename{"test_gzip_parallel.txt.gz"};
+    const std::string data = test_data(5000);
+    osmium::thread::Pool pool{4};
+
+    write_parallel(filename, data, pool, 100000);
+    REQUIRE(osmium::file_size(filename) < data.size());
+
+    SECTION("parallel decompressor") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::GzipParallelDecompressor decomp{fd, pool};
+        REQUIRE(read_all(decomp) == data);
+        REQUIRE(decomp.offset() == osmium::file_size(filename));
+    }
+
+    SECTION("normal decompressor") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::GzipDecompressor decomp{fd};
+        REQUIRE(read_all(decomp) == data);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write empty gzip-compressed file with parallel compressor") {
+    const std::string filename{"test_gzip_parallel_empty.txt.gz"};
+    osmium::thread::Pool pool{2};
+    write_parallel(filename, "", pool, 100000);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    osmium::io::GzipDecompressor decomp{fd};
+    REQUIRE(read_all(decomp).empty());
+}
+
+TEST_CASE("Read normal gzip-compressed files with parallel decompressor") {
+    const int count = count_fds();
+
+    SECTION("single member") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data_gzip.txt.gz"));
+        osmium::io::GzipParallelDecompressor decomp{fd};
+        const std::string all = read_all(decomp);
+        REQUIRE(all.size() >= 9);
+        REQUIRE(all.substr(0, 8) == "TESTDATA");
+    }
+
+    SECTION("multiple members") {
+        const std::string filename{"test_gzip_multiple_members.txt.gz"};
+        const std::string data = test_data(3000);
+        {
+            // two members written by zlib followed by some members
+            // written by the parallel compressor
+            const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+            osmium::io::GzipCompressor comp1{osmium::io::detail::reliable_dup(fd), osmium::io::fsync::no};
+            comp1.write(data.substr(0, 1000000));
+            comp1.close();
+            osmium::io::GzipCompressor comp2{osmium::io::detail::reliable_dup(fd), osmium::io::fsync::no};
+            comp2.write(data.substr(1000000, 200000));
+            comp2.close();
+            osmium::thread::Pool pool{2};
+            osmium::io::GzipParallelCompressor comp3{fd, osmium::io::fsync::no, pool, 100000};
+            comp3.write(data.substr(1200000));
+            comp3.close();
+        }
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::GzipParallelDecompressor decomp{fd};
+        REQUIRE(read_all(decomp) == data);
+    }
+
+    SECTION("empty file") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/empty_file"));
+        osmium::io::GzipParallelDecompressor decomp{fd};
+        REQUIRE(read_all(decomp).empty());
+    }
+
+    SECTION("uncompressed file") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.txt"));
+        osmium::io::GzipParallelDecompressor decomp{fd};
+        REQUIRE(read_all(decomp).substr(0, 8) == "TESTDATA");
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read corrupted gzip-compressed files with parallel decompressor") {
+    const int count = count_fds();
+
+    SECTION("corrupted normal file") {
+        const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/corrupt_data_gzip.txt.gz"));
+        osmium::io::GzipParallelDecompressor decomp{fd};
+        REQUIRE_THROWS_AS(read_all(decomp), const osmium::gzip_error&);
+        decomp.close();
+    }
+
+    SECTION("corrupted file written by parallel compressor") {
+        const std::string filename{"test_gzip_parallel_corrupted.txt.gz"};
+        const std::string data = test_data(2000);
+        osmium::thread::Pool pool{2};
+        write_parallel(filename, data, pool, 100000);
+
+        std::string compressed(osmium::file_size(filename), '\0');
+        const int rfd = osmium::io::detail::open_for_reading(filename);
+        REQUIRE(osmium::io::detail::reliable_read(rfd, &compressed[0], static_cast<unsigned int>(compressed.size())) == static_cast<int64_t>(compressed.size()));
+        osmium::io::detail::reliable_close(rfd);
+
+        compressed[compressed.size() / 2] ^= 0x55;
+        const int wfd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(wfd, compressed.data(), compressed.size());
+        osmium::io::detail::reliable_close(wfd);
+
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::GzipParallelDecompressor decomp{fd, pool};
+        REQUIRE_THROWS_AS(read_all(decomp), const osmium::gzip_error&);
+        decomp.close();
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+using decompress_member = osmium::io::detail::decompress_unit<osmium::io::detail::gzip_stream_decoder>;
+
+TEST_CASE("Decompress gzip member with wrong uncompressed size in trailer") {
+    const std::string data = test_data(1000);
+    std::string member = osmium::io::detail::gzip_block_compressor{}(data);
+    REQUIRE(decompress_member{std::string{member}}() == data);
+
+    const auto set_size = [&member](uint32_t size) {
+        std::string trailer;
+        osmium::io::detail::append_uint32_le(trailer, size);
+        member.replace(member.size() - 4, 4, trailer);
+    };
+
+    SECTION("size too large") {
+        set_size(std::numeric_limits<uint32_t>::max());
+        REQUIRE_THROWS_AS(decompress_member{std::move(member)}(), const osmium::gzip_error&);
+    }
+
+    SECTION("size too small") {
+        set_size(static_cast<uint32_t>(data.size() - 1));
+        REQUIRE_THROWS_AS(decompress_member{std::move(member)}(), const osmium::gzip_error&);
+    }
+
+    SECTION("size zero") {
+        set_size(0);
+        REQUIRE_THROWS_AS(decompress_member{std::move(member)}(), const osmium::gzip_error&);
+    }
+}
+
+TEST_CASE("Decompress gzip member larger than output chunk") {
+    const std::string data = test_data(20000);
+    REQUIRE(data.size() > osmium::io::Decompressor::input_buffer_size);
+    const std::string member = osmium::io::detail::gzip_block_compressor{}(data);
+    REQUIRE(decompress_member{std::string{member}}() == data);
+}
+
+TEST_CASE("Decompress empty gzip member") {
+    const std::string member = osmium::io::detail::gzip_block_compressor{}(std::string{});
+    REQUIRE(decompress_member{std::string{member}}().empty());
+}
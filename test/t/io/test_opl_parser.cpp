@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <initializer_list>
 #include <string>
 #include <vector>
@@ -1277,3 +1278,108 @@ TEST_CASE("line_by_line for OPL parser 28") {
     check_lbl({"foo\nb", "ar"}, {"foo", "bar"});
 }
 
+
+class cbl_tester {
+
+    std::vector<std::string> m_inputs;
+
+public:
+
+    std::vector<std::string> chunks;
+
+    explicit cbl_tester(const std::initializer_list<std::string>& inputs) :
+        m_inputs(inputs) {
+    }
+
+    bool input_done() {
+        return m_inputs.empty();
+    }
+
+    std::string get_input() {
+        REQUIRE_FALSE(m_inputs.empty());
+        std::string data = std::move(m_inputs.front());
+        m_inputs.erase(m_inputs.begin());
+        return data;
+    }
+
+    void parse_chunk(std::string&& chunk) {
+        chunks.push_back(std::move(chunk));
+    }
+
+}; // class cbl_tester
+
+std::vector<std::string> check_cbl(const std::initializer_list<std::string>& in, std::size_t min_chunk_size) {
+    cbl_tester tester{in};
+    osmium::io::detail::chunk_by_lines(tester, min_chunk_size);
+    return tester.chunks;
+}
+
+TEST_CASE("chunk_by_lines for OPL parser") {
+    using vs = std::vector<std::string>;
+
+    REQUIRE(check_cbl({}, 1).empty());
+    REQUIRE(check_cbl({"foo\n"}, 1) == (vs{"foo\n"}));
+    REQUIRE(check_cbl({"foo\nbar"}, 1) == (vs{"foo\n", "bar"}));
+    REQUIRE(check_cbl({"foo\nb", "ar\n"}, 1) == (vs{"foo\n", "bar\n"}));
+    REQUIRE(check_cbl({"foo\nb", "ar\n"}, 100) == (vs{"foo\nbar\n"}));
+    REQUIRE(check_cbl({"fo", "o", "\nbar\r\n", "baz"}, 1) == (vs{"foo\nbar\r\n", "baz"}));
+    REQUIRE(check_cbl({"foo\r", "\nbar\n", "baz\n", "x"}, 5) == (vs{"foo\r\nbar\n", "baz\n", "x"}));
+}
+
+TEST_CASE("Count OPL lines") {
+    REQUIRE(oid::opl_count_lines("") == 0);
+    REQUIRE(oid::opl_count_lines("\n\r\n") == 0);
+    REQUIRE(oid::opl_count_lines("foo") == 1);
+    REQUIRE(oid::opl_count_lines("foo\n") == 1);
+    REQUIRE(oid::opl_count_lines("foo\r\nbar\r\n") == 2);
+    REQUIRE(oid::opl_count_lines("\nfoo\n\nbar") == 2);
+}
+
+TEST_CASE("Parse large OPL file in chunks using Reader") {
+    const std::string filename{"test_opl_parser_large.opl"};
+    const int num_nodes = 100000;
+
+    std::string data;
+    for (int id = 1; id <= num_nodes; ++id) {
+        data += "n" + std::to_string(id) + " v1 dV c1 t2020-01-01T00:00:00Z i1 ufoo Tamenity=bench x1.5 y2.5\n";
+        if (id % 1000 == 0) {
+            data += "\n";
+        }
+    }
+    REQUIRE(data.size() > 3 * osmium::io::detail::OPLParser::min_chunk_size);
+
+    SECTION("valid data") {
+        {
+            std::ofstream file{filename, std::ios::binary};
+            file << data;
+        }
+
+        osmium::io::Reader reader{filename};
+        osmium::object_id_type expected_id = 1;
+        while (const auto buffer = reader.read()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                REQUIRE(node.id() == expected_id);
+                ++expected_id;
+            }
+        }
+        reader.close();
+        REQUIRE(expected_id == num_nodes + 1);
+    }
+
+    SECTION("error in later chunk reports correct line") {
+        data += "foo\n";
+        {
+            std::ofstream file{filename, std::ios::binary};
+            file << data;
+        }
+
+        osmium::io::Reader reader{filename};
+        try {
+            while (reader.read()) {
+            }
+            REQUIRE(false);
+        } catch (const osmium::opl_error& e) {
+            REQUIRE(e.line == num_nodes);
+        }
+    }
+}
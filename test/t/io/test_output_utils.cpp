@@ -1,11 +1,16 @@
 #include "catch.hpp"
 
 #include <osmium/io/detail/string_util.hpp>
+#include <osmium/osm/location.hpp>
 
+#include <cstdint>
 #include <iterator>
+#include <limits>
 #include <locale>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 TEST_CASE("output formatted with small results") {
     std::string out;
@@ -210,3 +215,86 @@ TEST_CASE("incomplete Unicode codepoint") {
     }
 }
 
+
+TEST_CASE("Append integers") {
+    const std::vector<std::pair<int64_t, const char*>> values = {
+        {0, "0"},
+        {7, "7"},
+        {10, "10"},
+        {99, "99"},
+        {100, "100"},
+        {12345, "12345"},
+        {-1, "-1"},
+        {-100, "-100"},
+        {1234567890123, "1234567890123"},
+        {std::numeric_limits<int64_t>::max(), "9223372036854775807"},
+        {std::numeric_limits<int64_t>::min(), "-9223372036854775808"}
+    };
+
+    for (const auto& value : values) {
+        std::string out{"x"};
+        osmium::io::detail::append_int(out, value.first);
+        REQUIRE(out == std::string{"x"} + value.second);
+    }
+}
+
+TEST_CASE("Append location coordinates") {
+    const std::vector<int32_t> values = {
+        0, 1, 10, 100, 1000000, 9999999, 10000000, 12345678, 100000000,
+        1000000000, 1800000000, 1234500000, 900000001, 12340000,
+        -1, -10, -9999999, -10000000, -12345678, -1800000000, -900000001,
+        std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()
+    };
+
+    for (const auto value : values) {
+        std::string expected{"x"};
+        osmium::detail::append_location_coordinate_to_string(std::back_inserter(expected), value);
+        std::string out{"x"};
+        osmium::io::detail::append_location_coordinate(out, value);
+        REQUIRE(out == expected);
+    }
+
+    std::string out;
+    osmium::io::detail::append_location_coordinate(out, -12345678);
+    REQUIRE(out == "-1.2345678");
+}
+
+TEST_CASE("Encoding finds special characters at all positions in long strings") {
+    const std::string clean{"abcdefghijklmnopqrstuvwx"};
+
+    for (std::size_t pos = 0; pos <= clean.size(); ++pos) {
+        const std::string prefix{clean.substr(0, pos)};
+        const std::string suffix{clean.substr(pos)};
+
+        std::string out;
+        osmium::io::detail::append_xml_encoded_string(out, (prefix + "<" + suffix).c_str());
+        REQUIRE(out == prefix + "&lt;" + suffix);
+
+        out.clear();
+        osmium::io::detail::append_xml_encoded_string(out, (prefix + "\t" + suffix + "\r\n").c_str());
+        REQUIRE(out == prefix + "&#x9;" + suffix + "&#xD;&#xA;");
+
+        out.clear();
+        osmium::io::detail::append_xml_encoded_string(out, (prefix + "\x01\xc3\xa4" + suffix).c_str());
+        REQUIRE(out == prefix + "\x01\xc3\xa4" + suffix);
+
+        out.clear();
+        osmium::io::detail::append_utf8_encoded_string(out, (prefix + "," + suffix).c_str());
+        REQUIRE(out == prefix + "%2c%" + suffix);
+
+        out.clear();
+        osmium::io::detail::append_utf8_encoded_string(out, (prefix + "\xc3\xa4 \xe2\x80\x8b" + suffix).c_str());
+        REQUIRE(out == prefix + "\xc3\xa4%20%%200b%" + suffix);
+
+        out.clear();
+        osmium::io::detail::append_debug_encoded_string(out, (prefix + "\"" + suffix).c_str(), "[", "]");
+        REQUIRE(out == prefix + "[<U+0022>]" + suffix);
+
+        out.clear();
+        osmium::io::detail::append_debug_encoded_string(out, (prefix + "\xc3\xa4\x7f" + suffix).c_str(), "[", "]");
+        REQUIRE(out == prefix + "\xc3\xa4[<U+007F>]" + suffix);
+
+        out.clear();
+        REQUIRE_THROWS_AS(osmium::io::detail::append_utf8_encoded_string(out, (prefix + "\xff" + suffix).c_str()), const std::runtime_error&);
+    }
+}
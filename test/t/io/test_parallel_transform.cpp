@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+
+#include <osmium/io/parallel_transform.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& filename) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+TEST_CASE("Parallel transform keeps order of buffers") {
+    const std::string filename{"test-parallel-transform-order.osm.pbf"};
+    write_test_file(filename, "", 50000);
+
+    osmium::thread::Pool pool{4};
+    osmium::io::Reader reader{filename, pool};
+
+    SECTION("changing buffers in place") {
+        std::vector<osmium::object_id_type> ids;
+        osmium::io::parallel_transform(reader, [](osmium::memory::Buffer& buffer) {
+            for (auto& node : buffer.select<osmium::Node>()) {
+                node.set_id(node.id() * 2);
+            }
+            return std::move(buffer);
+        }, [&ids](osmium::memory::Buffer&& buffer) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                ids.push_back(node.id());
+            }
+        }, pool);
+
+        std::vector<osmium::object_id_type> expected;
+        for (osmium::object_id_type id = 1; id <= 50000; ++id) {
+            expected.push_back(id * 2);
+        }
+        REQUIRE(ids == expected);
+    }
+
+    SECTION("filtering into new buffers and writing them") {
+        const std::string outfile{"test-parallel-transform-out.osm.pbf"};
+        osmium::io::Writer writer{outfile, osmium::io::overwrite::allow};
+
+        osmium::io::parallel_transform(reader, [](const osmium::memory::Buffer& buffer) {
+            osmium::memory::Buffer output{buffer.committed(), osmium::memory::Buffer::auto_grow::yes};
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (node.id() % 3 == 0) {
+                    output.add_item(node);
+                    output.commit();
+                }
+            }
+            return output;
+        }, writer, pool);
+        writer.close();
+
+        std::vector<osmium::object_id_type> expected;
+        for (osmium::object_id_type id = 3; id <= 50000; id += 3) {
+            expected.push_back(id);
+        }
+        REQUIRE(read_ids(outfile) == expected);
+    }
+
+    SECTION("function returning invalid buffers") {
+        int count = 0;
+        osmium::io::parallel_transform(reader, [](const osmium::memory::Buffer& /*buffer*/) {
+            return osmium::memory::Buffer{};
+        }, [&count](osmium::memory::Buffer&& /*buffer*/) {
+            ++count;
+        }, pool);
+        REQUIRE(count == 0);
+    }
+}
+
+TEST_CASE("Parallel transform with exceptions") {
+    const std::string filename{"test-parallel-transform-exceptions.osm.pbf"};
+    write_test_file(filename, "", 50000);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Reader reader{filename, pool};
+
+    SECTION("in function") {
+        REQUIRE_THROWS_AS(osmium::io::parallel_transform(reader, [](osmium::memory::Buffer& buffer) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (node.id() == 30000) {
+                    throw std::runtime_error{"function"};
+                }
+            }
+            return std::move(buffer);
+        }, [](osmium::memory::Buffer&& /*buffer*/) {
+        }, pool), const std::runtime_error&);
+    }
+
+    SECTION("in sink") {
+        REQUIRE_THROWS_AS(osmium::io::parallel_transform(reader, [](osmium::memory::Buffer& buffer) {
+            return std::move(buffer);
+        }, [](osmium::memory::Buffer&& /*buffer*/) {
+            throw std::runtime_error{"sink"};
+        }, pool), const std::runtime_error&);
+    }
+}
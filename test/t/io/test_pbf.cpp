@@ -2,9 +2,29 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/pbf_index_data.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE("Get supported PBF compression types") {
     const auto types = osmium::io::supported_pbf_compression_types();
@@ -13,6 +33,14 @@ TEST_CASE("Get supported PBF compression types") {
     REQUIRE(types[1] == "zlib");
 }
 
+TEST_CASE("Get PBF compression type from string") {
+    REQUIRE(osmium::io::detail::get_compression_type("") == osmium::io::detail::pbf_compression::zlib);
+    REQUIRE(osmium::io::detail::get_compression_type("none") == osmium::io::detail::pbf_compression::none);
+    REQUIRE(osmium::io::detail::get_compression_type("lz4") == osmium::io::detail::pbf_compression::lz4);
+    REQUIRE(osmium::io::detail::get_compression_type("zstd") == osmium::io::detail::pbf_compression::zstd);
+    REQUIRE_THROWS_AS(osmium::io::detail::get_compression_type("foo"), const std::invalid_argument&);
+}
+
 /**
  * Osmosis writes PBF with changeset=-1 if its input file did not contain the changeset field.
  * The default value of the version field is -1 in the OSM.PBF format.
@@ -50,3 +78,326 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+TEST_CASE("Read PBF file directly from memory") {
+    const std::string filename{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+
+    std::vector<osmium::object_id_type> ids_from_file;
+    {
+        const int count = count_fds();
+        osmium::io::Reader reader{filename};
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                ids_from_file.push_back(object.id());
+            }
+        }
+        REQUIRE(reader.file_size() > 0);
+        REQUIRE(reader.offset() == reader.file_size());
+        reader.close();
+        REQUIRE(count == count_fds());
+    }
+    REQUIRE_FALSE(ids_from_file.empty());
+
+    std::string data;
+    {
+        std::ifstream input{filename, std::ios::binary};
+        data.assign(std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{});
+    }
+    REQUIRE_FALSE(data.empty());
+
+    std::vector<osmium::object_id_type> ids_from_buffer;
+    {
+        osmium::io::File file{data.data(), data.size(), "pbf"};
+        osmium::io::Reader reader{file};
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                ids_from_buffer.push_back(object.id());
+            }
+        }
+        REQUIRE(reader.offset() == data.size());
+    }
+
+    REQUIRE(ids_from_file == ids_from_buffer);
+}
+
+TEST_CASE("Read truncated PBF file from memory") {
+    std::string data;
+    {
+        std::ifstream input{with_data_dir("t/io/deleted_nodes.osh.pbf"), std::ios::binary};
+        data.assign(std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{});
+    }
+    data.resize(data.size() - 10);
+
+    osmium::io::File file{data.data(), data.size(), "pbf"};
+    osmium::io::Reader reader{file};
+    REQUIRE_THROWS_AS(reader.read(), const osmium::pbf_error&);
+}
+
+TEST_CASE("Close PBF reader reading from memory-mapped file before EOF") {
+    const int count = count_fds();
+    {
+        osmium::io::Reader reader{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+        REQUIRE(reader.header().has_multiple_object_versions());
+        reader.close();
+        REQUIRE(reader.eof());
+    }
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Decode packed delta encoded sint64 field") {
+    const std::vector<int64_t> values = {
+        0, 1, -1, 63, -64, 64, 1000000, -1000000,
+        std::numeric_limits<int32_t>::max(),
+        std::numeric_limits<int64_t>::max() / 2,
+        std::numeric_limits<int64_t>::min() / 2
+    };
+
+    std::vector<int64_t> deltas;
+    int64_t last = 0;
+    for (const auto value : values) {
+        deltas.push_back(value - last);
+        last = value;
+    }
+
+    std::string data;
+    {
+        protozero::pbf_writer writer{data};
+        writer.add_packed_sint64(1, deltas.cbegin(), deltas.cend());
+    }
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next());
+    const auto view = reader.get_view();
+
+    std::vector<int64_t> decoded(100, 42);
+    osmium::io::detail::decode_packed_sint64_delta(view, decoded);
+    REQUIRE(decoded == values);
+
+    osmium::io::detail::decode_packed_sint64_delta(protozero::data_view{}, decoded);
+    REQUIRE(decoded.empty());
+}
+
+TEST_CASE("Decoding packed sint64 delta field with truncated varint throws") {
+    const std::string data{"\x02\x04\x80"};
+    std::vector<int64_t> decoded;
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_packed_sint64_delta(protozero::data_view{data.data(), data.size()}, decoded), const osmium::pbf_error&);
+}
+
+TEST_CASE("Read DenseNodes with long user names growing the buffer") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const std::string filename{"test-pbf-dense-long-user.osm.pbf"};
+    const osmium::object_id_type num_nodes = 8000;
+
+    // The same few user names for all nodes make the decoded objects much
+    // larger than the PBF data, so the buffer has to grow while decoding.
+    const auto user_name = [](osmium::object_id_type id) {
+        return std::string(250, static_cast<char>('a' + id % 3));
+    };
+
+    {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= num_nodes; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _uid(id), _user(user_name(id)),
+                                      _location(osmium::Location{static_cast<int32_t>(id * 1000), static_cast<int32_t>(id * 2000)}));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    osmium::object_id_type expected_id = 1;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == expected_id);
+            REQUIRE(node.user() == user_name(expected_id));
+            REQUIRE(node.location() == osmium::Location(static_cast<int32_t>(expected_id * 1000), static_cast<int32_t>(expected_id * 2000)));
+            ++expected_id;
+        }
+    }
+    reader.close();
+    REQUIRE(expected_id == num_nodes + 1);
+}
+
+TEST_CASE("Encode and decode PBF blob index data") {
+    osmium::io::detail::pbf_blob_index_data index_data;
+    REQUIRE_FALSE(index_data.valid());
+
+    index_data.add(osmium::osm_entity_bits::way, 17);
+    index_data.add(osmium::osm_entity_bits::way, -3);
+    index_data.add(osmium::osm_entity_bits::way, 42);
+    REQUIRE(index_data.valid());
+
+    const std::string data{osmium::io::detail::encode_blob_index_data(index_data)};
+    const auto decoded = osmium::io::detail::decode_blob_index_data(data);
+    REQUIRE(decoded.valid());
+    REQUIRE(decoded.types == osmium::osm_entity_bits::way);
+    REQUIRE(decoded.min_id == -3);
+    REQUIRE(decoded.max_id == 42);
+
+    SECTION("Index data in unknown format is ignored") {
+        REQUIRE_FALSE(osmium::io::detail::decode_blob_index_data(std::string{"\x0a\x03foo\x10\x02"}).valid());
+        REQUIRE_FALSE(osmium::io::detail::decode_blob_index_data(std::string{"\xff\xff\xff"}).valid());
+        REQUIRE_FALSE(osmium::io::detail::decode_blob_index_data(std::string{}).valid());
+    }
+}
+
+static void write_pbf_with_all_types(const std::string& filename, const char* options) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(2), _location(2.0, 2.0));
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2}));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 10, ""));
+
+    osmium::io::File file{filename, options};
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static std::string read_file_contents(const std::string& filename) {
+    std::ifstream input{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+}
+
+static void check_read_entity_types(const char* options, bool expect_index_data) {
+    const std::string filename{"test-pbf-index-data.osm.pbf"};
+    write_pbf_with_all_types(filename, options);
+
+    const bool has_index_data = read_file_contents(filename).find(osmium::io::detail::pbf_blob_index_data_format) != std::string::npos;
+    REQUIRE(has_index_data == expect_index_data);
+
+    const auto read_ids = [&filename](osmium::osm_entity_bits::type types) {
+        std::vector<osmium::object_id_type> ids;
+        osmium::io::Reader reader{filename, types};
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                ids.push_back(object.id());
+            }
+        }
+        reader.close();
+        return ids;
+    };
+
+    REQUIRE(read_ids(osmium::osm_entity_bits::all) == (std::vector<osmium::object_id_type>{1, 2, 10, 20}));
+    REQUIRE(read_ids(osmium::osm_entity_bits::node) == (std::vector<osmium::object_id_type>{1, 2}));
+    REQUIRE(read_ids(osmium::osm_entity_bits::way) == (std::vector<osmium::object_id_type>{10}));
+    REQUIRE(read_ids(osmium::osm_entity_bits::relation) == (std::vector<osmium::object_id_type>{20}));
+    REQUIRE(read_ids(osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation) == (std::vector<osmium::object_id_type>{10, 20}));
+}
+
+TEST_CASE("Read only some entity types from PBF file") {
+    SECTION("with index data") {
+        check_read_entity_types("pbf,pbf_add_index_data=true", true);
+    }
+    SECTION("with index data and uncompressed blobs") {
+        check_read_entity_types("pbf,pbf_add_index_data=true,pbf_compression=none", true);
+    }
+    SECTION("without index data") {
+        check_read_entity_types("pbf", false);
+    }
+}
+
+TEST_CASE("Write PBF file from many small buffers") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const std::string filename{"test-pbf-many-buffers.osm.pbf"};
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        osmium::object_id_type id = 1;
+        for (int n = 0; n < 20; ++n) {
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int i = 0; i < 1000; ++i, ++id) {
+                osmium::builder::add_node(buffer, _id(id), _location(1.0, 1.0), _tag("n", std::to_string(id % 7).c_str()));
+            }
+            writer(std::move(buffer));
+        }
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(buffer, _id(1), _nodes({1, 2}), _tag("highway", "primary"));
+        osmium::builder::add_way(buffer, _id(2), _nodes({2, 3}));
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    // Blocks are filled across buffer boundaries.
+    const osmium::io::PBFBlobIndex index{filename};
+    std::vector<osmium::io::PBFBlobIndex::entry> entries{index.begin(), index.end()};
+    REQUIRE(entries.size() == 4);
+    REQUIRE(entries[0].min_id == 1);
+    REQUIRE(entries[0].max_id == 8000);
+    REQUIRE(entries[1].min_id == 8001);
+    REQUIRE(entries[1].max_id == 16000);
+    REQUIRE(entries[2].min_id == 16001);
+    REQUIRE(entries[2].max_id == 20000);
+    REQUIRE(entries[3].types == osmium::osm_entity_bits::way);
+
+    // Order of the objects is preserved.
+    osmium::io::Reader reader{filename};
+    osmium::object_id_type expected_id = 1;
+    std::size_t ways = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == expected_id);
+            REQUIRE(std::string{node.tags()["n"]} == std::to_string(expected_id % 7));
+            ++expected_id;
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            ++ways;
+            REQUIRE(way.id() == static_cast<osmium::object_id_type>(ways));
+        }
+    }
+    reader.close();
+    REQUIRE(expected_id == 20001);
+    REQUIRE(ways == 2);
+}
+
+#ifdef OSMIUM_WITH_ZSTD
+TEST_CASE("Write and read PBF file with zstd compressed blobs") {
+    const auto types = osmium::io::supported_pbf_compression_types();
+    REQUIRE(types.back() == "zstd");
+
+    const std::string filename{"test-pbf-zstd.osm.pbf"};
+    write_pbf_with_all_types(filename, "pbf,pbf_compression=zstd,pbf_compression_level=1");
+
+    osmium::io::Reader reader{filename};
+    std::vector<osmium::object_id_type> ids;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+        }
+    }
+    reader.close();
+    REQUIRE(ids == (std::vector<osmium::object_id_type>{1, 2, 10, 20}));
+}
+
+TEST_CASE("Uncompress zstd PBF blob data") {
+    const std::string data{"some data some data some data"};
+    const std::string compressed = osmium::io::detail::zstd_compress(data);
+
+    std::string output;
+    const auto view = osmium::io::detail::zstd_uncompress_string(compressed.data(), compressed.size(), data.size(), output);
+    REQUIRE(std::string(view.data(), view.size()) == data);
+
+    SECTION("wrong size") {
+        REQUIRE_THROWS_AS(osmium::io::detail::zstd_uncompress_string(compressed.data(), compressed.size(), data.size() + 1, output), const osmium::pbf_error&);
+    }
+
+    SECTION("corrupt data") {
+        std::string corrupt{compressed};
+        corrupt[corrupt.size() / 2] ^= 0x55;
+        corrupt.resize(corrupt.size() - 2);
+        REQUIRE_THROWS_AS(osmium::io::detail::zstd_uncompress_string(corrupt.data(), corrupt.size(), data.size(), output), const osmium::pbf_error&);
+    }
+}
+
+TEST_CASE("Uncompress empty zstd PBF blob data") {
+    const std::string compressed = osmium::io::detail::zstd_compress(std::string{});
+
+    std::string output{"xyz"};
+    const auto view = osmium::io::detail::zstd_uncompress_string(compressed.data(), compressed.size(), 0, output);
+    REQUIRE(view.size() == 0);
+    REQUIRE(output.empty());
+}
+#endif
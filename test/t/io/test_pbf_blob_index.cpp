@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <vector>
+
+// The test files have 20000 nodes (three blobs), 10 ways and 10 relations.
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& filename, const osmium::io::blob_selection& selection) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::Reader reader{filename, selection};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+static void check_index(const osmium::io::PBFBlobIndex& index) {
+    REQUIRE(index.size() == 5);
+
+    std::vector<osmium::io::PBFBlobIndex::entry> entries{index.begin(), index.end()};
+    REQUIRE(entries[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(entries[0].min_id == 1);
+    REQUIRE(entries[0].max_id == 8000);
+    REQUIRE(entries[1].types == osmium::osm_entity_bits::node);
+    REQUIRE(entries[1].min_id == 8001);
+    REQUIRE(entries[1].max_id == 16000);
+    REQUIRE(entries[2].types == osmium::osm_entity_bits::node);
+    REQUIRE(entries[2].min_id == 16001);
+    REQUIRE(entries[2].max_id == 20000);
+    REQUIRE(entries[3].types == osmium::osm_entity_bits::way);
+    REQUIRE(entries[3].min_id == 1);
+    REQUIRE(entries[3].max_id == 10);
+    REQUIRE(entries[4].types == osmium::osm_entity_bits::relation);
+
+    REQUIRE(entries[0].offset > 0);
+    for (std::size_t i = 1; i < entries.size(); ++i) {
+        REQUIRE(entries[i].offset == entries[i - 1].offset + entries[i - 1].size);
+    }
+    REQUIRE(entries[4].offset + entries[4].size == index.file_size());
+}
+
+TEST_CASE("Create PBF blob index from file with index data") {
+    write_test_file("test-pbf-blob-index.osm.pbf", "pbf,pbf_add_index_data=true", 20000, 10, 10);
+    const osmium::io::PBFBlobIndex index{"test-pbf-blob-index.osm.pbf"};
+    check_index(index);
+}
+
+TEST_CASE("Create PBF blob index from file without index data") {
+    write_test_file("test-pbf-blob-index-noidx.osm.pbf", "pbf", 20000, 10, 10);
+    const osmium::io::PBFBlobIndex index{"test-pbf-blob-index-noidx.osm.pbf"};
+    check_index(index);
+}
+
+TEST_CASE("Write and read PBF blob index sidecar file") {
+    const std::string filename{"test-pbf-blob-index-sidecar.osm.pbf"};
+    write_test_file(filename, "pbf,pbf_add_index_data=true", 20000, 10, 10);
+    const osmium::io::PBFBlobIndex index{filename};
+
+    const std::string sidecar{osmium::io::PBFBlobIndex::sidecar_filename(filename)};
+    index.write(sidecar, osmium::io::overwrite::allow);
+
+    const auto index2 = osmium::io::PBFBlobIndex::read(sidecar);
+    REQUIRE(index2.file_size() == index.file_size());
+    check_index(index2);
+
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::read(filename), const osmium::io_error&);
+}
+
+TEST_CASE("Read selected blobs from PBF file using blob index") {
+    const std::string filename{"test-pbf-blob-index-select.osm.pbf"};
+    write_test_file(filename, "pbf,pbf_add_index_data=true", 20000, 10, 10);
+    const osmium::io::PBFBlobIndex index{filename};
+
+    SECTION("all blobs") {
+        REQUIRE(read_ids(filename, osmium::io::blob_selection{}).size() == 20020);
+    }
+
+    SECTION("no blobs") {
+        const auto selection = index.select(osmium::osm_entity_bits::changeset);
+        REQUIRE(selection.empty());
+        REQUIRE(read_ids(filename, selection).empty());
+    }
+
+    SECTION("relations") {
+        const auto ids = read_ids(filename, index.select(osmium::osm_entity_bits::relation));
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+    }
+
+    SECTION("nodes in ID range") {
+        const auto ids = read_ids(filename, index.select(osmium::osm_entity_bits::node, 9000, 17000));
+        REQUIRE(ids.size() == 12000);
+        REQUIRE(ids.front() == 8001);
+        REQUIRE(ids.back() == 20000);
+    }
+
+    SECTION("from compressed file") {
+        const std::string gzfilename{"test-pbf-blob-index-select.osm.pbf.gz"};
+        write_test_file(gzfilename, "pbf.gz,pbf_add_index_data=true", 20000, 10, 10);
+        const auto ids = read_ids(gzfilename, index.select(osmium::osm_entity_bits::node, 9000, 10000));
+        REQUIRE(ids.size() == 8000);
+        REQUIRE(ids.front() == 8001);
+        REQUIRE(ids.back() == 16000);
+    }
+}
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/pbf_raw_blob.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+static std::vector<std::pair<osmium::item_type, osmium::object_id_type>> read_objects(const std::string& filename) {
+    std::vector<std::pair<osmium::item_type, osmium::object_id_type>> objects;
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            objects.emplace_back(object.type(), object.id());
+        }
+    }
+    reader.close();
+    return objects;
+}
+
+// The test files have 20000 nodes (three blobs), 10 ways and 10 relations.
+static osmium::io::Header test_header() {
+    osmium::io::Header header;
+    header.set("generator", "test_pbf_raw_blob");
+    return header;
+}
+
+TEST_CASE("Read raw blobs from PBF file") {
+    write_test_file("test-pbf-raw-blob-read.osm.pbf", "pbf,pbf_add_index_data=true", 20000, 10, 10, test_header());
+
+    osmium::io::PBFRawBlobReader reader{"test-pbf-raw-blob-read.osm.pbf"};
+    REQUIRE(reader.header().get("generator") == "test_pbf_raw_blob");
+
+    std::vector<osmium::io::pbf_raw_blob> blobs;
+    osmium::io::pbf_raw_blob blob;
+    while (reader.read(blob)) {
+        blobs.push_back(blob);
+    }
+    REQUIRE_FALSE(reader.read(blob));
+    reader.close();
+
+    REQUIRE(blobs.size() == 5);
+    REQUIRE(blobs[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(blobs[0].min_id == 1);
+    REQUIRE(blobs[0].max_id == 8000);
+    REQUIRE(blobs[2].types == osmium::osm_entity_bits::node);
+    REQUIRE(blobs[2].max_id == 20000);
+    REQUIRE(blobs[3].types == osmium::osm_entity_bits::way);
+    REQUIRE(blobs[4].types == osmium::osm_entity_bits::relation);
+
+    SECTION("blob sizes add up to file size") {
+        const osmium::io::PBFBlobIndex index{"test-pbf-raw-blob-read.osm.pbf"};
+        std::size_t n = 0;
+        for (const auto& e : index) {
+            REQUIRE(blobs[n].data.size() == e.size);
+            ++n;
+        }
+    }
+
+    SECTION("decode blob") {
+        const auto buffer = osmium::io::decode_raw_blob(blobs[3]);
+        std::vector<osmium::object_id_type> ids;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.type() == osmium::item_type::way);
+            ids.push_back(object.id());
+        }
+        REQUIRE(ids == (std::vector<osmium::object_id_type>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}));
+    }
+
+    SECTION("decode only some types") {
+        const auto buffer = osmium::io::decode_raw_blob(blobs[3], osmium::osm_entity_bits::node);
+        REQUIRE(buffer.select<osmium::OSMObject>().empty());
+    }
+}
+
+TEST_CASE("Raw blob types are not known without index data") {
+    write_test_file("test-pbf-raw-blob-noidx.osm.pbf", "pbf", 20000, 10, 10, test_header());
+
+    osmium::io::PBFRawBlobReader reader{"test-pbf-raw-blob-noidx.osm.pbf"};
+    osmium::io::pbf_raw_blob blob;
+    REQUIRE(reader.read(blob));
+    REQUIRE(blob.types == osmium::osm_entity_bits::nothing);
+    REQUIRE(osmium::io::decode_raw_blob(blob).select<osmium::Node>().size() == 8000);
+}
+
+TEST_CASE("Copy PBF file using raw blobs") {
+    write_test_file("test-pbf-raw-blob-copy.osm.pbf", "pbf,pbf_add_index_data=true", 20000, 10, 10, test_header());
+    const auto expected = read_objects("test-pbf-raw-blob-copy.osm.pbf");
+
+    osmium::io::PBFRawBlobReader reader{"test-pbf-raw-blob-copy.osm.pbf"};
+
+    SECTION("all blobs") {
+        osmium::io::Writer writer{"test-pbf-raw-blob-out.osm.pbf", reader.header(), osmium::io::overwrite::allow};
+        osmium::io::pbf_raw_blob blob;
+        while (reader.read(blob)) {
+            writer.write_raw_blob(std::move(blob.data));
+        }
+        writer.close();
+
+        REQUIRE(read_objects("test-pbf-raw-blob-out.osm.pbf") == expected);
+    }
+
+    SECTION("some blobs mixed with normal objects") {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+        osmium::io::Writer writer{"test-pbf-raw-blob-out.osm.pbf", reader.header(), osmium::io::overwrite::allow};
+        osmium::io::pbf_raw_blob blob;
+        while (reader.read(blob)) {
+            if (blob.types & osmium::osm_entity_bits::node) {
+                writer.write_raw_blob(std::move(blob.data));
+            }
+        }
+
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(buffer, _id(20), _nodes({1, 2}));
+        writer(std::move(buffer));
+
+        osmium::memory::Buffer buffer2{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_relation(buffer2, _id(30), _member(osmium::item_type::node, 1, ""));
+        writer(buffer2.get<osmium::memory::Item>(0));
+        writer.close();
+
+        const auto objects = read_objects("test-pbf-raw-blob-out.osm.pbf");
+        REQUIRE(objects.size() == 20002);
+        REQUIRE(objects[0] == std::make_pair(osmium::item_type::node, osmium::object_id_type{1}));
+        REQUIRE(objects[19999] == std::make_pair(osmium::item_type::node, osmium::object_id_type{20000}));
+        REQUIRE(objects[20000] == std::make_pair(osmium::item_type::way, osmium::object_id_type{20}));
+        REQUIRE(objects[20001] == std::make_pair(osmium::item_type::relation, osmium::object_id_type{30}));
+    }
+
+    SECTION("writing empty raw blob fails") {
+        osmium::io::Writer writer{"test-pbf-raw-blob-out.osm.pbf", reader.header(), osmium::io::overwrite::allow};
+        osmium::io::pbf_raw_blob blob;
+        REQUIRE(reader.read(blob));
+        writer.write_raw_blob(std::move(blob.data));
+        REQUIRE_THROWS_AS(writer.write_raw_blob(std::string{}), const osmium::pbf_error&);
+    }
+
+    SECTION("writing raw blobs to other formats fails") {
+        osmium::io::Writer writer{"test-pbf-raw-blob-out.osm", osmium::io::overwrite::allow};
+        osmium::io::pbf_raw_blob blob;
+        REQUIRE(reader.read(blob));
+        REQUIRE_THROWS_AS(writer.write_raw_blob(std::move(blob.data)), const osmium::io_error&);
+    }
+}
+
+TEST_CASE("Raw blob reader on invalid file") {
+    REQUIRE_THROWS_AS(osmium::io::PBFRawBlobReader{with_data_dir("t/io/data.osm")}, const osmium::pbf_error&);
+}
@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/util/file.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+// Write 20000 nodes (three blobs in PBF files).
+static osmium::io::writer_stats write_and_check_test_file(const std::string& filename) {
+    const auto stats = write_test_file(filename, "", 20000);
+
+    REQUIRE(stats.buffers_written == 1);
+    REQUIRE(stats.bytes_encoded > 0);
+    REQUIRE(stats.output_queue.push_count == stats.output_queue.pop_count);
+    REQUIRE(stats.output_queue.high_water_mark > 0);
+    REQUIRE(stats.output_queue.size == 0);
+    if (filename.find(".gz") == std::string::npos) {
+        REQUIRE(stats.bytes_encoded == osmium::file_size(filename));
+    }
+
+    return stats;
+}
+
+static osmium::io::reader_stats read_test_file(const std::string& filename) {
+    osmium::io::Reader reader{filename};
+    std::size_t count = 0;
+    uint64_t buffers = 0;
+    while (const auto buffer = reader.read()) {
+        ++buffers;
+        count += std::distance(buffer.begin(), buffer.end());
+    }
+    REQUIRE(count == 20000);
+    reader.close();
+
+    const auto stats = reader.stats();
+    REQUIRE(stats.buffers_read == buffers);
+    REQUIRE(stats.osmdata_queue.pop_count > 0);
+    REQUIRE(stats.bytes_decompressed > 0);
+
+    return stats;
+}
+
+TEST_CASE("Pipeline statistics for PBF file") {
+    write_and_check_test_file("test-pipeline-stats.osm.pbf");
+    const auto stats = read_test_file("test-pipeline-stats.osm.pbf");
+
+    REQUIRE(stats.file_size > 0);
+    REQUIRE(stats.bytes_read == stats.file_size);
+    REQUIRE(stats.blobs_decoded == 3);
+    REQUIRE(stats.blob_bytes_decompressed > stats.file_size);
+    REQUIRE(stats.blob_decode_busy > std::chrono::nanoseconds{0});
+}
+
+TEST_CASE("Pipeline statistics for compressed PBF file") {
+    write_and_check_test_file("test-pipeline-stats.osm.pbf.gz");
+    const auto stats = read_test_file("test-pipeline-stats.osm.pbf.gz");
+
+    REQUIRE(stats.blobs_decoded == 3);
+    REQUIRE(stats.read_busy > std::chrono::nanoseconds{0});
+    REQUIRE(stats.input_queue.push_count > 0);
+    REQUIRE(stats.input_queue.push_count == stats.input_queue.pop_count);
+}
+
+TEST_CASE("Pipeline statistics for XML file") {
+    const auto wstats = write_and_check_test_file("test-pipeline-stats.osm");
+    const auto stats = read_test_file("test-pipeline-stats.osm");
+
+    REQUIRE(stats.bytes_read == stats.file_size);
+    REQUIRE(stats.bytes_decompressed == wstats.bytes_encoded);
+    REQUIRE(stats.blobs_decoded == 0);
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include "test_files.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/read_filter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <string>
+#include <vector>
+
+static void write_tagged_test_file(const std::string& filename, const char* format) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(1), _location(1.0, 1.0), _tag("amenity", "bench"));
+    osmium::builder::add_node(buffer, _id(2), _version(1), _location(1.0, 2.0));
+    osmium::builder::add_node(buffer, _id(3), _version(1), _location(2.0, 1.0), _tag("highway", "bus_stop"));
+    osmium::builder::add_way(buffer, _id(10), _version(1), _nodes({1, 2}), _tag("highway", "residential"));
+    osmium::builder::add_way(buffer, _id(11), _version(1), _nodes({2, 3}), _tag("name", "Car Park"), _tag("amenity", "parking"));
+    osmium::builder::add_relation(buffer, _id(20), _version(1), _member(osmium::item_type::way, 10, ""), _tag("type", "multipolygon"), _tag("amenity", "school"));
+    osmium::builder::add_relation(buffer, _id(21), _version(1), _member(osmium::item_type::way, 11, ""), _tag("type", "route"));
+
+    write_test_buffer(std::move(buffer), filename, format);
+}
+
+template <typename... TArgs>
+static std::string read_objects(const std::string& filename, const char* format, TArgs&&... args) {
+    std::string result;
+    osmium::io::Reader reader{osmium::io::File{filename, format}, std::forward<TArgs>(args)...};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            result += osmium::item_type_to_char(object.type());
+            result += std::to_string(object.id());
+            result += ' ';
+        }
+    }
+    reader.close();
+    return result;
+}
+
+TEST_CASE("Default read_filter doesn't filter anything") {
+    const osmium::io::read_filter filter;
+    REQUIRE(filter.empty());
+    REQUIRE_FALSE(filter.applies_to(osmium::item_type::node));
+}
+
+TEST_CASE("Read files with read_filter") {
+    osmium::TagsFilter tags_filter{false};
+    tags_filter.add_rule(true, "amenity");
+
+    const std::vector<std::string> formats = {"pbf", "pbf,pbf_dense_nodes=false", "opl", "xml"};
+
+    for (const auto& format : formats) {
+        const std::string filename{"test-read-filter." + format.substr(0, format.find(','))};
+        write_tagged_test_file(filename, format.c_str());
+
+        SECTION("Without filter: " + format) {
+            REQUIRE(read_objects(filename, format.c_str()) == "n1 n2 n3 w10 w11 r20 r21 ");
+        }
+
+        SECTION("Filter on all types: " + format) {
+            const osmium::io::read_filter filter{tags_filter};
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n1 w11 r20 ");
+        }
+
+        SECTION("Filter on all types without metadata: " + format) {
+            const osmium::io::read_filter filter{tags_filter};
+            REQUIRE(read_objects(filename, format.c_str(), filter, osmium::io::read_meta::no) == "n1 w11 r20 ");
+        }
+
+        SECTION("Filter on ways only: " + format) {
+            const osmium::io::read_filter filter{tags_filter, osmium::osm_entity_bits::way};
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n1 n2 n3 w11 r20 r21 ");
+        }
+
+        SECTION("Filter with key and value: " + format) {
+            const osmium::io::read_filter filter{osmium::TagMatcher{"highway", "bus_stop"}};
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n3 ");
+        }
+
+        SECTION("Filter nodes on box: " + format) {
+            osmium::io::read_filter filter;
+            filter.set_node_box(osmium::Box{0.5, 0.5, 1.5, 2.5});
+            REQUIRE_FALSE(filter.empty());
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n1 n2 w10 w11 r20 r21 ");
+            REQUIRE(read_objects(filename, format.c_str(), filter, osmium::io::read_meta::no) == "n1 n2 w10 w11 r20 r21 ");
+        }
+
+        SECTION("Filter nodes on id set: " + format) {
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+            ids.set(2);
+            ids.set(3);
+            ids.set(10);
+            osmium::io::read_filter filter;
+            filter.set_node_ids(&ids);
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n2 n3 w10 w11 r20 r21 ");
+            REQUIRE(read_objects(filename, format.c_str(), filter, osmium::io::read_meta::no) == "n2 n3 w10 w11 r20 r21 ");
+        }
+
+        SECTION("Filter nodes on box and tags: " + format) {
+            osmium::io::read_filter filter{tags_filter, osmium::osm_entity_bits::node};
+            filter.set_node_box(osmium::Box{0.5, 0.5, 2.5, 2.5});
+            REQUIRE(read_objects(filename, format.c_str(), filter) == "n1 w10 w11 r20 r21 ");
+            REQUIRE(read_objects(filename, format.c_str(), filter, osmium::io::read_meta::no) == "n1 w10 w11 r20 r21 ");
+        }
+
+        SECTION("Filter with lambda: " + format) {
+            const osmium::io::read_filter filter{[](const char* key, const char* /*value*/) {
+                return std::string{key} == "type";
+            }, osmium::osm_entity_bits::relation};
+            REQUIRE(read_objects(filename, format.c_str(), filter, osmium::osm_entity_bits::relation) == "r20 r21 ");
+        }
+    }
+}
@@ -18,7 +18,7 @@ class MockOutputFormat : public osmium::io::detail::OutputFormat {
 
 public:
 
-    MockOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, osmium::io::detail::future_string_queue_type& output_queue, std::string fail_in) :
+    MockOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, osmium::io::detail::string_queue_type& output_queue, std::string fail_in) :
         OutputFormat(pool, output_queue),
         m_fail_in(std::move(fail_in)) {
     }
@@ -52,7 +52,7 @@ TEST_CASE("Test Writer with MockOutputFormat") {
 
     osmium::io::detail::OutputFormatFactory::instance().register_output_format(
         osmium::io::file_format::xml,
-        [&](osmium::thread::Pool& pool, const osmium::io::File& file, osmium::io::detail::future_string_queue_type& output_queue) {
+        [&](osmium::thread::Pool& pool, const osmium::io::File& file, osmium::io::detail::string_queue_type& output_queue) {
             return new MockOutputFormat{pool, file, output_queue, fail_in};
     });
 
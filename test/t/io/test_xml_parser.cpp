@@ -0,0 +1,485 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <expat.h>
+
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+static std::string summarize(const osmium::memory::Buffer& buffer) {
+    std::string out;
+
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        out += osmium::item_type_to_char(object.type());
+        out += std::to_string(object.id());
+        if (!object.visible()) {
+            out += " deleted";
+        }
+        if (object.type() == osmium::item_type::node) {
+            const auto& location = static_cast<const osmium::Node&>(object).location();
+            out += ' ';
+            out += std::to_string(location.x());
+            out += ',';
+            out += std::to_string(location.y());
+        } else if (object.type() == osmium::item_type::way) {
+            for (const auto& nr : static_cast<const osmium::Way&>(object).nodes()) {
+                out += " n";
+                out += std::to_string(nr.ref());
+            }
+        } else if (object.type() == osmium::item_type::relation) {
+            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                out += ' ';
+                out += osmium::item_type_to_char(member.type());
+                out += std::to_string(member.ref());
+                out += '@';
+                out += member.role();
+            }
+        }
+        for (const auto& tag : object.tags()) {
+            out += " [";
+            out += tag.key();
+            out += '=';
+            out += tag.value();
+            out += ']';
+        }
+        out += '\n';
+    }
+
+    for (const auto& changeset : buffer.select<osmium::Changeset>()) {
+        out += 'c';
+        out += std::to_string(changeset.id());
+        for (const auto& comment : changeset.discussion()) {
+            out += " [";
+            out += comment.text();
+            out += ']';
+        }
+        out += '\n';
+    }
+
+    return out;
+}
+
+// The built-in tokenizer is only used if it is switched on.
+static void enable_fast_xml_parser() {
+#ifdef _WIN32
+    _putenv_s("OSMIUM_USE_FAST_XML_PARSER", "yes");
+#else
+    setenv("OSMIUM_USE_FAST_XML_PARSER", "yes", 1);
+#endif
+}
+
+static std::string parse_xml(const std::vector<std::string>& chunks) {
+    enable_fast_xml_parser();
+
+    osmium::io::detail::string_queue_type input_queue{chunks.size() + 1};
+    osmium::io::detail::buffer_queue_type output_queue{100};
+    osmium::thread::Pool pool{1}; // destroyed first, it might still use the queues
+    std::promise<osmium::io::Header> header_promise;
+
+    for (const auto& chunk : chunks) {
+        osmium::io::detail::add_to_queue(input_queue, std::string{chunk});
+    }
+    osmium::io::detail::add_end_of_data_to_queue(input_queue);
+
+    osmium::io::detail::parser_arguments args = {
+        pool,
+        input_queue,
+        output_queue,
+        header_promise,
+        osmium::osm_entity_bits::all,
+        osmium::io::read_meta::yes,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr
+    };
+    osmium::io::detail::XMLParser parser{args};
+    parser.parse();
+
+    std::string result;
+    while (const auto buffer = output_queue.pop()) {
+        result += summarize(buffer);
+    }
+    return result;
+}
+
+static std::string parse_xml(const std::string& input) {
+    return parse_xml(std::vector<std::string>{input});
+}
+
+// Return the error message Expat generates for the input.
+static std::string expat_error(const std::string& input) {
+    XML_Parser parser = XML_ParserCreate(nullptr);
+    std::string message;
+    if (XML_Parse(parser, input.data(), static_cast<int>(input.size()), 1) == XML_STATUS_ERROR) {
+        message = osmium::xml_error{parser}.what();
+    }
+    XML_ParserFree(parser);
+    return message;
+}
+
+static void check_all_splits(const std::string& input, const std::string& expected) {
+    for (std::size_t n = 1; n < input.size(); ++n) {
+        REQUIRE(parse_xml(std::vector<std::string>{input.substr(0, n), input.substr(n)}) == expected);
+    }
+
+    std::vector<std::string> chunks;
+    for (const char c : input) {
+        chunks.emplace_back(1, c);
+    }
+    REQUIRE(parse_xml(chunks) == expected);
+}
+
+static const char* const osm_document =
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<!-- comment with <tags> & stuff -->\n"
+    "<?some-pi with > inside?>\n"
+    "<osm version=\"0.6\" generator = 'test'>\n"
+    "  <node id=\"1\" version=\"1\" lat=\"1.5\" lon=\"2.5\">\n"
+    "    <tag k=\"amenity\" v=\"pub\"/>\n"
+    "    <tag k='name' v=\"The &quot;Red&quot; Lion &amp; Co &lt;&gt; &apos;\"/>\n"
+    "    <tag k=\"ref\" v=\"&#65;&#x42;&#xe4;&#x20AC;&#x1F600;\"/>\n"
+    "    <tag k=\"ws\" v=\"a&#10;b\tc\nd\"/>\n"
+    "  </node>\n"
+    "  <!-- between objects -->\n"
+    "  <way id=\"2\" version=\"1\">\n"
+    "    <nd ref=\"1\"/><nd ref=\"3\" />\n"
+    "    <tag k=\"note\" v=\"x > y\"/>\n"
+    "  </way >\n"
+    "  <relation id=\"3\"><member type=\"way\" ref=\"2\" role=\"outer\"/></relation>\n"
+    "  <changeset id=\"4\" comments_count=\"1\">\n"
+    "    <discussion><comment uid=\"1\" user=\"u\" date=\"2020-01-01T00:00:00Z\">"
+    "<text>a &amp; <![CDATA[<b>]]>&#33;\nb</text></comment></discussion>\n"
+    "  </changeset>\n"
+    "</osm>\n"
+    "<!-- trailing comment -->\n";
+
+static const char* const osm_document_summary =
+    "n1 25000000,15000000 [amenity=pub] [name=The \"Red\" Lion & Co <> '] [ref=AB\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80] [ws=a\nb c d]\n"
+    "w2 n1 n3 [note=x > y]\n"
+    "r3 w2@outer\n"
+    "c4 [a & <b>!\nb]\n";
+
+TEST_CASE("Parse OSM XML document") {
+    REQUIRE(parse_xml(osm_document) == osm_document_summary);
+}
+
+TEST_CASE("Parse OSM XML document with CRLF line ends") {
+    std::string input;
+    for (const char* s = osm_document; *s; ++s) {
+        if (*s == '\n') {
+            input += '\r';
+        }
+        input += *s;
+    }
+    REQUIRE(parse_xml(input) == osm_document_summary);
+}
+
+TEST_CASE("Parse OSM XML document split into chunks") {
+    check_all_splits(osm_document, osm_document_summary);
+}
+
+TEST_CASE("Parse OSM XML document with byte order mark") {
+    check_all_splits(std::string{"\xef\xbb\xbf"} + osm_document, osm_document_summary);
+}
+
+TEST_CASE("Parse OSM XML documents needing Expat") {
+    SECTION("DOCTYPE declaration") {
+        check_all_splits("<?xml version=\"1.0\"?>\n<!DOCTYPE osm>\n<osm version=\"0.6\"><node id=\"1\"/></osm>\n",
+                         "n1 2147483647,2147483647\n");
+    }
+
+    SECTION("ISO-8859-1 encoding") {
+        check_all_splits("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n<osm version=\"0.6\"><node id=\"1\"><tag k=\"a\" v=\"\xe4\"/></node></osm>\n",
+                         "n1 2147483647,2147483647 [a=\xc3\xa4]\n");
+    }
+
+    SECTION("entity declaration") {
+        const std::string input{"<?xml version=\"1.0\"?>\n<!DOCTYPE osm [<!ENTITY a \"b\">]>\n<osm version=\"0.6\"/>\n"};
+        REQUIRE_THROWS_WITH(parse_xml(input), "XML entities are not supported");
+        REQUIRE_THROWS_WITH(parse_xml(std::vector<std::string>{input.substr(0, 30), input.substr(30)}), "XML entities are not supported");
+    }
+}
+
+TEST_CASE("Errors in OSM XML documents are reported like Expat does") {
+    const std::vector<std::string> inputs = {
+        "",
+        "  \n",
+        "<?xml version=\"1.0\"?>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"/>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">\n</way>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&foo;\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&#0;\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n</osm>\n<foo/>\n",
+        "<osm version=\"0.6\">\n</osm>\nfoo\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&amp\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&#12a;\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&a b;\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"&;\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"a<b\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><tag k=\"a\" v=\"a\"v=\"b\"/></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a &foo; b</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a &foo b</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a &#x; b</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"></node\n</osm>\n",
+        "<osm version=\"0.6\">\n<!DOCTYPE x>\n</osm>\n",
+    };
+
+    for (const auto& input : inputs) {
+        const std::string message{expat_error(input)};
+        REQUIRE_FALSE(message.empty());
+        REQUIRE_THROWS_WITH(parse_xml(input), message);
+    }
+}
+
+TEST_CASE("Malformed characters, names, and attributes are rejected like Expat does") {
+    const std::vector<std::string> inputs = {
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xff\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xc3\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xc0\xaf\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xed\xa0\x80\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xef\xbf\xbe\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\xf4\x90\x80\x80\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\x01\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"\xc3\xa4\xc3\xa4\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"\xf0\x9f\x98\x80\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a\x1f</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a\xff &amp;</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">\xc3\xa4 &foo;</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\">a ]]> b</node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"><![CDATA[a\x02]]></node>\n</osm>\n",
+        "<osm version=\"0.6\">\n<!-- a\xfe -->\n</osm>\n",
+        "<osm version=\"0.6\">\n<!-- a -- b -->\n</osm>\n",
+        "<osm version=\"0.6\">\n<!-- a --->\n</osm>\n",
+        "<osm version=\"0.6\">\n<? a?>\n</osm>\n",
+        "<osm version=\"0.6\">\n<?xml a?>\n</osm>\n",
+        "<osm version=\"0.6\">\n<?XmL a?>\n</osm>\n",
+        "<osm version=\"0.6\">\n<?p\xff a?>\n</osm>\n",
+        "<osm version=\"0.6\">\n<?p a\x03?>\n</osm>\n",
+        "<osm version=\"0.6\">\n<1node id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<-node id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node! id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<n\xc3\x97 id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<\xc3\x97 id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<n\xff id=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node 1d=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node i\"d=\"1\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"></node!>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\"></node\x01>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node/ >\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" / >\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" id=\"2\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" user=\"a\" id=\"2\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" id=\"2\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" id=\"\xff\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"&foo;\" id=\"2\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"1\" id=\"&foo;\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"&foo;\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"&#0;\" lat=1/>\n</osm>\n",
+        "<osm version=\"0.6\">\n<node id=\"&#99999999999;\"/>\n</osm>\n",
+        "<osm version=\"0.6\">\n</osm>\n\xff",
+        "<osm version=\"0.6\">\n</osm>\n\xc3\xa4",
+        "<osm version=\"0.6\">\n</osm>\n<!-- a -- b -->",
+    };
+
+    for (const auto& input : inputs) {
+        const std::string message{expat_error(input)};
+        REQUIRE_FALSE(message.empty());
+        REQUIRE_THROWS_WITH(parse_xml(input), message);
+        const auto n = input.size() / 2;
+        REQUIRE_THROWS_WITH(parse_xml(std::vector<std::string>{input.substr(0, n), input.substr(n)}), message);
+    }
+}
+
+TEST_CASE("Valid characters and names are accepted like Expat does") {
+    const std::string input{"<osm version=\"0.6\">\n"
+                            "<node id=\"1\" user=\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\x7f\"/>\n"
+                            "<node id=\"2\">\xef\xbb\xbf a>b <!-- - --><?pi \xc3\xa4?></node>\n"
+                            "<n\xc3\xa4 \xc3\xa4=\"1\"/><_x:y.z-1 a.b-c:d=\"1\"/>\n"
+                            "</osm>\n"};
+    REQUIRE(expat_error(input).empty());
+    REQUIRE(parse_xml(input) == "n1 2147483647,2147483647\nn2 2147483647,2147483647\n");
+}
+
+TEST_CASE("Line numbers in XML errors are counted across chunks") {
+    const std::string input{"<osm version=\"0.6\">\n<node id=\"1\"/>\n<node id=\"2\"/>\n</way>\n"};
+    const std::string message{expat_error(input)};
+    for (std::size_t n = 1; n < input.size(); ++n) {
+        REQUIRE_THROWS_WITH(parse_xml(std::vector<std::string>{input.substr(0, n), input.substr(n)}), message);
+    }
+}
+
+static std::vector<std::string> split_input(const std::string& input, const std::size_t size) {
+    std::vector<std::string> chunks;
+    for (std::size_t pos = 0; pos < input.size(); pos += size) {
+        chunks.push_back(input.substr(pos, size));
+    }
+    return chunks;
+}
+
+// Create an OSM XML document with count nodes and ways large enough to be
+// parsed in several chunks. If change is set it is an OSM change file with
+// alternating create, modify, and delete sections. The summary of the
+// expected result is returned in summary.
+static std::string create_large_document(const int count, const bool change, std::string& summary) {
+    static const char* const sections[] = {"create", "modify", "delete"};
+
+    std::string input{"<?xml version='1.0' encoding='UTF-8'?>\n"};
+    input += change ? "<osmChange version=\"0.6\">\n" : "<osm version=\"0.6\">\n<bounds minlat=\"0\" minlon=\"0\" maxlat=\"1\" maxlon=\"1\"/>\n";
+
+    for (int id = 1; id <= count; ++id) {
+        const char* section = sections[(id / 500) % 3];
+        if (change && (id == 1 || id % 500 == 0)) {
+            if (id != 1) {
+                input += "  </";
+                input += sections[(id / 500 + 2) % 3];
+                input += ">\n";
+            }
+            input += "  <";
+            input += section;
+            input += ">\n";
+        }
+        if (id % 1000 == 0) {
+            input += "  <!-- <node id=\"0\"/> -->\n";
+        }
+
+        const std::string deleted{change && section[0] == 'd' ? " deleted" : ""};
+        const std::string num{std::to_string(id)};
+        input += "  <node id=\"" + num + "\" version=\"1\" lat=\"1.5\" lon=\"2.5\">\n";
+        input += "    <tag k=\"name\" v=\"Node &amp; " + num + "\"/>\n";
+        input += "  </node>\n";
+        summary += "n" + num + deleted + " 25000000,15000000 [name=Node & " + num + "]\n";
+
+        input += "  <way id=\"" + num + "\" version=\"1\"><nd ref=\"" + num + "\"/></way>\n";
+        summary += "w" + num + deleted + " n" + num + "\n";
+    }
+
+    if (change) {
+        input += "  </";
+        input += sections[(count / 500) % 3];
+        input += ">\n</osmChange>\n";
+    } else {
+        input += "</osm>\n";
+    }
+
+    return input;
+}
+
+TEST_CASE("Parse large OSM XML document in chunks") {
+    std::string summary;
+    const std::string input{create_large_document(30000, false, summary)};
+    REQUIRE(input.size() > 3 * osmium::io::detail::XMLParser::min_chunk_size);
+
+    REQUIRE(parse_xml(split_input(input, 64 * 1024)) == summary);
+    REQUIRE(parse_xml(split_input(input, 999999)) == summary);
+}
+
+TEST_CASE("Parse large OSM XML document in small pieces") {
+    std::string summary;
+    const std::string input{create_large_document(30000, false, summary)};
+
+    REQUIRE(parse_xml(split_input(input, 1000)) == summary);
+}
+
+TEST_CASE("Parse OSM XML document with large header without using the thread pool") {
+    std::string input{"<osm version=\"0.6\">\n"};
+    while (input.size() <= osmium::io::detail::XMLParser::max_header_size) {
+        input += "  <foo a=\"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\"/>\n";
+    }
+    input += "  <node id=\"1\"/>\n</osm>\n";
+
+    REQUIRE(parse_xml(split_input(input, 64 * 1024)) == "n1 2147483647,2147483647\n");
+}
+
+TEST_CASE("Parse large OSM change file in chunks") {
+    std::string summary;
+    const std::string input{create_large_document(30000, true, summary)};
+    REQUIRE(input.size() > 3 * osmium::io::detail::XMLParser::min_chunk_size);
+
+    REQUIRE(parse_xml(split_input(input, 64 * 1024)) == summary);
+}
+
+TEST_CASE("Errors in large OSM XML documents are reported like Expat does") {
+    std::string summary;
+    std::string input{create_large_document(30000, false, summary)};
+
+    SECTION("truncated document") {
+        input.resize(input.size() - 20);
+    }
+
+    SECTION("mismatched tag") {
+        const auto pos = input.find("</node>", input.size() / 2);
+        input.replace(pos, 7, "</way>");
+    }
+
+    SECTION("invalid UTF-8") {
+        const auto pos = input.find("Node &amp; ", input.size() / 2);
+        input[pos + 1] = '\xff';
+    }
+
+    SECTION("duplicate attribute") {
+        const auto pos = input.find("<nd ref=", input.size() / 2);
+        input.replace(pos, 3, "<nd ref=\"1\"");
+    }
+
+    SECTION("junk after document element") {
+        for (int i = 0; i < 100000; ++i) {
+            input += "<node id=\"1\"/>\n";
+        }
+    }
+
+    const std::string message{expat_error(input)};
+    REQUIRE_FALSE(message.empty());
+    REQUIRE_THROWS_WITH(parse_xml(split_input(input, 64 * 1024)), message);
+}
+
+TEST_CASE("Find split points in OSM XML data") {
+    using osmium::io::detail::xml_find_split_point;
+
+    const auto find = [](const std::string& data, const std::size_t target) -> long {
+        const char* const split = xml_find_split_point(data.data(), data.data() + target, data.data() + data.size());
+        return split ? split - data.data() : -1;
+    };
+
+    const std::string data{"<osm version=\"0.6\">\n  <node id=\"1\"/>\n  <way id=\"2\">\n  </way>\n  <relation id=\"3\"/>\n</osm>\n"};
+    REQUIRE(find(data, 0) == 22);
+    REQUIRE(find(data, 23) == 39);
+    REQUIRE(find(data, 40) == 63);
+    REQUIRE(find(data, 64) == -1);
+
+    REQUIRE(find("<nodes/><nd ref=\"1\"/>\n<modify>\n<node id=\"1\"/>\n", 0) == 22);
+    REQUIRE(find("<!-- <node id=\"1\"/> --><x><![CDATA[<way id=\"1\"/>]]></x><?pi <relation id=\"1\"/>?><delete>\n</delete>\n", 0) == 80);
+    REQUIRE(find("<!-- <node id=\"1\"/> --", 0) == -1);
+    REQUIRE(find("<osm>\n<node id=\"1\"/>\n", 10) == -1);
+    REQUIRE(find("<osm>\n<node", 0) == -1);
+}
+
+TEST_CASE("Continue search for split points in OSM XML data") {
+    using osmium::io::detail::xml_find_split_point;
+
+    const std::string data{"<osm>\n<!-- <node id=\"1\"/> --><x><![CDATA[<way id=\"1\"/>]]></x><?pi <relation id=\"1\"/>?>\n<node id=\"1\"/>\n"};
+    const char* const begin = data.data();
+    const char* const end = begin + data.size();
+    const char* const split = begin + data.rfind("<node");
+    REQUIRE(xml_find_split_point(begin, begin, end) == split);
+
+    for (const char* e = begin; e < split + 11; ++e) {
+        const char* resume = nullptr;
+        REQUIRE(xml_find_split_point(begin, begin, e, &resume) == nullptr);
+        REQUIRE(resume >= begin);
+        REQUIRE(resume <= e);
+        REQUIRE(xml_find_split_point(resume, begin, end) == split);
+    }
+}
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/zstd_compression.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <string>
+
+static std::string test_data(int num_lines) {
+    std::string data;
+    for (int i = 0; i < num_lines; ++i) {
+        data += "line " + std::to_string(i) + " ";
+        data.append(static_cast<std::size_t>(i % 1000), 'x');
+        data += '\n';
+    }
+    return data;
+}
+
+static std::string read_all(osmium::io::Decompressor& decomp) {
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    return all;
+}
+
+static void write_file(const std::string& filename, const std::string& data, osmium::thread::Pool& pool, std::size_t block_size) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no, pool, block_size};
+    for (std::size_t pos = 0; pos < data.size(); pos += 10000) {
+        comp.write(data.substr(pos, 10000));
+    }
+    comp.close();
+    REQUIRE(comp.file_size() == osmium::file_size(filename));
+}
+
+static std::string read_file(const std::string& filename) {
+    std::string data(osmium::file_size(filename), '\0');
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(osmium::io::detail::reliable_read(fd, &data[0], static_cast<unsigned int>(data.size())) == static_cast<int64_t>(data.size()));
+    osmium::io::detail::reliable_close(fd);
+    return data;
+}
+
+TEST_CASE("Invalid file descriptor of zstd-compressed file") {
+    REQUIRE_THROWS_AS(osmium::io::ZstdDecompressor{-1}, const std::system_error&);
+    REQUIRE_THROWS_AS(osmium::io::ZstdCompressor(-1, osmium::io::fsync::no), const std::system_error&);
+}
+
+TEST_CASE("Write and read zstd-compressed file") {
+    const int count = count_fds();
+
+    const std::string filename{"test_zstd.txt.zst"};
+    const std::string data = test_data(5000);
+    osmium::thread::Pool pool{4};
+
+    write_file(filename, data, pool, 100000);
+    REQUIRE(osmium::file_size(filename) < data.size() / 10);
+
+    SECTION("in parallel") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::ZstdDecompressor decomp{fd, pool};
+        REQUIRE(read_all(decomp) == data);
+        REQUIRE(decomp.offset() == osmium::file_size(filename));
+    }
+
+    SECTION("falling back to sequential decompression") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        osmium::io::ZstdDecompressor decomp{fd, pool, 100};
+        REQUIRE(read_all(decomp) == data);
+    }
+
+    SECTION("from buffer") {
+        const std::string compressed = read_file(filename);
+        osmium::io::ZstdBufferDecompressor decomp{compressed.data(), compressed.size()};
+        REQUIRE(read_all(decomp) == data);
+    }
+
+    SECTION("through compression factory") {
+        const int fd = osmium::io::detail::open_for_reading(filename);
+        const auto decomp = osmium::io::CompressionFactory::instance().create_decompressor(osmium::io::file_compression::zstd, fd);
+        REQUIRE(read_all(*decomp) == data);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write and read empty zstd-compressed file") {
+    const std::string filename{"test_zstd_empty.txt.zst"};
+    osmium::thread::Pool pool{2};
+    write_file(filename, "", pool, 100000);
+    REQUIRE(osmium::file_size(filename) > 0);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    osmium::io::ZstdDecompressor decomp{fd, pool};
+    REQUIRE(read_all(decomp).empty());
+}
+
+TEST_CASE("Read empty file with zstd decompressor") {
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/empty_file"));
+    osmium::io::ZstdDecompressor decomp{fd};
+    REQUIRE(read_all(decomp).empty());
+}
+
+TEST_CASE("Read uncompressed file with zstd decompressor") {
+    const int count = count_fds();
+
+    const int fd = osmium::io::detail::open_for_reading(with_data_dir("t/io/data.txt"));
+    osmium::io::ZstdDecompressor decomp{fd};
+    REQUIRE_THROWS_AS(read_all(decomp), const osmium::zstd_error&);
+    decomp.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read corrupted zstd-compressed files") {
+    const int count = count_fds();
+
+    const std::string filename{"test_zstd_corrupted.txt.zst"};
+    osmium::thread::Pool pool{2};
+    write_file(filename, test_data(2000), pool, 100000);
+    std::string compressed = read_file(filename);
+
+    SECTION("truncated") {
+        compressed.resize(compressed.size() - 10);
+    }
+
+    SECTION("corrupted") {
+        compressed[compressed.size() / 2] ^= 0x55;
+    }
+
+    const int wfd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(wfd, compressed.data(), compressed.size());
+    osmium::io::detail::reliable_close(wfd);
+
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    osmium::io::ZstdDecompressor decomp{fd, pool};
+    REQUIRE_THROWS_AS(read_all(decomp), const osmium::zstd_error&);
+    decomp.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Decompress zstd frame with absurd content size in frame header") {
+    // Frame header with an 8 byte content size field claiming about
+    // 2^64 bytes, followed by one raw block with 5 bytes.
+    std::string frame{"\x28\xb5\x2f\xfd\xc0\x00\x00\xff\xff\xff\xff\xff\xff\xff\x29\x00\x00hello", 22};
+    REQUIRE(ZSTD_getFrameContentSize(frame.data(), frame.size()) == 0xffffffffffffff00ULL);
+    REQUIRE_THROWS_AS(osmium::io::detail::decompress_unit<osmium::io::detail::zstd_stream_decoder>{std::move(frame)}(), const osmium::zstd_error&);
+}
+
+TEST_CASE("Decompress zstd frame larger than output chunk") {
+    const std::string data = test_data(200000);
+    REQUIRE(data.size() > osmium::io::Decompressor::input_buffer_size);
+    std::string frame = osmium::io::detail::zstd_block_compressor{3}(data);
+    REQUIRE(osmium::io::detail::decompress_unit<osmium::io::detail::zstd_stream_decoder>{std::move(frame)}() == data);
+}
@@ -87,6 +87,42 @@ TEST_CASE("Reserve space in a growing buffer") {
     REQUIRE(buffer.written() == 1020);
 }
 
+TEST_CASE("Reset buffer for re-use") {
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::no};
+    REQUIRE(buffer.reserve_space(64) != nullptr);
+    buffer.commit();
+    REQUIRE(buffer.committed() == 64);
+
+    REQUIRE(buffer.reset_for_reuse(osmium::memory::Buffer::auto_grow::yes));
+    REQUIRE(buffer.capacity() == 128);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.written() == 0);
+    REQUIRE(buffer.reserve_space(1000) != nullptr);
+}
+
+TEST_CASE("Reset buffer with nested buffers for re-use") {
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::internal};
+    REQUIRE(buffer.reserve_space(64) != nullptr);
+    buffer.commit();
+    REQUIRE(buffer.reserve_space(128) != nullptr);
+    buffer.commit();
+    REQUIRE(buffer.has_nested_buffers());
+
+    REQUIRE(buffer.reset_for_reuse(osmium::memory::Buffer::auto_grow::internal));
+    REQUIRE_FALSE(buffer.has_nested_buffers());
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Buffers without internal memory management can not be re-used") {
+    osmium::memory::Buffer invalid_buffer;
+    REQUIRE_FALSE(invalid_buffer.reset_for_reuse(osmium::memory::Buffer::auto_grow::yes));
+
+    std::array<unsigned char, 128> data = {{0}};
+    osmium::memory::Buffer buffer{data.data(), data.size()};
+    REQUIRE_FALSE(buffer.reset_for_reuse(osmium::memory::Buffer::auto_grow::yes));
+    REQUIRE(buffer.committed() == 128);
+}
+
 TEST_CASE("Create buffer from existing data with good alignment works") {
     std::array<unsigned char, 128> data = {{0}};
 
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <osmium/thread/ordered_result_queue.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+TEST_CASE("Basic use of ordered result queue") {
+    osmium::thread::OrderedResultQueue<int> queue{3};
+    REQUIRE(queue.empty());
+    queue.push(22);
+    queue.push(23);
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.pop() == 22);
+    REQUIRE(queue.pop() == 23);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Ordered result queue returns results in order of reservation") {
+    osmium::thread::OrderedResultQueue<std::string> queue{3};
+    const auto a = queue.reserve();
+    const auto b = queue.reserve();
+    const auto c = queue.reserve();
+    REQUIRE(queue.size() == 3);
+
+    queue.set_value(c, "c");
+    queue.set_value(b, "b");
+
+    std::thread filler{[&queue, a]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        queue.set_value(a, "a");
+    }};
+
+    REQUIRE(queue.pop() == "a");
+    REQUIRE(queue.pop() == "b");
+    REQUIRE(queue.pop() == "c");
+    filler.join();
+}
+
+TEST_CASE("Statistics of ordered result queue") {
+    osmium::thread::OrderedResultQueue<int> queue{3};
+    queue.push(1);
+    queue.push(2);
+    REQUIRE(queue.pop() == 1);
+
+    auto stats = queue.stats();
+    REQUIRE(stats.max_size == 3);
+    REQUIRE(stats.size == 1);
+    REQUIRE(stats.high_water_mark == 2);
+    REQUIRE(stats.push_count == 2);
+    REQUIRE(stats.pop_count == 1);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.empty_count == 0);
+
+    const auto sequence = queue.reserve();
+    std::thread filler{[&queue, sequence]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        queue.set_value(sequence, 3);
+    }};
+    REQUIRE(queue.pop() == 2);
+    REQUIRE(queue.pop() == 3);
+    filler.join();
+
+    stats = queue.stats();
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.push_count == 3);
+    REQUIRE(stats.pop_count == 3);
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.consumer_wait > std::chrono::nanoseconds{0});
+}
+
+TEST_CASE("Ordered result queue transports exceptions") {
+    osmium::thread::OrderedResultQueue<int> queue{2};
+    queue.push_exception(std::make_exception_ptr(std::runtime_error{"error"}));
+    queue.push(1);
+    REQUIRE_THROWS_AS(queue.pop(), const std::runtime_error&);
+    REQUIRE(queue.pop() == 1);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Ordered result queue filled from thread pool") {
+    constexpr const int num_results = 10000;
+    osmium::thread::Pool pool{4};
+    osmium::thread::OrderedResultQueue<int> queue{5};
+
+    std::thread producer{[&]() {
+        for (int i = 0; i < num_results; ++i) {
+            const auto sequence = queue.reserve();
+            pool.execute([&queue, sequence, i]() {
+                queue.set_value(sequence, int{i});
+            });
+        }
+    }};
+
+    bool in_order = true;
+    for (int i = 0; i < num_results; ++i) {
+        if (queue.pop() != i) {
+            in_order = false;
+        }
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+}
@@ -2,7 +2,12 @@
 
 #include <osmium/thread/pool.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -41,7 +46,7 @@ TEST_CASE("number of threads in pool") {
 
     // outliers
     REQUIRE(osmium::thread::detail::get_pool_size(-100, 0, 16) ==  1);
-    REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 16) == 32);
+    REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 16) == 256);
 
 }
 
@@ -104,3 +109,60 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
 }
 
+
+TEST_CASE("all jobs submitted to pool are run") {
+    std::atomic<int> count{0};
+    std::vector<std::future<int>> futures;
+    {
+        osmium::thread::Pool pool{4, 2};
+        for (int i = 0; i < 1000; ++i) {
+            futures.push_back(pool.submit([&count, i]() {
+                ++count;
+                return i;
+            }));
+        }
+    }
+    REQUIRE(count == 1000);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i);
+    }
+}
+
+TEST_CASE("jobs can submit jobs to their own pool") {
+    osmium::thread::Pool pool{3};
+    auto future = pool.submit([&pool]() {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(pool.submit(test_job_with_result{}));
+        }
+        int sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        return sum;
+    });
+    REQUIRE(future.get() == 4200);
+}
+
+TEST_CASE("pool statistics") {
+    osmium::thread::Pool pool{2};
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.submit(test_job_with_result{}));
+    }
+    for (auto& f : futures) {
+        REQUIRE(f.get() == 42);
+    }
+
+    // Tasks are counted after they have run, so we might have to wait
+    // a little bit for the last ones.
+    for (int i = 0; i < 1000 && pool.stats().tasks_run < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    const auto stats = pool.stats();
+    REQUIRE(stats.num_threads == 2);
+    REQUIRE(stats.queue_size == 0);
+    REQUIRE(stats.tasks_run == 100);
+    REQUIRE(stats.tasks_stolen <= 100);
+}
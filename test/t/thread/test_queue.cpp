@@ -2,6 +2,8 @@
 
 #include <osmium/thread/queue.hpp>
 
+#include <thread>
+
 TEST_CASE("Basic use of thread-safe queue") {
     osmium::thread::Queue<int> queue;
     REQUIRE(queue.empty());
@@ -18,3 +20,24 @@ TEST_CASE("Queue can have max elements and can be named") {
     osmium::thread::Queue<int> queue{100, "Queue of max size 100"};
 }
 
+
+TEST_CASE("Push to full queue blocks until there is space") {
+    osmium::thread::Queue<int> queue{2};
+    queue.push(1);
+    queue.push(2);
+
+    std::thread producer{[&queue]() {
+        queue.push(3);
+    }};
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    producer.join();
+
+    REQUIRE(queue.size() == 2);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 3);
+}
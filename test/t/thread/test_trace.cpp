@@ -0,0 +1,97 @@
+#define OSMIUM_WITH_TRACE
+
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/trace.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/visitor.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST_CASE("Tracer records nothing if not started") {
+    auto& tracer = osmium::thread::Tracer::instance();
+    tracer.stop();
+    tracer.clear();
+    {
+        OSMIUM_TRACE_SCOPE("test");
+    }
+    REQUIRE(tracer.size() == 0);
+}
+
+TEST_CASE("Tracer records events with thread names") {
+    auto& tracer = osmium::thread::Tracer::instance();
+    tracer.clear();
+    tracer.start();
+
+    std::thread thread{[]() {
+        osmium::thread::set_thread_name("_osmium_test");
+        OSMIUM_TRACE_SCOPE_DETAIL("work", "some \"detail\"");
+    }};
+    thread.join();
+    {
+        OSMIUM_TRACE_SCOPE("main");
+    }
+    tracer.stop();
+    {
+        OSMIUM_TRACE_SCOPE("ignored");
+    }
+
+    REQUIRE(tracer.size() == 2);
+
+    std::ostringstream out;
+    tracer.write(out);
+    const std::string json = out.str();
+    REQUIRE(json.find(R"({"displayTimeUnit":"ms","traceEvents":[)") == 0);
+    REQUIRE(json.find(R"("args":{"name":"_osmium_test"})") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"work","cat":"osmium","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"("args":{"detail":"some \"detail\""})") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"main")") != std::string::npos);
+    REQUIRE(json.find("ignored") == std::string::npos);
+    REQUIRE(json.substr(json.size() - 4) == "\n]}\n");
+}
+
+TEST_CASE("Tracer records stages of the PBF pipeline") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    auto& tracer = osmium::thread::Tracer::instance();
+    tracer.clear();
+    tracer.start();
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(1.0, 1.0));
+    }
+
+    osmium::io::Writer writer{"test-trace.osm.pbf", osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    osmium::io::Reader reader{"test-trace.osm.pbf"};
+    int count = 0;
+    osmium::apply(reader, [&count](const osmium::Node&) {
+        ++count;
+    });
+    reader.close();
+    tracer.stop();
+
+    REQUIRE(count == 10000);
+
+    std::ostringstream out;
+    tracer.write(out);
+    const std::string json = out.str();
+    REQUIRE(json.find(R"({"name":"encode_primitive_block")") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"serialize_blob")") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"decode_blob")") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"decode_primitive_block")") != std::string::npos);
+    REQUIRE(json.find(R"({"name":"apply")") != std::string::npos);
+    REQUIRE(json.find(R"("args":{"name":"_osmium_pbf_in"})") != std::string::npos);
+    REQUIRE(json.find(R"("args":{"name":"_osmium_write"})") != std::string::npos);
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/thread/work_stealing_deque.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Basic use of work-stealing deque") {
+    osmium::thread::WorkStealingDeque<int> deque;
+    REQUIRE(deque.empty());
+    REQUIRE_FALSE(deque.pop());
+    REQUIRE_FALSE(deque.steal());
+
+    deque.push(std::unique_ptr<int>{new int{1}});
+    deque.push(std::unique_ptr<int>{new int{2}});
+    deque.push(std::unique_ptr<int>{new int{3}});
+    REQUIRE(deque.size() == 3);
+
+    // owner works LIFO, thieves FIFO
+    REQUIRE(*deque.pop() == 3);
+    REQUIRE(*deque.steal() == 1);
+    REQUIRE(*deque.pop() == 2);
+    REQUIRE(deque.empty());
+    REQUIRE_FALSE(deque.pop());
+}
+
+TEST_CASE("Work-stealing deque grows as needed") {
+    osmium::thread::WorkStealingDeque<int> deque{2};
+    for (int i = 0; i < 1000; ++i) {
+        deque.push(std::unique_ptr<int>{new int{i}});
+    }
+    REQUIRE(deque.size() == 1000);
+    for (int i = 0; i < 500; ++i) {
+        REQUIRE(*deque.steal() == i);
+    }
+    for (int i = 999; i >= 500; --i) {
+        REQUIRE(*deque.pop() == i);
+    }
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("Work-stealing deque destructor frees remaining elements") {
+    osmium::thread::WorkStealingDeque<std::shared_ptr<int>> deque;
+    const auto value = std::make_shared<int>(42);
+    deque.push(std::unique_ptr<std::shared_ptr<int>>{new std::shared_ptr<int>{value}});
+    REQUIRE(value.use_count() == 2);
+    {
+        osmium::thread::WorkStealingDeque<std::shared_ptr<int>> deque2;
+        deque2.push(std::unique_ptr<std::shared_ptr<int>>{new std::shared_ptr<int>{value}});
+        REQUIRE(value.use_count() == 3);
+    }
+    REQUIRE(value.use_count() == 2);
+}
+
+TEST_CASE("Every element is taken exactly once with concurrent thieves") {
+    constexpr const int num_elements = 100000;
+    constexpr const int num_thieves = 4;
+
+    osmium::thread::WorkStealingDeque<int> deque{4};
+    std::vector<std::atomic<int>> taken(num_elements);
+    for (auto& t : taken) {
+        t = 0;
+    }
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < num_thieves; ++i) {
+        thieves.emplace_back([&]() {
+            while (!done || !deque.empty()) {
+                if (const auto value = deque.steal()) {
+                    ++taken[*value];
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < num_elements; ++i) {
+        deque.push(std::unique_ptr<int>{new int{i}});
+        if (i % 3 == 0) {
+            if (const auto value = deque.pop()) {
+                ++taken[*value];
+            }
+        }
+    }
+    done = true;
+
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (const auto& t : taken) {
+        REQUIRE(t == 1);
+    }
+}
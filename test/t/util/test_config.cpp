@@ -66,6 +66,72 @@ TEST_CASE("use_pool_threads_for_pbf_parsing") {
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
 }
 
+TEST_CASE("use_mmap_for_pbf_input") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::use_mmap_for_pbf_input());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_MMAP_FOR_PBF_INPUT");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::use_mmap_for_pbf_input());
+
+    osmium::detail::env = "off";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_input());
+    osmium::detail::env = "false";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_input());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_input());
+    osmium::detail::env = "0";
+    REQUIRE_FALSE(osmium::config::use_mmap_for_pbf_input());
+
+    osmium::detail::env = "on";
+    REQUIRE(osmium::config::use_mmap_for_pbf_input());
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_mmap_for_pbf_input());
+}
+
+TEST_CASE("use_fast_xml_parser") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_fast_xml_parser());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_FAST_XML_PARSER");
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_fast_xml_parser());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_fast_xml_parser());
+}
+
+TEST_CASE("use_pool_threads_for_gzip_compression") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_pool_threads_for_gzip_compression());
+    REQUIRE(osmium::detail::name == "OSMIUM_USE_POOL_THREADS_FOR_GZIP_COMPRESSION");
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::use_pool_threads_for_gzip_compression());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::use_pool_threads_for_gzip_compression());
+}
+
+TEST_CASE("get_bool_env with default false") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    REQUIRE(osmium::detail::name == "OSMIUM_SOME_SETTING");
+    osmium::detail::env = "";
+    REQUIRE_FALSE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    osmium::detail::env = "something";
+    REQUIRE_FALSE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+
+    osmium::detail::env = "off";
+    REQUIRE_FALSE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    osmium::detail::env = "0";
+    REQUIRE_FALSE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+
+    osmium::detail::env = "on";
+    REQUIRE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    osmium::detail::env = "TRUE";
+    REQUIRE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    osmium::detail::env = "Yes";
+    REQUIRE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+    osmium::detail::env = "1";
+    REQUIRE(osmium::detail::get_bool_env("OSMIUM_SOME_SETTING", false));
+}
+
 TEST_CASE("get_max_queue_size") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::get_max_queue_size("NAME", 0) == 2);
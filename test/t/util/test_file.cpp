@@ -17,6 +17,20 @@ TEST_CASE("file_size(int) and file_offset() of known file") {
     REQUIRE_FALSE(osmium::isatty(fd));
 }
 
+TEST_CASE("file_seek() of known file") {
+    std::string file_name{with_data_dir("t/util/known_file_size")};
+    const int fd = osmium::io::detail::open_for_reading(file_name);
+    REQUIRE(fd > 0);
+    osmium::file_seek(fd, 10);
+    REQUIRE(osmium::file_offset(fd) == 10);
+    osmium::file_seek(fd, 0);
+    REQUIRE(osmium::file_offset(fd) == 0);
+}
+
+TEST_CASE("file_seek() with illegal fd should throw") {
+    REQUIRE_THROWS_AS(osmium::file_seek(-1, 0), const std::system_error&);
+}
+
 TEST_CASE("file_size(std::string) of known file") {
     std::string file_name{with_data_dir("t/util/known_file_size")};
     REQUIRE(osmium::file_size(file_name) == 22);